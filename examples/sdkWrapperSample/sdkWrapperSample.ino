@@ -213,11 +213,11 @@ void check_wakeup_reason(){
          debugI("\nsdkWrapperSample: Device is Paired and Activated for Autonomous Payments");
          //Get actions from BoT Server
          if(server->isWiFiConnected()){
-           String* actions = sdk->getActions();
+           String actions = sdk->retrieveActions();
            //If actions are present, they are in JSON String
-           if(actions != NULL){
+           if(actions.length() > 0){
              DynamicJsonBuffer jsonBuffer;
-             JsonArray& actionsArray = jsonBuffer.parseArray(*actions);
+             JsonArray& actionsArray = jsonBuffer.parseArray(actions);
              if(actionsArray.success()){
                  int actionsCount = actionsArray.size();
                  debugI("\nsdkWrapperSample :: JSON Actions array parsed successfully");
@@ -8,6 +8,9 @@
 #define REMOTE_HOST "www.google.com"
 ActionService* ActionService :: instance = NULL;
 
+//Response for payloads that can not be built, "Invalid" makes it a permanent failure
+static String invalidPayloadResponse("Invalid action payload, does not fit in the payload buffer");
+
 ActionService* ActionService :: getActionServiceInstance(){
   if(instance == NULL){
     instance = new ActionService();
@@ -23,12 +26,30 @@ ActionService :: ActionService(){
   previousActionTriggerTimeInSeconds = 0l;
   totalActionsTrigger = 0;
   totalOfflineActionsTrigger = 0;
+  acknowledgedQueueIDsIndex = 0;
+  triggerMutex = xSemaphoreCreateMutex();
+  memset(laneMetrics, 0, sizeof(laneMetrics));
 }
 
 ActionService :: ~ActionService(){
   delete timeClient;
 }
 
+void ActionService :: recordLaneLatency(const byte lane, const unsigned long latency){
+  struct LaneMetrics* metrics = &laneMetrics[(lane == ACTION_PRIORITY_HIGH)?ACTION_PRIORITY_HIGH:ACTION_PRIORITY_LOW];
+  metrics->count++;
+  metrics->totalLatency += latency;
+  if(latency > metrics->maxLatency)
+    metrics->maxLatency = latency;
+  debugD("\nActionService : recordLaneLatency: Lane %d latency: %lu ms, average: %lu ms",lane,latency,metrics->totalLatency/metrics->count);
+}
+
+const struct LaneMetrics* ActionService :: getLaneMetrics(const byte lane){
+  if(lane >= ACTION_PRIORITY_LANES)
+    return NULL;
+  return &laneMetrics[lane];
+}
+
 bool ActionService :: isInternetConnectivityAvailable(){
   Webserver* webServerInstance = Webserver::getWebserverInstance(false);
   if(webServerInstance->isServerAvailable()){
@@ -41,6 +62,50 @@ bool ActionService :: isInternetConnectivityAvailable(){
  }
 }
 
+bool ActionService :: isActionAcknowledged(const int httpCode, const String& response, const char* qID){
+  //Only a 200 response is decoded, the response is then the "bot" value of the JWT payload,
+  //which BoT Service sets to OK for an accepted action
+  if(httpCode != HTTP_CODE_OK)
+    return false;
+  if(response.equals("OK"))
+    return true;
+
+  //A JSON object in place of OK has to echo the queueID that was sent, anything else is not taken as
+  //acknowledged and the retry goes with the same queueID
+  if(!response.startsWith("{"))
+    return false;
+  DynamicJsonBuffer jsonBuffer;
+  JsonObject& body = jsonBuffer.parseObject(response);
+  if(!body.success())
+    return false;
+  const char* ackQueueID = body["queueID"];
+  if(body.containsKey("bot"))
+    ackQueueID = body["bot"]["queueID"];
+  return (ackQueueID == NULL || strcmp(ackQueueID, qID) == 0);
+}
+
+bool ActionService :: isQueueIDInFlight(const char* qID){
+  for (std::vector<String>::iterator i = inFlightQueueIDs.begin() ; i != inFlightQueueIDs.end(); ++i){
+    if(i->equals(qID))
+      return true;
+  }
+  return false;
+}
+
+bool ActionService :: isQueueIDAcknowledged(const char* qID){
+  for (int i = 0; i < ACKNOWLEDGED_QUEUE_IDS_MAX; i++){
+    if(acknowledgedQueueIDs[i].equals(qID))
+      return true;
+  }
+  return false;
+}
+
+void ActionService :: markQueueIDAcknowledged(const char* qID){
+  //Small ring of recently acknowledged queueIDs, oldest one gets overwritten
+  acknowledgedQueueIDs[acknowledgedQueueIDsIndex] = qID;
+  acknowledgedQueueIDsIndex = (acknowledgedQueueIDsIndex + 1) % ACKNOWLEDGED_QUEUE_IDS_MAX;
+}
+
 int ActionService :: countLeftOverOfflineActions(){
   int leftOverActions = 0;
   for (std::vector<struct OfflineActionMetadata>::iterator i = offlineActionsList.begin() ; i != offlineActionsList.end(); ++i){
@@ -50,35 +115,30 @@ int ActionService :: countLeftOverOfflineActions(){
   return leftOverActions;
 }
 
-String* ActionService :: postAction(const char* actionID, const char* qID, const double value){
-  //Action triggering logic goes here
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject& doc = jsonBuffer.createObject();
-  JsonObject& botData = doc.createNestedObject("bot");
-  botData["deviceID"] = store->getDeviceID();
-  botData["actionID"] = actionID;
-  botData["queueID"] = qID;
-
-  if (store->isDeviceMultipair()) {
-    botData["alternativeID"] = store->getAlternateDeviceID();
-  }
-
-  if (value > 0.0) {
-    botData["value"] = value;
+bool ActionService :: postAction(String& response, int& httpCode, const char* actionID, const char* qID,
+                                                             const double value, const char* altID){
+  httpCode = 0;
+  //Action triggering logic goes here, payload is written straight into a stack buffer
+  char payload[ACTION_PAYLOAD_BUFFER_SIZE];
+  PayloadWriter writer(payload, sizeof(payload));
+  bool multipair = store->isDeviceMultipair();
+  if(multipair && altID == NULL)
+    altID = store->getAlternateDeviceID();
+  if(!writeActionPayload(writer, store->getDeviceID(), actionID, qID, multipair, altID, value)){
+    debugE("\nActionService : postAction: Payload of %d bytes does not fit in %d bytes or has an invalid value",
+                                                           writer.length(), sizeof(payload));
+    response = invalidPayloadResponse;
+    return false;
   }
-
-  char payload[200];
-  doc.printTo(payload);
-  jsonBuffer.clear();
   debugI("\nActionService : postAction: Minified JSON payload to trigger action: %s", payload);
-  String* postResponse = bot->post(ACTIONS_END_POINT,payload);
-  if(postResponse != NULL){
-    debugI("\nActionService : postAction: Post response %s",postResponse->c_str());
-  }
-  else {
-    debugI("\nActionService : postAction: Post response is NULL");
-  }
-  return(postResponse);
+  inFlightQueueIDs.push_back(String(qID));
+  response = bot->post(ACTIONS_END_POINT,payload,0,&httpCode);
+  inFlightQueueIDs.pop_back();
+  debugI("\nActionService : postAction: Post response %d: %s",httpCode,response.c_str());
+  if(!isActionAcknowledged(httpCode, response, qID))
+    return false;
+  markQueueIDAcknowledged(qID);
+  return true;
 }
 
 int ActionService :: getOfflineActionsCount(){
@@ -94,6 +154,102 @@ int ActionService :: getActionsTriggerCount(){
   return totalActionsTrigger;
 }
 
+std::vector <int> ActionService :: scheduleOfflineActions(){
+  std::vector <int> highLane;
+  std::vector <int> lowLane;
+  std::vector <int> schedule;
+
+  //Split pending offline actions into lanes, FIFO order is retained within each lane
+  for (int i = 0; i < offlineActionsList.size(); i++){
+    if(offlineActionsList[i].offline != 1)
+      continue;
+    if(offlineActionsList[i].priority == ACTION_PRIORITY_HIGH)
+      highLane.push_back(i);
+    else
+      lowLane.push_back(i);
+  }
+
+  //Weighted round robin between the lanes, so that a burst of low priority
+  //actions can not hold back the high priority ones
+  int h = 0, l = 0;
+  while(h < highLane.size() || l < lowLane.size()){
+    for(int w = 0; w < PRIORITY_HIGH_LANE_WEIGHT && h < highLane.size(); w++)
+      schedule.push_back(highLane[h++]);
+    for(int w = 0; w < PRIORITY_LOW_LANE_WEIGHT && l < lowLane.size(); w++)
+      schedule.push_back(lowLane[l++]);
+  }
+  debugD("\nActionService: scheduleOfflineActions: High lane: %d, Low lane: %d",highLane.size(),lowLane.size());
+  return schedule;
+}
+
+bool ActionService :: isRetryableFailure(const int httpCode, const String& response){
+  //Negative codes are HTTPClient connection errors, 408 / 429 / 5xx are transient on server side
+  if(httpCode < 0 || httpCode == HTTP_CODE_REQUEST_TIMEOUT || httpCode == HTTP_CODE_TOO_MANY_REQUESTS ||
+     httpCode >= HTTP_CODE_INTERNAL_SERVER_ERROR)
+    return true;
+  //Rest of 4xx codes will fail the same way on every retry
+  if(httpCode >= HTTP_CODE_BAD_REQUEST)
+    return false;
+
+  //Server rejected the action itself, retrying will not help
+  if(response.indexOf("not found") != -1 || response.indexOf("Not Found") != -1 ||
+     response.indexOf("Invalid") != -1 || response.indexOf("invalid") != -1)
+    return false;
+
+  //WiFi / TLS / unexpected body, treat as transient
+  return true;
+}
+
+unsigned long ActionService :: getRetryDelay(const byte attempts){
+  //Exponential backoff capped to OFFLINE_RETRY_MAX_SECONDS
+  unsigned long delaySeconds = OFFLINE_RETRY_MAX_SECONDS;
+  if(attempts > 0 && attempts <= 16){
+    delaySeconds = (unsigned long)OFFLINE_RETRY_BASE_SECONDS << (attempts - 1);
+    if(delaySeconds > OFFLINE_RETRY_MAX_SECONDS)
+      delaySeconds = OFFLINE_RETRY_MAX_SECONDS;
+  }
+  //Equal jitter, half fixed and half random, to spread out retries from many devices
+  unsigned long halfDelay = delaySeconds / 2;
+  return halfDelay + (esp_random() % (halfDelay + 1));
+}
+
+void ActionService :: handleOfflineActionFailure(struct OfflineActionMetadata* action, const String& response,
+                                                          const int httpCode, const unsigned long now){
+  const char* reason = (response.length() > 0)?response.c_str():"No response from BoT Service";
+  action->attempts++;
+
+  if(!isRetryableFailure(httpCode, response)){
+    debugE("\nActionService: handleOfflineActionFailure: Offline Action - %s failed permanently with message - %s", action->actionID, reason);
+  }
+  else if(action->attempts >= OFFLINE_RETRY_MAX_ATTEMPTS){
+    debugE("\nActionService: handleOfflineActionFailure: Offline Action - %s exhausted %d attempts, last message - %s", action->actionID, action->attempts, reason);
+  }
+  else {
+    action->nextAttemptTime = now + getRetryDelay(action->attempts);
+    debugW("\nActionService: handleOfflineActionFailure: Offline Action - %s failed with message - %s, attempt %d, next attempt at %lu",
+                           action->actionID, reason, action->attempts, action->nextAttemptTime);
+    return;
+  }
+
+  //Move the action out of the offline queue so that it does not block others
+  if(store->saveDeadLetterAction(action, reason)){
+    action->offline = 0;
+  }
+  else {
+    debugE("\nActionService: handleOfflineActionFailure: Failed to move Offline Action - %s to dead letter store", action->actionID);
+  }
+}
+
+void ActionService :: processOfflineActions(){
+  if(isInternetConnectivityAvailable() && store->offlineActionsExist()){
+    debugI("\nActionService :: processOfflineActions: Internet Connectivity Available and There are some offline actions need to be processed");
+    triggerOfflineActions();
+  }
+  else {
+    debugW("\nActionService :: processOfflineActions: No Internet Connectivity or There are no offline actions to handle");
+  }
+}
+
 void ActionService :: triggerOfflineActions(){
   debugI("\nActionService: triggerOfflineActions: Processing pending offline actions");
 
@@ -101,25 +257,46 @@ void ActionService :: triggerOfflineActions(){
 
   if(offlineActionsCount > 0){
     debugI("\nActionService: triggerOfflineActions: Number of offline actions in list: %d",offlineActionsCount);
-    //For each of offline action in offlineActionsList,
+    unsigned long drainStartTime = millis();
+    int drainedActions = totalOfflineActionsTrigger;
+    //Persisted backoff times are epoch seconds, without network time they can not be compared
+    if(!timeClient->update() && !timeClient->forceUpdate()){
+      debugW("\nActionService: triggerOfflineActions: Unable to get time from network, offline actions left for the next drain");
+      return;
+    }
+    unsigned long now = timeClient->getEpochTime();
+    std::vector <int> schedule = scheduleOfflineActions();
+    //For each of offline action in the lane schedule,
     //check internet connectivity and trigger pending actions
-    for (std::vector<struct OfflineActionMetadata>::iterator i = offlineActionsList.begin() ; i != offlineActionsList.end(); ++i){
+    for (std::vector<int>::iterator s = schedule.begin() ; s != schedule.end(); ++s){
+      std::vector<struct OfflineActionMetadata>::iterator i = offlineActionsList.begin() + (*s);
       if(isInternetConnectivityAvailable()){
-        if(i->offline == 1){
+        if(i->offline == 1 && (isQueueIDAcknowledged(i->queueID) || isQueueIDInFlight(i->queueID))){
+          //Already accepted by BoT Service or being sent right now, sending again would double bill
+          debugW("\nActionService: triggerOfflineActions: Action with actionID - %s and queueID - %s already acknowledged, skipping", i->actionID,i->queueID);
+          if(isQueueIDAcknowledged(i->queueID))
+            i->offline = 0;
+        }
+        else if(i->offline == 1 && i->nextAttemptTime > now){
+          debugD("\nActionService: triggerOfflineActions: Action with actionID - %s backing off until %lu", i->actionID,i->nextAttemptTime);
+        }
+        else if(i->offline == 1){
           debugD("\nActionService: triggerOfflineActions: Triggerring pending action with actionID - %s and timestamp - %lu", i->actionID,i->timestamp);
 
           //Trigger Offline Action
-          String* offlineResponse = postAction(i->actionID,i->queueID,i->value);
+          String offlineResponse;
+          int httpCode = 0;
 
           //Post successful,
           //Turnoff offline flag for the action
-          if(offlineResponse != NULL && offlineResponse->indexOf("OK") != -1){
+          if(postAction(offlineResponse,httpCode,i->actionID,i->queueID,i->value,i->alternateID)){
             i->offline = 0;
             totalOfflineActionsTrigger++;
+            recordLaneLatency(i->priority, millis() - drainStartTime);
             debugI("\nActionService: triggerOfflineActions: Offline Action with actionID: %s for timestamp: %lu trigger successful",i->actionID,i->timestamp);
           }
           else {
-            debugE("\nActionService: triggerOfflineActions: Offline Action - %s failed with message - %s", i->actionID,offlineResponse->c_str());
+            handleOfflineActionFailure(&(*i), offlineResponse, httpCode, now);
           }
         }
       }
@@ -134,6 +311,8 @@ void ActionService :: triggerOfflineActions(){
     //There are chances of losing internet connectivity / failure of triggering any action
     //Check whether there are any left over pending offline actions in offlineActionsList
     int leftOverOfflineActions = countLeftOverOfflineActions();
+    EventService :: getEventServiceInstance()->publish("drain", "{\"triggered\":%d,\"left\":%d}",
+                             totalOfflineActionsTrigger - drainedActions, leftOverOfflineActions);
     debugI("\nActionService: triggerOfflineActions: Number of left over offline actions in offlineActionsList: %d", leftOverOfflineActions);
     //Write back such left over offline actions into storage
     if(leftOverOfflineActions > 0){
@@ -160,8 +339,7 @@ void ActionService :: triggerOfflineActions(){
   }
 }
 
-String* ActionService :: triggerOnlineAction(const char* actionID,const char* value){
-  String* postResponse = NULL;
+byte ActionService :: triggerOnlineAction(String& response,const char* actionID,const char* value,const byte priority,const char* altID){
   debugI("\nActionService: triggerOnlineAction: Preparing to trigger action with actionID: %s",actionID);
 
   //Check for availability of internet connectivity
@@ -175,20 +353,28 @@ String* ActionService :: triggerOnlineAction(const char* actionID,const char* va
 
     debugD("\nActionService: triggerOnlineAction: Internet connectivity available, triggering the action with actionID: %s",actionID);
 
+    //Keep own copy of queueID, it gets reused if the action needs to be retried
+    char queueID[QUEUE_ID_LENGTH+1];
+    strncpy(queueID,store->generateUuid4(),QUEUE_ID_LENGTH);
+    queueID[QUEUE_ID_LENGTH] = '\0';
+
     //Trigger Action
-    postResponse = postAction(actionID,store->generateUuid4(),String(value).toDouble());
+    int httpCode = 0;
+    bool acknowledged = postAction(response,httpCode,actionID,queueID,String(value).toDouble(),altID);
 
     //Check trigger action result
-    if(postResponse != NULL && postResponse->indexOf("OK") != -1){
+    if(acknowledged){
       totalActionsTrigger++;
       debugI("\nActionService: triggerOnlineAction: Action with actionID: %s for timestamp: %lu trigger successful",actionID,previousActionTriggerTimeInSeconds);
     }
     else {
-      debugE("\nActionService: triggerOnlineAction: Action with actionID: %s failed with response: %s",actionID,postResponse->c_str());
-      //Trigger action failed, add as an offline action if there is no internet
-      if(!isInternetConnectivityAvailable()) {
-        debugW("\nActionService: triggerOnlineAction: adding failed action: %s to offline actions since there is no internet available",actionID);
-        if(store->saveOfflineAction(actionID,value,previousActionTriggerTimeInSeconds)){
+      debugE("\nActionService: triggerOnlineAction: Action with actionID: %s failed with status %d, response: %s",actionID,
+                                  httpCode,response.c_str());
+      //Trigger action failed, add as an offline action if there is no internet or the failure is transient,
+      //response might have been lost after the server accepted it, hence the same queueID is retained
+      if(!isInternetConnectivityAvailable() || isRetryableFailure(httpCode, response)) {
+        debugW("\nActionService: triggerOnlineAction: adding failed action: %s with queueID: %s to offline actions",actionID,queueID);
+        if(store->saveOfflineAction(actionID,value,previousActionTriggerTimeInSeconds,priority,queueID,altID)){
           debugI("\nActionService: triggerOnlineAction: Action - %s associated with timestamp - %lu saved as Offline Action",actionID,previousActionTriggerTimeInSeconds);
         }
         else {
@@ -196,21 +382,24 @@ String* ActionService :: triggerOnlineAction(const char* actionID,const char* va
         }
       }
     }
-    return postResponse;
+    return acknowledged?ACTION_RESULT_SUCCEEDED:ACTION_RESULT_FAILED;
   }
   else {
     debugI("\nActionService: triggerOnlineAction: Internet connectivity not available, saving the action onto storage");
-    if(store->saveOfflineAction(actionID,value,previousActionTriggerTimeInSeconds)){
+    if(store->saveOfflineAction(actionID,value,previousActionTriggerTimeInSeconds,priority,NULL,altID)){
       debugI("\nActionService: triggerOnlineAction: Action - %s associated with timestamp - %lu saved as Offline Action",actionID,previousActionTriggerTimeInSeconds);
     }
     else {
       debugE("\nActionService: triggerOnlineAction: Action - %s failed to be saved as Offline Action",actionID);
     }
-    return NULL;
+    return ACTION_RESULT_OFFLINE;
   }
 }
 
-String* ActionService :: triggerAction(const char* aID, const char* aVal){
+byte ActionService :: triggerAction(const char* aID, const char* aVal, const byte aPriority, const char* altID, char* message){
+  //Actions get triggered from JobService worker as well as from the sketch, one at a time
+  xSemaphoreTake(triggerMutex, portMAX_DELAY);
+  unsigned long triggerStartTime = millis();
   char* actionID = new char[strlen(aID)+1];
   strcpy(actionID,aID);
   char* value = NULL;
@@ -228,17 +417,29 @@ String* ActionService :: triggerAction(const char* aID, const char* aVal){
     store->initializeEEPROM();
     store->loadJSONConfiguration();
 
-    //Process offline actions if any
-    if(isInternetConnectivityAvailable() && store->offlineActionsExist()){
-      debugI("\nActionService :: triggerAction: Internet Connectivity Available and There are some offline actions need to be processed");
-      triggerOfflineActions();
+    const byte priority = (aPriority == ACTION_PRIORITY_DEFAULT)?store->getActionPriority(actionID):aPriority;
+    debugD("\nActionService :: triggerAction: Action %s is served through lane %d", actionID, priority);
+
+    String response;
+    byte result = ACTION_RESULT_FAILED;
+    if(priority == ACTION_PRIORITY_HIGH){
+      //High priority action goes out ahead of any pending offline actions
+      result = triggerOnlineAction(response,actionID,value,priority,altID);
+      if(result == ACTION_RESULT_SUCCEEDED)
+        recordLaneLatency(priority, millis() - triggerStartTime);
+
+      //Process offline actions if any
+      processOfflineActions();
     }
     else {
-      debugW("\nActionService :: triggerAction: No Internet Connectivity or There are no offline actions to handle");
-    }
+      //Process offline actions if any
+      processOfflineActions();
 
-    //Trigger the provided action
-    String* postResponse = triggerOnlineAction(actionID,value);
+      //Trigger the provided action
+      result = triggerOnlineAction(response,actionID,value,priority,altID);
+      if(result == ACTION_RESULT_SUCCEEDED)
+        recordLaneLatency(priority, millis() - triggerStartTime);
+    }
 
    /*
     const char* deviceID = store->getDeviceID();
@@ -270,7 +471,7 @@ String* ActionService :: triggerAction(const char* aID, const char* aVal){
     postResponse = bot->post(ACTIONS_END_POINT,payload);
   */
     //Update the trigger time for the actionID if its success
-    if((postResponse != NULL) && (postResponse->indexOf("OK") != -1)){
+    if(result == ACTION_RESULT_SUCCEEDED){
       debugI("\nActionService :: triggerAction: Action %s successful ",actionID);
       if(updateTriggeredTimeForAction(actionID)){
         debugD("\nActionService :: triggerAction: Action trigger time - %lu updated to %s",presentActionTriggerTimeInSeconds,actionID);
@@ -279,13 +480,20 @@ String* ActionService :: triggerAction(const char* aID, const char* aVal){
         debugW("\nActionService :: triggerAction: Action trigger time - %lu failed to update to %s",presentActionTriggerTimeInSeconds,actionID);
       }
     }
-    else if(postResponse == NULL){
+    else if(result == ACTION_RESULT_OFFLINE){
       debugW("\nActionService :: triggerAction: No Internet Connectivity, payment saved as offline action to storage");
     }
     else {
-      debugE("\nActionService :: triggerAction: Failed with response - %s",postResponse->c_str());
+      debugE("\nActionService :: triggerAction: Failed with response - %s",response.c_str());
     }
 
+    //Outcome is copied out while triggerMutex is held, response is gone once the next trigger runs
+    char resultMessage[ACTION_RESULT_MESSAGE_LENGTH+1];
+    getActionMessage(result, response, resultMessage);
+    if(message != NULL)
+      strcpy(message, resultMessage);
+    EventService :: getEventServiceInstance()->publishActionResult(actionID, result, resultMessage);
+
     //Save the actions present in actionsList to ACTIONS_FILE for reference
     /*if(store->saveActions(actionsList)){
       debugD("\nActionService :: triggerAction: %d actions successfully saved to file - %s",actionsList.size(),ACTIONS_FILE);
@@ -307,7 +515,72 @@ String* ActionService :: triggerAction(const char* aID, const char* aVal){
     delete value;
     debugD("\nActionService :: triggerAction: Released memory allocated for value");
   }
-  return postResponse;
+  xSemaphoreGive(triggerMutex);
+  return result;
+}
+
+String* ActionService :: triggerAction(const char* actionID, const char* value){
+  char message[ACTION_RESULT_MESSAGE_LENGTH+1];
+  byte result = triggerAction(actionID, value, ACTION_PRIORITY_DEFAULT, NULL, message);
+  //NULL when saved as offline action, BoT Service response otherwise as before
+  if(result == ACTION_RESULT_OFFLINE)
+    return NULL;
+  triggerResponse = (result == ACTION_RESULT_SUCCEEDED)?"OK":message;
+  return &triggerResponse;
+}
+
+String* ActionService :: getActions(){
+  actionsResponse = retrieveActions();
+  return &actionsResponse;
+}
+
+void ActionService :: getActionMessage(const byte result, const String& response, char* message){
+  const char* text = response.c_str();
+  if(result == ACTION_RESULT_OFFLINE)
+    text = "Action saved as Offline Action";
+  else if(result == ACTION_RESULT_SUCCEEDED)
+    text = "Action triggered successful";
+  strncpy(message, text, ACTION_RESULT_MESSAGE_LENGTH);
+  message[ACTION_RESULT_MESSAGE_LENGTH] = '\0';
+}
+
+void ActionService :: triggerActionBatch(struct ActionBatchItem* items, const int count){
+  xSemaphoreTake(triggerMutex, portMAX_DELAY);
+  debugI("\nActionService :: triggerActionBatch: Triggering batch of %d actions", count);
+
+  //Configuration, NTP and offline actions are handled once for the whole batch
+  timeClient->begin();
+  store->initializeEEPROM();
+  store->loadJSONConfiguration();
+  processOfflineActions();
+
+  for(int i = 0; i < count; i++){
+    items[i].result = ACTION_RESULT_PENDING;
+    if(items[i].priority == ACTION_PRIORITY_DEFAULT)
+      items[i].priority = store->getActionPriority(items[i].actionID);
+  }
+
+  //High priority items of the batch go out first, given order is kept within each lane
+  for(byte lane = ACTION_PRIORITY_HIGH; lane < ACTION_PRIORITY_LANES; lane++){
+    for(int i = 0; i < count; i++){
+      const byte itemLane = (items[i].priority == ACTION_PRIORITY_HIGH)?ACTION_PRIORITY_HIGH:ACTION_PRIORITY_LOW;
+      if(itemLane != lane)
+        continue;
+
+      unsigned long triggerStartTime = millis();
+      presentActionTriggerTimeInSeconds = 0;
+      String response;
+      items[i].result = triggerOnlineAction(response,items[i].actionID,items[i].value,itemLane,items[i].altID);
+      getActionMessage(items[i].result, response, items[i].message);
+      EventService :: getEventServiceInstance()->publishActionResult(items[i].actionID, items[i].result, items[i].message);
+      if(items[i].result == ACTION_RESULT_SUCCEEDED){
+        recordLaneLatency(itemLane, millis() - triggerStartTime);
+        updateTriggeredTimeForAction(items[i].actionID);
+      }
+      debugI("\nActionService :: triggerActionBatch: Item %d - %s: %s",i,items[i].actionID,items[i].message);
+    }
+  }
+  xSemaphoreGive(triggerMutex);
 }
 
 bool ActionService :: updateTriggeredTimeForAction(const char* actionID){
@@ -351,27 +624,27 @@ void ActionService :: clearActionsList(){
   }
 }
 
-String* ActionService :: getActions(){
-  String* actions = bot->get(ACTIONS_END_POINT);
+String ActionService :: retrieveActions(){
+  String actions = bot->get(ACTIONS_END_POINT);
 
-  debugD("\nActionService :: getActions: %s", actions->c_str());
+  debugD("\nActionService :: retrieveActions: %s", actions.c_str());
 
-  if(actions->indexOf("[") != -1 && actions->indexOf("]") != -1){
+  if(actions.indexOf("[") != -1 && actions.indexOf("]") != -1){
     DynamicJsonBuffer jsonBuffer;
-    JsonArray& actionsArray = jsonBuffer.parseArray(*actions);
+    JsonArray& actionsArray = jsonBuffer.parseArray(actions);
     if(actionsArray.success()){
         int actionsCount = actionsArray.size();
-        debugD("\nActionService :: getActions: JSON Actions array parsed successfully");
-        debugD("\nActionService :: getActions: Number of actions returned: %d", actionsCount);
+        debugD("\nActionService :: retrieveActions: JSON Actions array parsed successfully");
+        debugD("\nActionService :: retrieveActions: Number of actions returned: %d", actionsCount);
 
         //Clear off previous stored actions before processing new set
         if(!actionsList.empty()){
           clearActionsList();
           if(actionsList.empty()){
-            debugD("\nActionService :: getActions: Cleared contents of previous actions present in ActionsList");
+            debugD("\nActionService :: retrieveActions: Cleared contents of previous actions present in ActionsList");
           }
           else {
-            debugE("\nActionService :: getActions: Not cleared contents of previous actions present, retaining the same back");
+            debugE("\nActionService :: retrieveActions: Not cleared contents of previous actions present, retaining the same back");
             jsonBuffer.clear();
             return actions;
           }
@@ -391,25 +664,25 @@ String* ActionService :: getActions(){
            actionsList.push_back(actionItem);
         }
 
-        debugI("\nActionService :: getActions: Added %d actions returned from server into actionsList", actionsList.size());
+        debugI("\nActionService :: retrieveActions: Added %d actions returned from server into actionsList", actionsList.size());
         jsonBuffer.clear();
         return actions;
     }
     else {
-      debugE("\nActionService :: getActions: JSON Actions array parsed failed!");
-      debugW("\nActionService :: getActions: use locally stored actions, if available");
+      debugE("\nActionService :: retrieveActions: JSON Actions array parsed failed!");
+      debugW("\nActionService :: retrieveActions: use locally stored actions, if available");
       jsonBuffer.clear();
       localActionsList = store->retrieveActions();
-      debugW("\nActionService :: getActions: Local actions count: %d", localActionsList.size());
-      return NULL;
+      debugW("\nActionService :: retrieveActions: Local actions count: %d", localActionsList.size());
+      return String();
     }
   }
   else {
-    debugE("\nActionService :: getActions: Could not retrieve actions from server");
-    debugW("\nActionService :: getActions: use locally stored actions, if available");
+    debugE("\nActionService :: retrieveActions: Could not retrieve actions from server");
+    debugW("\nActionService :: retrieveActions: use locally stored actions, if available");
     localActionsList = store->retrieveActions();
-    debugW("\nActionService :: getActions: Local actions count: %d", localActionsList.size());
-    return NULL;
+    debugW("\nActionService :: retrieveActions: Local actions count: %d", localActionsList.size());
+    return String();
   }
 }
 
@@ -443,10 +716,10 @@ void ActionService :: updateActionsLastTriggeredTime(){
 
 bool ActionService :: isValidAction(const char* actionID){
   //Get fresh list of actions from server
-  String* actions = getActions();
+  String actions = retrieveActions();
 
   //Update lastTriggeredTime for actions from saved details if actions successfully retrieved from BoT Server
-  if(actions != NULL){
+  if(actions.length() > 0){
     debugD("\nActionService :: isValidAction: Actions retrieved from BoT Server, calling updateActionsLastTriggeredTime");
     updateActionsLastTriggeredTime();
   }
@@ -10,6 +10,8 @@
 #include "BoTService.h"
 #include "Webserver.h"
 #include "Storage.h"
+#include "PayloadWriter.h"
+#include <freertos/semphr.h>
 #define ACTIONS_END_POINT "/actions"
 #define MINUTE_IN_SECONDS 60
 #define HOUR_IN_SECONDS (MINUTE_IN_SECONDS * 60)
@@ -18,19 +20,34 @@
 #define MONTH_IN_SECONDS (WEEK_IN_SECONDS * 4)
 #define HALF_YEAR_IN_SECONDS (WEEK_IN_SECONDS * 26)
 #define YEAR_IN_SECONDS (WEEK_IN_SECONDS * 52)
+#define PRIORITY_HIGH_LANE_WEIGHT 4
+#define PRIORITY_LOW_LANE_WEIGHT 1
+#define OFFLINE_RETRY_MAX_ATTEMPTS 8
+#define OFFLINE_RETRY_BASE_SECONDS 30
+#define OFFLINE_RETRY_MAX_SECONDS HOUR_IN_SECONDS
+#define ACKNOWLEDGED_QUEUE_IDS_MAX 16
+#define QUEUE_ID_LENGTH 36
 
 class ActionService {
   public:
     ~ActionService();
     static ActionService* getActionServiceInstance();
+    byte triggerAction(const char* actionID, const char* value, const byte priority,
+                                     const char* altID = NULL, char* message = NULL);
+    void triggerActionBatch(struct ActionBatchItem* items, const int count);
+    String retrieveActions();
+    //Previous interface, the returned String is owned by ActionService and valid until the next call
     String* triggerAction(const char* actionID, const char* value = NULL);
     String* getActions();
     int getOfflineActionsCount();
     int getOfflineActionsTriggerCount();
     int getActionsTriggerCount();
+    const struct LaneMetrics* getLaneMetrics(const byte lane);
+    static bool isActionAcknowledged(const int httpCode, const String& response, const char* qID);
   private:
     KeyStore *store;
     BoTService *bot;
+    SemaphoreHandle_t triggerMutex;
     WiFiUDP ntpUDP;
     NTPClient *timeClient;
     unsigned long presentActionTriggerTimeInSeconds;
@@ -47,9 +64,28 @@ class ActionService {
     int countLeftOverOfflineActions();
     int totalActionsTrigger;
     int totalOfflineActionsTrigger;
+    struct LaneMetrics laneMetrics[ACTION_PRIORITY_LANES];
+    void recordLaneLatency(const byte lane, const unsigned long latency);
+    std::vector <String> inFlightQueueIDs;
+    String triggerResponse;
+    String actionsResponse;
+    String acknowledgedQueueIDs[ACKNOWLEDGED_QUEUE_IDS_MAX];
+    int acknowledgedQueueIDsIndex;
+    bool isQueueIDInFlight(const char* qID);
+    bool isQueueIDAcknowledged(const char* qID);
+    void markQueueIDAcknowledged(const char* qID);
+    std::vector <int> scheduleOfflineActions();
+    bool isRetryableFailure(const int httpCode, const String& response);
+    unsigned long getRetryDelay(const byte attempts);
+    void handleOfflineActionFailure(struct OfflineActionMetadata* action, const String& response,
+                                             const int httpCode, const unsigned long now);
+    void processOfflineActions();
     void triggerOfflineActions();
-    String* triggerOnlineAction(const char* actionID,const char* value = NULL);
-    String* postAction(const char* actionID, const char* qID, const double value);
+    byte triggerOnlineAction(String& response,const char* actionID,const char* value = NULL,
+                                         const byte priority = ACTION_PRIORITY_LOW, const char* altID = NULL);
+    bool postAction(String& response, int& httpCode, const char* actionID, const char* qID,
+                                         const double value, const char* altID);
+    void getActionMessage(const byte result, const String& response, char* message);
     ActionService();
     static ActionService* instance;
 };
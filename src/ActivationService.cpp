@@ -7,6 +7,9 @@
 
 #include "ActivationService.h"
 
+//Response for a device ID too long to fit the activation payload
+static String invalidPayloadResponse("Invalid activation payload, does not fit in the payload buffer");
+
 ActivationService :: ActivationService(){
   store = KeyStore :: getKeyStoreInstance();
   bot = BoTService :: getBoTServiceInstance();
@@ -15,39 +18,53 @@ ActivationService :: ActivationService(){
 bool ActivationService :: pollActivationStatus(){
   debugD("\nActivationService :: pollActivationStatus: Started polling BoT for activation status for the device...");
   int counter = 1;
-  String* response = NULL;
+  String response;
+  PollingPolicy policy(store->getPollingInitialInterval(), store->getPollingMaximumInterval());
   do {
     debugD("\nActivationService :: pollActivationStatus: Checking activation status, attempt %d of %d", counter,MAXIMUM_TRIES);
     response = sendActivationRequest();
-    if(response->indexOf("deviceID") != -1){
+    if(response.indexOf("deviceID") != -1){
       return true;
     }
     ++counter;
-    delay(POLLING_INTERVAL_IN_MILLISECONDS);
+    if(counter <= MAXIMUM_TRIES)
+      policy.wait();
   }while(counter <= MAXIMUM_TRIES);
 
    return false;
 }
 
-String* ActivationService :: sendActivationRequest(){
+String ActivationService :: sendActivationRequest(){
   const char* deviceID = store->getDeviceID();
 
-  DynamicJsonBuffer jsonBuffer;
-  JsonObject& doc = jsonBuffer.createObject();
-  JsonObject& botData = doc.createNestedObject("bot");
-  botData["deviceID"] = deviceID;
-
-  char payload[100];
-  doc.printTo(payload);
+  char payload[ACTIVATION_PAYLOAD_BUFFER_SIZE];
+  PayloadWriter writer(payload, sizeof(payload));
+  if(!writeActivationPayload(writer, deviceID)){
+    debugE("\nActivationService :: sendActivationRequest: Payload of %d bytes does not fit in %d bytes",
+                                                                   writer.length(), sizeof(payload));
+    return invalidPayloadResponse;
+  }
   debugD("\nActivationService :: sendActivationRequest: Minified JSON payload to send: %s", payload);
-  jsonBuffer.clear();
 
-  String* response = bot->post(ACTIVATION_END_POINT,payload);
-  debugD("\nActivationService :: sendActivationRequest: Response from bot->post: %s",response->c_str());
+  //Activation payload does not change between polls, so its signature is reused
+  String response = bot->post(ACTIVATION_END_POINT,payload,ACTIVATION_PAYLOAD_TTL_IN_MILLISECONDS);
+  debugD("\nActivationService :: sendActivationRequest: Response from bot->post: %s",response.c_str());
 
   return response;
 }
 
+bool ActivationService :: checkActivationStatus(){
+  //Single activation request without waiting, caller decides when to try again
+  store->initializeEEPROM();
+  String response = sendActivationRequest();
+  if(response.indexOf("deviceID") == -1)
+    return false;
+
+  store->setDeviceState(DEVICE_ACTIVE);
+  debugI("\nActivationService :: checkActivationStatus: Activation successful. Triggering actions enabled");
+  return true;
+}
+
 void ActivationService :: activateDevice(){
   store->initializeEEPROM();
   if(pollActivationStatus() == true){
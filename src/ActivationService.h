@@ -10,7 +10,8 @@
 #include "BoTESP32SDK.h"
 #include "Storage.h"
 #include "BoTService.h"
-#define POLLING_INTERVAL_IN_MILLISECONDS 10000
+#include "PayloadWriter.h"
+#define ACTIVATION_PAYLOAD_TTL_IN_MILLISECONDS (10*60*1000)
 #define MAXIMUM_TRIES 3
 #define ACTIVATION_END_POINT "/status"
 
@@ -18,10 +19,11 @@ class ActivationService {
   public:
     ActivationService();
     void activateDevice();
+    bool checkActivationStatus();
   private:
     KeyStore *store;
     BoTService *bot;
-    String* sendActivationRequest();
+    String sendActivationRequest();
     bool pollActivationStatus();
 };
 #endif
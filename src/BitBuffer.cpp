@@ -28,14 +28,83 @@
 namespace qrcodegen {
 
 BitBuffer::BitBuffer()
-	: std::vector<bool>() {}
+	: words(),
+	  bitLength(0) {}
+
+
+BitBuffer::BitBuffer(std::size_t capacityBits)
+	: words(),
+	  bitLength(0) {
+	reserve(capacityBits);
+}
+
+
+void BitBuffer::reserve(std::size_t capacityBits) {
+	words.reserve((capacityBits + 31) / 32);
+}
 
 
 void BitBuffer::appendBits(std::uint32_t val, int len) {
 	if (len < 0 || len > 31 || val >> len != 0)
 		throw std::domain_error("Value out of range");
-	for (int i = len - 1; i >= 0; i--)  // Append bit by bit
-		this->push_back(((val >> i) & 1) != 0);
+	if (len > 0)
+		appendWord(val, len);
+}
+
+
+void BitBuffer::appendWord(std::uint32_t val, int len) {
+	int used = static_cast<int>(bitLength & 31);
+	if (used == 0)  // Starts a new word
+		words.push_back(len == 32 ? val : val << (32 - len));
+	else {
+		int free = 32 - used;
+		if (len <= free)
+			words.back() |= val << (free - len);
+		else {  // Split across the current and a new word
+			int rest = len - free;
+			words.back() |= val >> rest;
+			words.push_back(val << (32 - rest));
+		}
+	}
+	bitLength += len;
+}
+
+
+void BitBuffer::appendData(const BitBuffer &other) {
+	std::size_t fullWords = other.bitLength / 32;
+	reserve(bitLength + other.bitLength);
+	for (std::size_t i = 0; i < fullWords; i++)
+		appendWord(other.words[i], 32);
+	int rest = static_cast<int>(other.bitLength & 31);
+	if (rest > 0)
+		appendWord(other.words[fullWords] >> (32 - rest), rest);
+}
+
+
+std::size_t BitBuffer::size() const {
+	return bitLength;
+}
+
+
+bool BitBuffer::getBit(std::size_t index) const {
+	if (index >= bitLength)
+		throw std::out_of_range("Bit index out of range");
+	return ((words[index >> 5] >> (31 - (index & 31))) & 1) != 0;
+}
+
+
+std::uint32_t BitBuffer::getWord(std::size_t index) const {
+	if (index >= words.size())
+		throw std::out_of_range("Word index out of range");
+	return words[index];
+}
+
+
+std::vector<std::uint8_t> BitBuffer::getBytes() const {
+	std::vector<std::uint8_t> result((bitLength + 7) / 8);
+	for (std::size_t i = 0; i < result.size(); i++)
+		result[i] = static_cast<std::uint8_t>(words[i >> 2] >> (24 - 8 * (i & 3)));
+	return result;
 }
 
 }
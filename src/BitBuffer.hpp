@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -31,22 +32,67 @@ namespace qrcodegen {
 
 /* 
  * An appendable sequence of bits (0s and 1s). Mainly used by QrSegment.
+ * Bits are packed big endian into 32-bit words, so appending takes a couple
+ * of shifts and ORs instead of one push per bit.
  */
-class BitBuffer final : public std::vector<bool> {
+class BitBuffer final {
 	
-	/*---- Constructor ----*/
+	/*---- Constructors ----*/
 	
 	// Creates an empty bit buffer (length 0).
 	public: BitBuffer();
 	
 	
+	// Creates an empty bit buffer with room for the given number of bits,
+	// so appending up to that length does not reallocate.
+	public: explicit BitBuffer(std::size_t capacityBits);
 	
-	/*---- Method ----*/
+	
+	
+	/*---- Methods ----*/
 	
 	// Appends the given number of low-order bits of the given value
 	// to this buffer. Requires 0 <= len <= 31 and val < 2^len.
 	public: void appendBits(std::uint32_t val, int len);
 	
+	
+	// Appends all bits of the given buffer to this buffer.
+	public: void appendData(const BitBuffer &other);
+	
+	
+	// Makes room for the given total number of bits.
+	public: void reserve(std::size_t capacityBits);
+	
+	
+	// Returns the number of bits in this buffer.
+	public: std::size_t size() const;
+	
+	
+	// Returns the bit at the given index, which must be less than size().
+	public: bool getBit(std::size_t index) const;
+	
+	
+	// Returns the 32 bits starting at bit index * 32, packed big endian, with the bits
+	// past size() as 0s. The index must be less than (size() + 31) / 32.
+	public: std::uint32_t getWord(std::size_t index) const;
+	
+	
+	// Returns the bits packed into bytes in big endian, with the
+	// last byte padded with 0s if the length is not a multiple of 8.
+	public: std::vector<std::uint8_t> getBytes() const;
+	
+	
+	// Appends 1 to 32 low-order bits of val, without range checks.
+	private: void appendWord(std::uint32_t val, int len);
+	
+	
+	
+	/*---- Fields ----*/
+	
+	private: std::vector<std::uint32_t> words;
+	
+	private: std::size_t bitLength;
+	
 };
 
 }
@@ -30,6 +30,8 @@ void BluetoothService :: updateWiFiConfig(const char* ssid, const char* passwd){
 
 void BluetoothService :: setClientConnected(bool status){
   clientConnected = status;
+  //Pollers waiting on pairing progress re-check right away
+  PollingPolicy :: signalStateChange();
 }
 
 bool BluetoothService :: isBLEClientConnected(){
@@ -67,9 +69,9 @@ void BluetoothService :: initializeBLE(const char* dName){
 
   bleDeviceCharacteristic = bleService->createCharacteristic(DEVICE_CHARACTERISTIC_UUID,
                                                             BLECharacteristic::PROPERTY_READ);
-  const char* dInfo = store->getDeviceInfo()->c_str();
-  debugD("\nBluetoothService :: initializeBLE: %s", dInfo);
-  bleDeviceCharacteristic->setValue(std::string(dInfo));
+  String dInfo = store->getDeviceInfo();
+  debugD("\nBluetoothService :: initializeBLE: %s", dInfo.c_str());
+  bleDeviceCharacteristic->setValue(std::string(dInfo.c_str()));
 
   debugD("\nBluetoothService :: initializeBLE: Setting Device Characteristic is done");
 
@@ -52,6 +52,7 @@ class BoTServerCallbacks: public BLEServerCallbacks {
 
   void onDisconnect(BLEServer* pServer) {
     debugI("\nBoTServerCallbacks :: onDisconnect: BLE Client Disconnected...");
+    PollingPolicy :: signalStateChange();
     //BluetoothService :: setClientConnected(false);
     //pServer->getAdvertising()->start();
     //debugI("\nBoTServerCallbacks :: onDisconnect: Started advertising again...");
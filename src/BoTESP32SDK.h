@@ -21,6 +21,8 @@
 #include <mbedtls/error.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha256.h>
 #include <NTPClient.h>
 #include <WiFiUdp.h>
 #include <BLEDevice.h>
@@ -32,6 +34,15 @@
 #define DEVICE_PAIRED 1
 #define DEVICE_ACTIVE 2
 #define DEVICE_MULTIPAIR 3
+#define ACTION_PRIORITY_HIGH 0
+#define ACTION_PRIORITY_LOW 1
+#define ACTION_PRIORITY_LANES 2
+#define ACTION_PRIORITY_DEFAULT 255
+#define ACTION_RESULT_MESSAGE_LENGTH 100
+#define ACTION_RESULT_PENDING 0
+#define ACTION_RESULT_SUCCEEDED 1
+#define ACTION_RESULT_OFFLINE 2
+#define ACTION_RESULT_FAILED 3
 #define LOG Serial.printf
 
 //RemoteDebug Specifics go here
@@ -56,6 +67,17 @@ struct Action{
   unsigned long triggeredTime;
 };
 
+//Last good access point to reconnect without scan, IP configuration is kept for reference only
+struct WiFiCache{
+  char ssid[33];
+  uint8_t bssid[6];
+  int32_t channel;
+  IPAddress ip;
+  IPAddress gateway;
+  IPAddress subnet;
+  IPAddress dns;
+};
+
 struct OfflineActionMetadata{
   byte offline;
   char* deviceID;
@@ -66,6 +88,30 @@ struct OfflineActionMetadata{
   char* alternateID;
   double value;
   unsigned long timestamp;
+  byte priority;
+  byte attempts;
+  unsigned long nextAttemptTime;
+};
+
+struct ActionBatchItem{
+  const char* actionID;
+  const char* value;
+  const char* altID;
+  byte priority;
+  byte result;
+  char message[ACTION_RESULT_MESSAGE_LENGTH+1];
+};
+
+struct LaneMetrics{
+  unsigned long count;
+  unsigned long totalLatency;
+  unsigned long maxLatency;
+};
+
+//QR Code held in RAM as gzipped SVG, with the ETag of the device identity it encodes
+struct QRCodeAsset{
+  String etag;
+  std::vector <uint8_t> gzip;
 };
 
 #endif
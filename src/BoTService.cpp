@@ -28,8 +28,17 @@ BoTService :: BoTService(){
   httpClient = NULL;
   fullURI = NULL;
   botResponse = NULL;
-  encodedJWTPayload = NULL;
+  for(int i=0; i < SIGNED_PAYLOAD_CACHE_SIZE; i++){
+    signedPayloads[i].endPoint = NULL;
+    signedPayloads[i].payload = NULL;
+    signedPayloads[i].signatureLength = 0;
+    signedPayloads[i].signedAt = 0;
+    signedPayloads[i].ttl = 0;
+  }
   store = KeyStore :: getKeyStoreInstance();
+  callMutex = xSemaphoreCreateMutex();
+  mbedtls_pk_init(&pkContext);
+  pkContextReady = false;
 }
 
 BoTService :: ~BoTService(){
@@ -48,6 +57,8 @@ BoTService :: ~BoTService(){
     botResponse = NULL;
   }
 
+  clearSignedPayloads();
+  mbedtls_pk_free(&pkContext);
   freeObjects();
 }
 
@@ -57,43 +68,83 @@ const char* BoTService :: mbedtlsError(int errnum) {
   return buffer;
 }
 
-String BoTService :: encodeJWT(const char* header, const char* payload) {
-  char base64Header[100];
+bool BoTService :: preparePrivateKey(){
+  //Called at boot to have the key parsed before the first signed request
+  xSemaphoreTake(callMutex, portMAX_DELAY);
+  bool status = parsePrivateKey();
+  xSemaphoreGive(callMutex);
+  return status;
+}
+
+void BoTService :: resetSigningKey(){
+  //Device is starting over, signatures and the parsed key must not outlive the keys they came from
+  xSemaphoreTake(callMutex, portMAX_DELAY);
+  clearSignedPayloads();
+  if(pkContextReady){
+    mbedtls_pk_free(&pkContext);
+    mbedtls_pk_init(&pkContext);
+    pkContextReady = false;
+  }
+  xSemaphoreGive(callMutex);
+  debugD("\nBoTService :: resetSigningKey: Signing Key and signed payloads are released");
+}
+
+bool BoTService :: parsePrivateKey(){
+  if(pkContextReady)
+    return true;
+
   store->retrieveAllKeys();
-  base64url_encode(
-    (unsigned char *)header,   // Data to encode.
-    strlen(header),            // Length of data to encode.
-    base64Header);             // Base64 encoded data.
-
-  char base64Payload[100];
-  base64url_encode(
-    (unsigned char *)payload,  // Data to encode.
-    strlen(payload),           // Length of data to encode.
-    base64Payload);            // Base64 encoded data.
-
-  uint8_t headerAndPayload[800];
-  sprintf((char*)headerAndPayload, "%s.%s", base64Header, base64Payload);
-  debugD("\nBoTService :: encodeJWT: headerAndPayload contents: %s", (char*)headerAndPayload);
-
-  mbedtls_pk_context pk_context;
-  mbedtls_pk_init(&pk_context);
+  const char* privateKey = store->getDevicePrivateKey();
+  if(privateKey == NULL){
+    debugE("\nBoTService :: parsePrivateKey: Device private key not available");
+    return false;
+  }
+
   int rc = mbedtls_pk_parse_key(
-             &pk_context,
-             //(unsigned char *)SIGNING_KEY,
-             //strlen((const char*)SIGNING_KEY) + 1,
-             (unsigned char*) store->getDevicePrivateKey(),
-             strlen((const char*)store->getDevicePrivateKey())+1,
+             &pkContext,
+             (unsigned char*) privateKey,
+             strlen(privateKey)+1,
              nullptr,
              0);
   if (rc != 0) {
-    debugE("\nBoTService :: encodeJWT: Failed to mbedtls_pk_parse_key: %d (-0x%x): %s", rc, -rc, mbedtlsError(rc));
-    return "";
+    debugE("\nBoTService :: parsePrivateKey: Failed to mbedtls_pk_parse_key: %d (-0x%x): %s", rc, -rc, mbedtlsError(rc));
+    mbedtls_pk_free(&pkContext);
+    mbedtls_pk_init(&pkContext);
+    return false;
   }
-  debugD("\nBoTService :: encodeJWT: Signing Key is parsed");
+  pkContextReady = true;
+  debugD("\nBoTService :: parsePrivateKey: Signing Key is parsed");
+  return true;
+}
+
+bool BoTService :: signJWT(const char* payload, uint8_t* signature, size_t* signatureLength) {
+  store->retrieveAllKeys();
 
-  mbedtls_rsa_context *rsa;
-  rsa = mbedtls_pk_rsa(pk_context);
-  debugD("\nBoTService :: encodeJWT: RSA context loaded");
+  //Key is parsed once and kept for the later calls
+  if(!parsePrivateKey())
+    return false;
+  int rc = 0;
+
+  //Signing input is encoded header and payload joined by '.', hashed chunk by chunk as it is encoded
+  uint8_t digest[32];
+  char chunk[JWT_STREAM_CHUNK_SIZE + 1];
+  size_t payloadLength = strlen(payload);
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts_ret(&sha, 0);
+  mbedtls_sha256_update_ret(&sha, (const unsigned char*)JWT_HEADER_ENCODED, strlen(JWT_HEADER_ENCODED));
+  mbedtls_sha256_update_ret(&sha, (const unsigned char*)".", 1);
+  for(size_t offset = 0; offset < payloadLength; offset += JWT_STREAM_CHUNK_INPUT){
+    size_t size = payloadLength - offset;
+    if(size > JWT_STREAM_CHUNK_INPUT)
+      size = JWT_STREAM_CHUNK_INPUT;
+    unsigned int encodedLength = 0;
+    base64url_encode((const unsigned char*)payload + offset, size, chunk, sizeof(chunk), &encodedLength);
+    mbedtls_sha256_update_ret(&sha, (const unsigned char*)chunk, encodedLength);
+  }
+  mbedtls_sha256_finish_ret(&sha, digest);
+  mbedtls_sha256_free(&sha);
+  debugD("\nBoTService :: signJWT: Digest of %d bytes payload is completed", payloadLength);
 
   mbedtls_entropy_context entropy;
   mbedtls_ctr_drbg_context ctr_drbg;
@@ -107,50 +158,124 @@ String BoTService :: encodeJWT(const char* header, const char* payload) {
     &entropy,
     (const unsigned char*)pers,
     strlen(pers));
-  debugD("\nBoTService :: encodeJWT: mbedtls_ctr_drbg_seed is completed");
+  debugD("\nBoTService :: signJWT: mbedtls_ctr_drbg_seed is completed");
 
-  uint8_t digest[32];
-  rc = mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), headerAndPayload, strlen((char*)headerAndPayload), digest);
-  if (rc != 0) {
-    debugE("\nBoTService :: encodeJWT: Failed to mbedtls_md: %d (-0x%x): %s", rc, -rc, mbedtlsError(rc));
-    return "";
-  }
-  debugD("\nBoTService :: encodeJWT: mbedtls_md is completed");
+  rc = mbedtls_pk_sign(&pkContext, MBEDTLS_MD_SHA256, digest, sizeof(digest), signature, signatureLength, mbedtls_ctr_drbg_random, &ctr_drbg);
 
-  size_t retSize;
-  uint8_t oBuf[500];
-  rc = mbedtls_pk_sign(&pk_context, MBEDTLS_MD_SHA256, digest, sizeof(digest), oBuf, &retSize, mbedtls_ctr_drbg_random, &ctr_drbg);
+  //Free memory allocated for mbedtls structures
+  mbedtls_ctr_drbg_free(&ctr_drbg);
+  mbedtls_entropy_free(&entropy);
   if (rc != 0) {
-    debugE("\nBoTService :: encodeJWT: Failed to mbedtls_pk_sign: %d (-0x%x): %s", rc, -rc, mbedtlsError(rc));
-    return "";
+    debugE("\nBoTService :: signJWT: Failed to mbedtls_pk_sign: %d (-0x%x): %s", rc, -rc, mbedtlsError(rc));
+    *signatureLength = 0;
+    return false;
   }
-  debugD("\nBoTService :: encodeJWT: mbedtls_pk_sign is completed");
+  debugD("\nBoTService :: signJWT: mbedtls_pk_sign is completed, signature of %d bytes", *signatureLength);
 
-  char base64Signature[600];
-  base64url_encode((unsigned char *)oBuf, retSize, base64Signature);
+  return true;
+}
+
+String BoTService :: get(const char* endPoint){
+  //Calls come from Webserver handlers, provisioning and job worker tasks, one at a time.
+  //botResponse is released by the next call, so the caller gets its own copy taken under the lock
+  xSemaphoreTake(callMutex, portMAX_DELAY);
+  tracer.begin(endPoint);
+  String* response = performGet(endPoint);
+  tracer.end();
+  String result = (response != NULL)?*response:String();
+  xSemaphoreGive(callMutex);
+  return result;
+}
 
-  if(encodedJWTPayload != NULL){
-    free(encodedJWTPayload);
-    encodedJWTPayload = NULL;
-    debugD("\nBoTService :: encodeJWT: Freed previous encodedPayload memory");
+String BoTService :: post(const char* endPoint, const char* payload, const unsigned long cacheTTL, int* httpCode){
+  xSemaphoreTake(callMutex, portMAX_DELAY);
+  tracer.begin(endPoint);
+  String* response = performPost(endPoint, payload, cacheTTL);
+  tracer.end();
+  String result = (response != NULL)?*response:String();
+  //HTTP status of this call, 0 if the request did not go out
+  if(httpCode != NULL)
+    *httpCode = tracer.getLastTrace()->httpCode;
+  xSemaphoreGive(callMutex);
+  return result;
+}
+
+void BoTService :: clearSignedPayloads(){
+  for(int i=0; i < SIGNED_PAYLOAD_CACHE_SIZE; i++){
+    if(signedPayloads[i].endPoint != NULL){
+      delete signedPayloads[i].endPoint;
+      signedPayloads[i].endPoint = NULL;
+    }
+    if(signedPayloads[i].payload != NULL){
+      delete signedPayloads[i].payload;
+      signedPayloads[i].payload = NULL;
+    }
+    signedPayloads[i].signatureLength = 0;
+    signedPayloads[i].ttl = 0;
   }
+}
 
-  encodedJWTPayload = (char*)malloc(strlen((char*)headerAndPayload) + 1 + strlen((char*)base64Signature) + 1);
-  sprintf(encodedJWTPayload, "%s.%s", headerAndPayload, base64Signature);
-  debugD("\nBoTService :: encodeJWT: encoded return data is ready");
+bool BoTService :: getSignedPayload(const char* endPoint, const char* payload, const unsigned long cacheTTL,
+                                                        uint8_t* signature, size_t* signatureLength){
+  //Payloads not marked as idempotent get signed every time
+  if(cacheTTL == 0)
+    return signJWT(payload, signature, signatureLength);
+
+  //Reuse signature of same payload for same end point till it expires
+  int slot = 0;
+  unsigned long now = millis();
+  for(int i=0; i < SIGNED_PAYLOAD_CACHE_SIZE; i++){
+    struct SignedPayload* entry = &signedPayloads[i];
+    if(entry->signatureLength > 0 && entry->endPoint->equals(endPoint) && entry->payload->equals(payload)){
+      if((now - entry->signedAt) < entry->ttl){
+        debugD("\nBoTService :: getSignedPayload: Reusing signed payload for endPoint %s", endPoint);
+        memcpy(signature, entry->signature, entry->signatureLength);
+        *signatureLength = entry->signatureLength;
+        return true;
+      }
+      slot = i;
+      break;
+    }
+    //Otherwise replace an empty or the oldest entry
+    if(entry->signatureLength == 0 || (signedPayloads[slot].signatureLength > 0 &&
+       (now - entry->signedAt) > (now - signedPayloads[slot].signedAt)))
+      slot = i;
+  }
 
-  delay(100);
+  if(!signJWT(payload, signature, signatureLength))
+    return false;
+
+  struct SignedPayload* entry = &signedPayloads[slot];
+  if(entry->endPoint != NULL) delete entry->endPoint;
+  if(entry->payload != NULL) delete entry->payload;
+  entry->endPoint = new String(endPoint);
+  entry->payload = new String(payload);
+  memcpy(entry->signature, signature, *signatureLength);
+  entry->signatureLength = *signatureLength;
+  entry->signedAt = now;
+  entry->ttl = cacheTTL;
+  debugD("\nBoTService :: getSignedPayload: Cached signed payload for endPoint %s for %lu ms", endPoint, cacheTTL);
+
+  return true;
+}
 
-  //Free memory allocated for mbedtls structures
-  mbedtls_ctr_drbg_free(&ctr_drbg);
-  mbedtls_entropy_free(&entropy);
-  mbedtls_pk_free(&pk_context);
-  debugD("\nBoTService :: encodeJWT: Freed memory allocated for mbedtls structures");
+const LatencyHistogram* BoTService :: getLatencyHistogram(const char* endPoint){
+  return tracer.getHistogram(RequestTracer :: getEndPointIndex(endPoint));
+}
+
+const struct RequestTrace* BoTService :: getLastRequestTrace(){
+  return tracer.getLastTrace();
+}
 
-  return encodedJWTPayload;
+uint32_t BoTService :: getTLSConnectCount(){
+  return tracer.getConnectCount();
 }
 
-String* BoTService :: get(const char* endPoint){
+uint32_t BoTService :: getTLSConnectFailureCount(){
+  return tracer.getConnectFailureCount();
+}
+
+String* BoTService :: performGet(const char* endPoint){
   store->loadJSONConfiguration();
   store->retrieveAllKeys();
   https = store->getHTTPS();
@@ -170,6 +295,13 @@ String* BoTService :: get(const char* endPoint){
 
     wifiClient = new WiFiClientSecure();
     httpClient = new HTTPClient();
+    httpClient->setTimeout(HTTP_TIMEOUT_IN_MILLISECONDS);
+
+    //Resolve host upfront to have DNS time apart, the connect below hits lwIP DNS cache
+    IPAddress hostIP;
+    tracer.resume();
+    WiFi.hostByName(hostURL, hostIP);
+    tracer.mark(PHASE_DNS);
 
     if(https){
       const char* caCert = store->getCACert();
@@ -189,7 +321,10 @@ String* BoTService :: get(const char* endPoint){
       httpClientBegin = httpClient->begin(*wifiClient,hostURL,HTTPS_PORT,fullURI->c_str(),true);
       if(httpClientBegin){
         debugI("\nBoTService :: get: HTTPClient initialized for HTTPS");
-        if(!wifiClient->connect((char*)HOST, HTTPS_PORT)){
+        bool connected = wifiClient->connect((char*)HOST, HTTPS_PORT);
+        tracer.mark(PHASE_CONNECT);
+        tracer.recordConnect(connected);
+        if(!connected){
           debugE("\nBoTService :: get: wifiSecureClient connection to %s:%d failed",HOST, HTTPS_PORT);
           freeObjects();
           botResponse = new String("wifiSecureClient connection to server failed, can not verify SSL Finger Print");
@@ -198,6 +333,7 @@ String* BoTService :: get(const char* endPoint){
         else {
           debugI("\nBoTService :: get: wifiSecureClient connection to %s:%d successful",HOST, HTTPS_PORT);
           bool ssl_fg_verify = wifiClient->verify((char*)SSL_FINGERPRINT_SHA256, (char*)HOST);
+          tracer.mark(PHASE_VERIFY);
           debugD("\nBoTService :: get: Return value from wifiClient->verify : %u",ssl_fg_verify);
           if(ssl_fg_verify == true)
             debugI("\nBoTService :: get: SSL Finger Print Verification Succeeded...");
@@ -225,10 +361,14 @@ String* BoTService :: get(const char* endPoint){
       httpClient->addHeader("deviceID", store->getDeviceID());
 
       debugD("\nBoTService :: get: Making httpClient->GET call");
+      tracer.mark(PHASE_SEND);
       int httpCode = httpClient->GET();
+      tracer.mark(PHASE_FIRST_BYTE);
+      tracer.setHTTPCode(httpCode);
       debugD("\nBoTService :: get: httpCode from httpClient->GET(): %d",httpCode);
 
       String* payload = new String(httpClient->getString());
+      tracer.mark(PHASE_BODY);
       httpClient->end();
 
       //Deallocate memory allocated for objects
@@ -244,7 +384,9 @@ String* BoTService :: get(const char* endPoint){
             int secDoTIdx = payload->indexOf(".",firstDoTIdx+1);
             String* encodedPayload = new String(payload->substring(firstDoTIdx+1 , secDoTIdx));
             delete payload;
+            tracer.resume();
             botResponse = decodePayload(encodedPayload);
+            tracer.mark(PHASE_DECODE);
             delete encodedPayload;
             debugD("\nBoTService :: get: botResponse: \n%s\n",botResponse->c_str());
             return(botResponse);
@@ -288,27 +430,30 @@ String* BoTService :: get(const char* endPoint){
 }
 
 String* BoTService :: decodePayload(String* encodedPayload){
-  int payloadLength = encodedPayload->length() + 1;
-  unsigned char* decoded = new unsigned char[payloadLength];
-  //String ss(encodedPayload);
-
-  base64url_decode((char *)encodedPayload->c_str(), encodedPayload->length() , decoded);
+  unsigned int decodedSize = BASE64_DECODE_OUT_SIZE(encodedPayload->length()) + 1;
+  unsigned char* decoded = new unsigned char[decodedSize];
+  unsigned int decodedLength = 0;
+
+  if(base64url_decode(encodedPayload->c_str(), encodedPayload->length(), decoded,
+                      decodedSize - 1, &decodedLength) != BASE64_OK){
+    debugE("\nBoTService :: decodePayload: Payload is not valid base64url");
+    decodedLength = 0;
+  }
+  decoded[decodedLength] = '\0';
   debugD("\nBoTService :: decodePayload: Decoded String: %s", decoded);
 
   DynamicJsonBuffer jsonBuffer;
   JsonObject& root = jsonBuffer.parseObject(decoded);
   String* botValue = new String(root.get<const char*>("bot"));
-  delete decoded;
+  delete[] decoded;
   jsonBuffer.clear();
   debugD("\nBoTService :: decodePayload: botValue: %s",botValue->c_str());
 
   return botValue;
 }
 
-String* BoTService :: post(const char* endPoint, const char* payload){
+String* BoTService :: performPost(const char* endPoint, const char* payload, const unsigned long cacheTTL){
 
-  char* jwtHeader = "{\"alg\":\"RS256\",\"typ\":\"JWT\"}";
-  debugD("\nBoTService :: post: jwtHeader: %s", jwtHeader);
   debugD("\nBoTService :: post: Given Payload: %s", payload);
 
   //Prepare Full URI
@@ -326,6 +471,13 @@ String* BoTService :: post(const char* endPoint, const char* payload){
 
     wifiClient = new WiFiClientSecure();
     httpClient = new HTTPClient();
+    httpClient->setTimeout(HTTP_TIMEOUT_IN_MILLISECONDS);
+
+    //Resolve host upfront to have DNS time apart, the connect below hits lwIP DNS cache
+    IPAddress hostIP;
+    tracer.resume();
+    WiFi.hostByName(hostURL, hostIP);
+    tracer.mark(PHASE_DNS);
     https = store->getHTTPS();
 
     if(https){
@@ -345,7 +497,10 @@ String* BoTService :: post(const char* endPoint, const char* payload){
       httpClientBegin = httpClient->begin(*wifiClient,hostURL,HTTPS_PORT,fullURI->c_str(),true);
       if(httpClientBegin){
         debugI("\nBoTService :: post: HTTPClient initialized for HTTPS");
-        if(!wifiClient->connect((char*)HOST, HTTPS_PORT)){
+        bool connected = wifiClient->connect((char*)HOST, HTTPS_PORT);
+        tracer.mark(PHASE_CONNECT);
+        tracer.recordConnect(connected);
+        if(!connected){
           debugE("\nBoTService :: post: wifiSecureClient connection to %s:%d failed",HOST, HTTPS_PORT);
           freeObjects();
           botResponse = new String("wifiSecureClient connection to server failed, can not verify SSL Finger Print");
@@ -354,6 +509,7 @@ String* BoTService :: post(const char* endPoint, const char* payload){
         else {
           debugI("\nBoTService :: post: wifiSecureClient connection to %s:%d successful",HOST, HTTPS_PORT);
           bool ssl_fg_verify = wifiClient->verify((char*)SSL_FINGERPRINT_SHA256, (char*)HOST);
+          tracer.mark(PHASE_VERIFY);
           debugD("\nBoTService :: post: Return value from wifiClient->verify : %u",ssl_fg_verify);
           if(ssl_fg_verify == true)
             debugI("\nBoTService :: post: SSL Finger Print Verification Succeeded...");
@@ -377,33 +533,42 @@ String* BoTService :: post(const char* endPoint, const char* payload){
     }
 
     if(httpClientBegin){
-      //Encode the given payload using jwtHeader
-      String* botJWT = new String(encodeJWT(jwtHeader, payload));
-
-      //Prepare body contents for Post
-      String* body = new String("{\"bot\": \"");
-      body->concat(botJWT->c_str());
-      body->concat("\"}");
+      //Sign the given payload, JWT header is the same for every call
+      tracer.resume();
+      uint8_t signature[JWT_SIGNATURE_MAX_SIZE];
+      size_t signatureLength = 0;
+      bool payloadSigned = getSignedPayload(endPoint, payload, cacheTTL, signature, &signatureLength);
+      tracer.mark(PHASE_SIGN);
+      if(!payloadSigned){
+        debugE("\nBoTService :: post: Failed to sign the payload");
+        freeObjects();
+        botResponse = new String("Failed to sign the payload");
+        return botResponse;
+      }
 
-      debugD("\nBoTService :: post: body contents after encoding: %s", body->c_str());
+      //Body is encoded while it is sent, in chunks, and its length is known upfront
+      JWTBodyStream body(JWT_HEADER_ENCODED, payload, strlen(payload), signature, signatureLength);
+      debugD("\nBoTService :: post: Streaming body of %d bytes", body.getLength());
 
       httpClient->addHeader("makerID", store->getMakerID());
       httpClient->addHeader("deviceID", store->getDeviceID());
       httpClient->addHeader("Content-Type", "application/json");
       httpClient->addHeader("Connection","keep-alive");
-      httpClient->addHeader("Content-Length",String(body->length()));
 
-      int httpCode = httpClient->POST(body->c_str());
+      //HTTPClient sets Content-Length from the given size
+      tracer.mark(PHASE_SEND);
+      int httpCode = httpClient->sendRequest("POST", &body, body.getLength());
+      tracer.mark(PHASE_FIRST_BYTE);
+      tracer.setHTTPCode(httpCode);
       debugD("\nBoTService :: post: HTTPCode from post call: %d",httpCode);
 
       String* payload = new String(httpClient->getString());
+      tracer.mark(PHASE_BODY);
       debugD("\nBoTService :: post: payload returned from post call: %s", payload->c_str());
 
       httpClient->end();
 
       //Deallocate memory allocated for objects
-      delete body;
-      delete botJWT;
       freeObjects();
 
       if(httpCode >= 0) {
@@ -416,7 +581,9 @@ String* BoTService :: post(const char* endPoint, const char* payload){
             int secDoTIdx = payload->indexOf(".",firstDoTIdx+1);
             String* encodedPayload = new String(payload->substring(firstDoTIdx+1 , secDoTIdx));
             delete payload;
+            tracer.resume();
             botResponse = decodePayload(encodedPayload);
+            tracer.mark(PHASE_DECODE);
             delete encodedPayload;
             if(botResponse != NULL){
              debugD("\nBoTService :: post: Decoded post response: %s",botResponse->c_str());
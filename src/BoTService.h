@@ -9,24 +9,46 @@
 
 #include "BoTESP32SDK.h"
 #include "base64url.h"
+#include "JWTBodyStream.h"
 #include "Storage.h"
+#include "Metrics.h"
+#include <freertos/semphr.h>
 
 #define HOST "iot.bankingofthings.io"
 #define URI ""
 #define HTTP_PORT 80
 #define HTTPS_PORT 443
+#define HTTP_TIMEOUT_IN_MILLISECONDS 5000
+#define SIGNED_PAYLOAD_CACHE_SIZE 2
+#define JWT_SIGNATURE_MAX_SIZE 512
 #define SSL_FINGERPRINT_SHA256 "FB:89:FB:DF:92:0C:AD:CB:65:B0:FD:5A:51:32:C4:94:C7:D9:C1:50:92:FA:3C:F0:B6:F4:3B:2D:8E:38:AE:F8"
 
+//Signature of an idempotent payload, reused till it expires
+struct SignedPayload {
+  String* endPoint;
+  String* payload;
+  uint8_t signature[JWT_SIGNATURE_MAX_SIZE];
+  size_t signatureLength;
+  unsigned long signedAt;
+  unsigned long ttl;
+};
+
 class BoTService {
   public:
     static BoTService* getBoTServiceInstance();
-    String* get(const char* endPoint);
-    String* post(const char* endPoint, const char* payload);
+    String get(const char* endPoint);
+    String post(const char* endPoint, const char* payload, const unsigned long cacheTTL = 0, int* httpCode = NULL);
+    bool preparePrivateKey();
+    void resetSigningKey();
+    const LatencyHistogram* getLatencyHistogram(const char* endPoint);
+    const struct RequestTrace* getLastRequestTrace();
+    uint32_t getTLSConnectCount();
+    uint32_t getTLSConnectFailureCount();
+    static String* decodePayload(String* encodedPayload);
   private:
     static BoTService *bot;
     char* hostURL;
     char* uriPath;
-    char* encodedJWTPayload;
     int port;
     bool https;
     WiFiClientSecure* wifiClient;
@@ -34,9 +56,19 @@ class BoTService {
     KeyStore* store;
     String *fullURI;
     String *botResponse;
+    RequestTracer tracer;
+    SemaphoreHandle_t callMutex;
+    mbedtls_pk_context pkContext;
+    bool pkContextReady;
+    bool parsePrivateKey();
+    void clearSignedPayloads();
+    String* performGet(const char* endPoint);
+    String* performPost(const char* endPoint, const char* payload, const unsigned long cacheTTL);
+    struct SignedPayload signedPayloads[SIGNED_PAYLOAD_CACHE_SIZE];
+    bool getSignedPayload(const char* endPoint, const char* payload, const unsigned long cacheTTL,
+                                                     uint8_t* signature, size_t* signatureLength);
     const char* mbedtlsError(int errnum);
-    String encodeJWT(const char* header, const char* payload);
-    String* decodePayload(String* encodedPayload);
+    bool signJWT(const char* payload, uint8_t* signature, size_t* signatureLength);
     void freeObjects();
     BoTService();
     ~BoTService();
@@ -0,0 +1,194 @@
+/*
+  BootOrchestrator.cpp - Class and Methods to overlap WiFi association with loading
+                         keys, parsing the signing key and generating QR Code on the
+                         other core, joining both at a ready barrier with per-phase timing
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "BootOrchestrator.h"
+BootOrchestrator* BootOrchestrator :: orchestrator = NULL;
+
+BootOrchestrator :: BootOrchestrator(){
+  store = KeyStore :: getKeyStoreInstance();
+  bootEvents = xEventGroupCreate();
+  bootStartTime = 0;
+  readyTime = 0;
+  preparationStarted = false;
+  bootRecorded = false;
+  for(int i=0; i < BOOT_PHASES; i++){
+    phases[i].startTime = 0;
+    phases[i].endTime = 0;
+    phases[i].succeeded = false;
+  }
+  //Association and DHCP are told apart by the WiFi events
+  WiFi.onEvent(onWiFiEvent);
+}
+
+BootOrchestrator* BootOrchestrator :: getBootOrchestratorInstance(){
+  if(orchestrator == NULL){
+    orchestrator = new BootOrchestrator();
+  }
+  return orchestrator;
+}
+
+void BootOrchestrator :: begin(){
+  //Only the first call marks the boot, reconnects keep the boot timing
+  if(bootStartTime == 0)
+    bootStartTime = millis();
+}
+
+void BootOrchestrator :: beginPhase(const byte phase){
+  if(phase >= BOOT_PHASES)
+    return;
+  phases[phase].startTime = millis();
+  phases[phase].endTime = 0;
+  phases[phase].succeeded = false;
+}
+
+void BootOrchestrator :: endPhase(const byte phase, const bool succeeded){
+  if(phase >= BOOT_PHASES)
+    return;
+  phases[phase].endTime = millis();
+  phases[phase].succeeded = succeeded;
+  LOG("\nBootOrchestrator :: endPhase: %s %s in %lu ms", getPhaseName(phase),
+                          succeeded?"completed":"failed", getPhaseDuration(phase));
+}
+
+bool BootOrchestrator :: isPhaseRunning(const byte phase){
+  return (phase < BOOT_PHASES && phases[phase].startTime != 0 && phases[phase].endTime == 0);
+}
+
+void BootOrchestrator :: onWiFiEvent(WiFiEvent_t event){
+  BootOrchestrator* boot = BootOrchestrator :: getBootOrchestratorInstance();
+  switch(event){
+    case SYSTEM_EVENT_STA_CONNECTED:
+      if(boot->isPhaseRunning(BOOT_PHASE_WIFI)){
+        boot->endPhase(BOOT_PHASE_WIFI);
+        boot->beginPhase(BOOT_PHASE_DHCP);
+      }
+      break;
+    case SYSTEM_EVENT_STA_GOT_IP:
+      if(boot->isPhaseRunning(BOOT_PHASE_DHCP))
+        boot->endPhase(BOOT_PHASE_DHCP);
+      break;
+    default:
+      break;
+  }
+}
+
+const struct BootPhase* BootOrchestrator :: getPhase(const byte phase){
+  return (phase < BOOT_PHASES)?&phases[phase]:NULL;
+}
+
+unsigned long BootOrchestrator :: getPhaseDuration(const byte phase){
+  if(phase >= BOOT_PHASES || phases[phase].endTime == 0)
+    return 0;
+  return phases[phase].endTime - phases[phase].startTime;
+}
+
+unsigned long BootOrchestrator :: getBootDuration(){
+  return (readyTime == 0)?0:(readyTime - bootStartTime);
+}
+
+const char* BootOrchestrator :: getPhaseName(const byte phase){
+  switch(phase){
+    case BOOT_PHASE_FS_MOUNT: return "fs_mount";
+    case BOOT_PHASE_CONFIG: return "config";
+    case BOOT_PHASE_WIFI: return "wifi";
+    case BOOT_PHASE_DHCP: return "dhcp";
+    case BOOT_PHASE_KEYS: return "keys";
+    case BOOT_PHASE_SIGNING_KEY: return "signing_key";
+    case BOOT_PHASE_QRCODE: return "qrcode";
+    case BOOT_PHASE_SERVER_START: return "server_start";
+    case BOOT_PHASE_PAIRING_CHECK: return "pairing_check";
+    case BOOT_PHASE_BLE_INIT: return "ble_init";
+    default: return "unknown";
+  }
+}
+
+void BootOrchestrator :: startPreparation(){
+  //Preparation runs once per boot, later reconnects only wait for WiFi
+  if(preparationStarted)
+    return;
+  preparationStarted = true;
+  xEventGroupClearBits(bootEvents, BOOT_PREPARE_READY_BIT);
+  if(xTaskCreatePinnedToCore(prepareTask, "bootPrepare", BOOT_PREPARE_STACK_SIZE, this,
+                             BOOT_PREPARE_PRIORITY, NULL, BOOT_PREPARE_CORE) != pdPASS){
+    //Not enough memory for another task, prepare inline instead
+    LOG("\nBootOrchestrator :: startPreparation: Unable to create preparation task, preparing inline");
+    prepare();
+  }
+}
+
+void BootOrchestrator :: prepareTask(void* param){
+  ((BootOrchestrator*)param)->prepare();
+  vTaskDelete(NULL);
+}
+
+void BootOrchestrator :: prepare(){
+  beginPhase(BOOT_PHASE_KEYS);
+  store->retrieveAllKeys();
+  endPhase(BOOT_PHASE_KEYS, store->isPrivateKeyLoaded() && store->isCACertLoaded());
+
+  beginPhase(BOOT_PHASE_SIGNING_KEY);
+  endPhase(BOOT_PHASE_SIGNING_KEY, BoTService :: getBoTServiceInstance()->preparePrivateKey());
+
+  beginPhase(BOOT_PHASE_QRCODE);
+  endPhase(BOOT_PHASE_QRCODE, store->generateAndSaveQRCode());
+
+  xEventGroupSetBits(bootEvents, BOOT_PREPARE_READY_BIT);
+}
+
+void BootOrchestrator :: setWiFiConnected(const bool connected){
+  if(connected)
+    xEventGroupSetBits(bootEvents, BOOT_WIFI_READY_BIT);
+  else
+    xEventGroupClearBits(bootEvents, BOOT_WIFI_READY_BIT);
+}
+
+bool BootOrchestrator :: isReady(){
+  EventBits_t bits = xEventGroupGetBits(bootEvents);
+  return ((bits & (BOOT_WIFI_READY_BIT | BOOT_PREPARE_READY_BIT)) == (BOOT_WIFI_READY_BIT | BOOT_PREPARE_READY_BIT));
+}
+
+bool BootOrchestrator :: waitUntilReady(const unsigned long timeout){
+  EventBits_t bits = xEventGroupWaitBits(bootEvents, BOOT_WIFI_READY_BIT | BOOT_PREPARE_READY_BIT,
+                                         pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout));
+  bool ready = ((bits & (BOOT_WIFI_READY_BIT | BOOT_PREPARE_READY_BIT)) == (BOOT_WIFI_READY_BIT | BOOT_PREPARE_READY_BIT));
+  if(ready && readyTime == 0){
+    readyTime = millis();
+    LOG("\nBootOrchestrator :: waitUntilReady: Boot ready in %lu ms", getBootDuration());
+  }
+  else if(!ready)
+    LOG("\nBootOrchestrator :: waitUntilReady: Boot not ready after %lu ms", timeout);
+  return ready;
+}
+
+bool BootOrchestrator :: recordBoot(){
+  //Phases of this boot are saved once, phases not run on this boot are left out
+  if(bootRecorded)
+    return true;
+  bootRecorded = true;
+
+  char record[BOOT_RECORD_SIZE];
+  int length = snprintf(record, sizeof(record), "{\"uptime\":%lu,\"ready\":%lu,\"reset\":%d,\"phases\":{",
+                                millis(), getBootDuration(), (int)rtc_get_reset_reason(0));
+  bool first = true;
+  for(byte phase = 0; phase < BOOT_PHASES && length < (int)sizeof(record); phase++){
+    if(phases[phase].startTime == 0)
+      continue;
+    length += snprintf(record + length, sizeof(record) - length, "%s\"%s\":{\"at\":%lu,\"ms\":%lu,\"ok\":%s}",
+                       first?"":",", getPhaseName(phase), phases[phase].startTime, getPhaseDuration(phase),
+                       phases[phase].succeeded?"true":"false");
+    first = false;
+  }
+  if(length < (int)sizeof(record))
+    snprintf(record + length, sizeof(record) - length, "}}");
+
+  LOG("\nBootOrchestrator :: recordBoot: %s", record);
+  return store->saveBootRecord(record);
+}
+
+String BootOrchestrator :: getBootRecords(){
+  return store->getBootRecords();
+}
@@ -0,0 +1,74 @@
+/*
+  BootOrchestrator.h - Class and Methods to overlap WiFi association with loading
+                       keys, parsing the signing key and generating QR Code on the
+                       other core, joining both at a ready barrier with per-phase timing
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef BootOrchestrator_h
+#define BootOrchestrator_h
+#include "BoTESP32SDK.h"
+#include "Storage.h"
+#include "BoTService.h"
+#include <freertos/event_groups.h>
+#include <rom/rtc.h>
+
+#define BOOT_PHASE_FS_MOUNT 0
+#define BOOT_PHASE_CONFIG 1
+#define BOOT_PHASE_WIFI 2
+#define BOOT_PHASE_DHCP 3
+#define BOOT_PHASE_KEYS 4
+#define BOOT_PHASE_SIGNING_KEY 5
+#define BOOT_PHASE_QRCODE 6
+#define BOOT_PHASE_SERVER_START 7
+#define BOOT_PHASE_PAIRING_CHECK 8
+#define BOOT_PHASE_BLE_INIT 9
+#define BOOT_PHASES 10
+#define BOOT_RECORD_SIZE 768
+
+#define BOOT_WIFI_READY_BIT (1 << 0)
+#define BOOT_PREPARE_READY_BIT (1 << 1)
+#define BOOT_PREPARE_STACK_SIZE 12288
+#define BOOT_PREPARE_PRIORITY 1
+//Arduino loop task runs on core 1, preparation goes on core 0
+#define BOOT_PREPARE_CORE 0
+#define BOOT_READY_TIMEOUT_IN_MILLISECONDS 30000
+
+struct BootPhase {
+  unsigned long startTime;
+  unsigned long endTime;
+  bool succeeded;
+};
+
+class BootOrchestrator {
+  public:
+    static BootOrchestrator* getBootOrchestratorInstance();
+    void begin();
+    void startPreparation();
+    void setWiFiConnected(const bool connected);
+    bool waitUntilReady(const unsigned long timeout = BOOT_READY_TIMEOUT_IN_MILLISECONDS);
+    bool isReady();
+    bool isPhaseRunning(const byte phase);
+    bool recordBoot();
+    String getBootRecords();
+    void beginPhase(const byte phase);
+    void endPhase(const byte phase, const bool succeeded = true);
+    const struct BootPhase* getPhase(const byte phase);
+    unsigned long getPhaseDuration(const byte phase);
+    unsigned long getBootDuration();
+    static const char* getPhaseName(const byte phase);
+  private:
+    static BootOrchestrator *orchestrator;
+    KeyStore *store;
+    EventGroupHandle_t bootEvents;
+    struct BootPhase phases[BOOT_PHASES];
+    unsigned long bootStartTime;
+    unsigned long readyTime;
+    bool preparationStarted;
+    bool bootRecorded;
+    static void onWiFiEvent(WiFiEvent_t event);
+    static void prepareTask(void* param);
+    void prepare();
+    BootOrchestrator();
+};
+#endif
@@ -13,9 +13,9 @@ ControllerService :: ControllerService(){
 }
 
 void ControllerService :: getActions(AsyncWebServerRequest *request){
-  String* response = actionService->getActions();
+  String response = actionService->retrieveActions();
 
-  if(response == NULL){
+  if(response.length() == 0){
     DynamicJsonBuffer jsonBuffer;
     JsonObject& doc = jsonBuffer.createObject();
     doc["message"] = "Unable to retrieve actions";
@@ -26,7 +26,7 @@ void ControllerService :: getActions(AsyncWebServerRequest *request){
     request->send(503, "application/json", body);
   }
   else {
-    const char* responseString = response->c_str();
+    const char* responseString = response.c_str();
     debugD("\nControllerService :: getActions: %s", responseString);
     request->send(200, "application/json", responseString);
   }
@@ -54,8 +54,7 @@ void ControllerService :: postAction(AsyncWebServerRequest *request){
       request->send(400, "application/json", body);
     }
     else {
-      AsyncWebParameter* p = request->getParam(0);
-      if(strcmp(p->name().c_str(), "actionID") != 0){
+      if(!request->hasParam("actionID")){
         debugE("\nControllerService :: postAction: Query Parameter should be `actionID`");
         doc["message"] = "Query Parameter should be `actionID`";
         doc.printTo(body);
@@ -71,24 +70,34 @@ void ControllerService :: postAction(AsyncWebServerRequest *request){
         request->send(400, "application/json", body);
       }
       else {
-        const char* actionID = p->value().c_str();
-        if(actionID != NULL && strlen(actionID) > 0){
-          debugI("\nControllerService :: postAction: Given actionID: %s",actionID);
-          const int responseCode = triggerAction(actionID);
-          switch(responseCode) {
-            case 200 : debugI("\nControllerService :: postAction: Action triggered successful");
-                       doc["message"] = "Action triggered successful";
-                       break;
-            case 201 : debugI("\nControllerService :: postAction: Action saved as Offline Action");
-                       doc["message"] = "Action saved as Offline Action";
-                       break;
-            default  : debugE("\nControllerService :: postAction: Check parameters and try again");
-                       doc["message"] = "Check parameters and try again";
-                       break;
+        String actionID = request->getParam("actionID")->value();
+        if(actionID.length() > 0){
+          debugI("\nControllerService :: postAction: Given actionID: %s",actionID.c_str());
+          String value;
+          if(request->hasParam("value"))
+            value = request->getParam("value")->value();
+          byte priority = ACTION_PRIORITY_DEFAULT;
+          if(request->hasParam("priority"))
+            priority = request->getParam("priority")->value().equalsIgnoreCase("high")?ACTION_PRIORITY_HIGH:ACTION_PRIORITY_LOW;
+
+          //Action gets triggered by JobService worker, response goes out right away
+          unsigned long jobID = JobService :: getJobServiceInstance()->enqueueAction(actionID.c_str(),
+                                          (value.length() > 0)?value.c_str():NULL, priority);
+          if(jobID != 0){
+            doc["message"] = "Action accepted";
+            doc["jobID"] = jobID;
+            doc.printTo(body);
+            jsonBuffer.clear();
+            debugI("\nControllerService :: postAction: %s", body);
+            request->send(202, "application/json", body);
+          }
+          else {
+            doc["message"] = "Unable to accept action, try again";
+            doc.printTo(body);
+            jsonBuffer.clear();
+            debugE("\nControllerService :: postAction: %s", body);
+            request->send(503, "application/json", body);
           }
-          doc.printTo(body);
-          jsonBuffer.clear();
-          request->send(responseCode, "application/json", body);
         }
         else {
           debugE("\nControllerService :: postAction: actionID cannot be NULL");
@@ -101,43 +110,335 @@ void ControllerService :: postAction(AsyncWebServerRequest *request){
     }
 }
 
-int ControllerService :: triggerAction(const char* actionID){
-  String* response = actionService->triggerAction(actionID);
-  int responseCode = 400;
-  if(response == NULL){
-    debugI("\nControllerService :: triggerAction: Action saved as offline action");
-    responseCode = 201;
+const char* ControllerService :: validateBatchItem(JsonVariant item){
+  const char* actionID = item["actionID"];
+  if(actionID == NULL || strlen(actionID) == 0)
+    return "actionID is missing";
+  if(strlen(actionID) > JOB_ACTION_ID_LENGTH)
+    return "actionID is too long";
+  if(item["value"].success() && item["value"].as<String>().length() > JOB_VALUE_LENGTH)
+    return "value is too long";
+  const char* altID = item["altID"];
+  if(altID != NULL && strlen(altID) > JOB_ALT_ID_LENGTH)
+    return "altID is too long";
+  if(store->isDeviceMultipair() && altID == NULL && store->getAlternateDeviceID() == NULL)
+    return "Missing parameter `altID`";
+  return NULL;
+}
+
+void ControllerService :: postActionBatch(AsyncWebServerRequest *request, JsonVariant &json){
+  debugI("\nControllerService :: postActionBatch: Request received to trigger batch of actions");
+  AsyncJsonResponse* response = new AsyncJsonResponse();
+  JsonObject& root = response->getRoot();
+
+  JsonArray& batch = json;
+  if(store->getDeviceState() < DEVICE_ACTIVE){
+    root["message"] = "Device not activated";
+    response->setCode(400);
+  }
+  else if(!batch.success() || batch.size() == 0){
+    root["message"] = "Need JSON array of {actionID, value, altID} items";
+    response->setCode(400);
   }
-  else if(response->indexOf("OK") != -1){
-    debugI("\nControllerService :: triggerAction: triggerAction Response: %s", response->c_str());
-    responseCode = 200;
+  else if(batch.size() > BATCH_MAXIMUM_ACTIONS){
+    root["message"] = "Too many actions in the batch";
+    root["maximum"] = BATCH_MAXIMUM_ACTIONS;
+    response->setCode(400);
   }
   else {
-    debugI("\nControllerService :: triggerAction: triggerAction Response: %s", response->c_str());
-    responseCode = 404;
+    //Every item is validated before anything gets queued
+    const int count = batch.size();
+    JsonArray& errors = root.createNestedArray("errors");
+    for(int i = 0; i < count; i++){
+      const char* error = validateBatchItem(batch[i]);
+      if(error != NULL){
+        JsonObject& itemError = errors.createNestedObject();
+        itemError["index"] = i;
+        itemError["message"] = error;
+      }
+    }
+
+    if(errors.size() > 0){
+      root["message"] = "Invalid batch, no action queued";
+      response->setCode(400);
+    }
+    else {
+      struct ActionBatchItem items[BATCH_MAXIMUM_ACTIONS];
+      String values[BATCH_MAXIMUM_ACTIONS];
+      unsigned long jobIDs[BATCH_MAXIMUM_ACTIONS];
+      for(int i = 0; i < count; i++){
+        items[i].actionID = batch[i]["actionID"];
+        items[i].altID = batch[i]["altID"];
+        items[i].value = NULL;
+        if(batch[i]["value"].success()){
+          values[i] = batch[i]["value"].as<String>();
+          items[i].value = values[i].c_str();
+        }
+        items[i].priority = ACTION_PRIORITY_DEFAULT;
+      }
+
+      root.remove("errors");
+      if(JobService :: getJobServiceInstance()->enqueueBatch(items, count, jobIDs)){
+        root["message"] = "Actions accepted";
+        JsonArray& results = root.createNestedArray("results");
+        for(int i = 0; i < count; i++){
+          JsonObject& result = results.createNestedObject();
+          result["index"] = i;
+          result["actionID"] = items[i].actionID;
+          result["jobID"] = jobIDs[i];
+          result["status"] = JobService :: getJobStatusMsg(JOB_QUEUED);
+        }
+        response->setCode(202);
+      }
+      else {
+        root["message"] = "Unable to accept actions, try again";
+        response->setCode(503);
+      }
+    }
   }
 
-  //Dump actions triggered stats
-  int offActionsTriggerCount = actionService->getOfflineActionsTriggerCount();
-  int actionsTriggerCount = actionService->getActionsTriggerCount();
-  debugI("\nControllerService :: postAction: Number of offline actions left over: %d",actionService->getOfflineActionsCount());
-  debugI("\nControllerService :: postAction: Number of offline actions triggered: %d",offActionsTriggerCount);
-  debugI("\nControllerService :: postAction: Number of actions triggered: %d",actionsTriggerCount);
-  debugI("\nControllerService :: postAction: Number of total actions triggered since from board start: %d",actionsTriggerCount+offActionsTriggerCount);
+  debugD("\nControllerService :: postActionBatch: Responding with %s", root["message"].as<const char*>());
+  response->setLength();
+  request->send(response);
+}
 
-  return responseCode;
+void ControllerService :: getActionStatus(AsyncWebServerRequest *request){
+  DynamicJsonBuffer jsonBuffer;
+  JsonObject& doc = jsonBuffer.createObject();
+  char body[250];
+  struct ActionJob job;
+
+  if(!request->hasParam("id")){
+    doc["message"] = "Need id as query parameter to get action status";
+    doc.printTo(body);
+    jsonBuffer.clear();
+    debugE("\nControllerService :: getActionStatus: %s", body);
+    request->send(400, "application/json", body);
+  }
+  else if(!JobService :: getJobServiceInstance()->getJob(request->getParam("id")->value().toInt(), &job)){
+    doc["message"] = "Job not found";
+    doc.printTo(body);
+    jsonBuffer.clear();
+    debugW("\nControllerService :: getActionStatus: %s", body);
+    request->send(404, "application/json", body);
+  }
+  else {
+    doc["jobID"] = job.jobID;
+    doc["actionID"] = job.actionID;
+    doc["status"] = JobService :: getJobStatusMsg(job.status);
+    if(strlen(job.message) > 0)
+      doc["message"] = job.message;
+    doc.printTo(body);
+    jsonBuffer.clear();
+    debugD("\nControllerService :: getActionStatus: %s", body);
+    request->send(200, "application/json", body);
+  }
+}
+
+void ControllerService :: getDeadLetterActions(AsyncWebServerRequest *request){
+  String response = store->getDeadLetterActions();
+
+  if(response.length() == 0){
+    debugE("\nControllerService :: getDeadLetterActions: Unable to retrieve dead letter actions");
+    request->send(503, "application/json", "{\"message\":\"Unable to retrieve dead letter actions\"}");
+  }
+  else {
+    debugD("\nControllerService :: getDeadLetterActions: %s", response.c_str());
+    request->send(200, "application/json", response);
+  }
+}
+
+void ControllerService :: getBootRecords(AsyncWebServerRequest *request){
+  String response = BootOrchestrator :: getBootOrchestratorInstance()->getBootRecords();
+
+  if(response.length() == 0){
+    debugE("\nControllerService :: getBootRecords: Unable to retrieve boot records");
+    request->send(503, "application/json", "{\"message\":\"Unable to retrieve boot records\"}");
+  }
+  else {
+    debugD("\nControllerService :: getBootRecords: %s", response.c_str());
+    request->send(200, "application/json", response);
+  }
+}
+
+void ControllerService :: clearDeadLetterActions(AsyncWebServerRequest *request){
+  if(store->clearDeadLetterActions()){
+    debugI("\nControllerService :: clearDeadLetterActions: Dead letter actions cleared");
+    request->send(200, "application/json", "{\"message\":\"Dead letter actions cleared\"}");
+  }
+  else {
+    debugE("\nControllerService :: clearDeadLetterActions: Unable to clear dead letter actions");
+    request->send(503, "application/json", "{\"message\":\"Unable to clear dead letter actions\"}");
+  }
+}
+
+//Scrapes render here instead of the heap, handlers and disconnect callbacks all run on the async TCP task
+static char metricsBuffer[METRICS_BUFFER_SIZE];
+static bool metricsBufferInUse = false;
+
+//Appends formatted text at length, output beyond the buffer is cut off and the buffer stays terminated
+static size_t appendMetrics(char* buffer, const size_t size, size_t length, const char* format, ...){
+  if(length >= size - 1)
+    return length;
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(buffer + length, size - length, format, args);
+  va_end(args);
+  if(written < 0)
+    return length;
+  length += written;
+  return (length < size - 1) ? length : size - 1;
+}
+
+size_t ControllerService :: renderMetrics(char* buffer, const size_t size){
+  BoTService* bot = BoTService :: getBoTServiceInstance();
+  size_t length = 0;
+
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_actions_triggered_total Actions triggered successfully since board start\n"
+                  "# TYPE bot_actions_triggered_total counter\n"
+                  "bot_actions_triggered_total{mode=\"online\"} %d\n"
+                  "bot_actions_triggered_total{mode=\"offline\"} %d\n",
+                  actionService->getActionsTriggerCount(), actionService->getOfflineActionsTriggerCount());
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_offline_actions Offline actions waiting to be triggered\n"
+                  "# TYPE bot_offline_actions gauge\n"
+                  "bot_offline_actions %d\n", store->getOfflineActionsDepth());
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_heap_free_bytes Free heap\n"
+                  "# TYPE bot_heap_free_bytes gauge\n"
+                  "bot_heap_free_bytes %u\n"
+                  "# HELP bot_heap_largest_free_block_bytes Largest allocatable heap block\n"
+                  "# TYPE bot_heap_largest_free_block_bytes gauge\n"
+                  "bot_heap_largest_free_block_bytes %u\n",
+                  ESP.getFreeHeap(), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_tls_connects_total TLS sessions set up with BoT Service\n"
+                  "# TYPE bot_tls_connects_total counter\n"
+                  "bot_tls_connects_total %u\n"
+                  "# HELP bot_tls_connect_failures_total TLS sessions failed to set up with BoT Service\n"
+                  "# TYPE bot_tls_connect_failures_total counter\n"
+                  "bot_tls_connect_failures_total %u\n",
+                  bot->getTLSConnectCount(), bot->getTLSConnectFailureCount());
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_uptime_seconds Seconds since board start\n"
+                  "# TYPE bot_uptime_seconds counter\n"
+                  "bot_uptime_seconds %lu\n", (unsigned long)(esp_timer_get_time() / 1000000));
+
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_request_duration_milliseconds BoT Service call latency\n"
+                  "# TYPE bot_request_duration_milliseconds histogram\n");
+  for(byte ep = 0; ep < METRICS_END_POINTS; ep++){
+    const char* endPoint = RequestTracer :: getEndPointName(ep);
+    const LatencyHistogram* histogram = bot->getLatencyHistogram(endPoint);
+    uint32_t cumulative = 0;
+    for(byte b = 0; b < LATENCY_HISTOGRAM_BUCKETS-1; b++){
+      cumulative += histogram->getBucketCount(b);
+      length = appendMetrics(buffer, size, length,
+                  "bot_request_duration_milliseconds_bucket{endpoint=\"%s\",le=\"%u\"} %u\n",
+                  endPoint, LatencyHistogram :: getBucketBound(b), cumulative);
+    }
+    cumulative += histogram->getBucketCount(LATENCY_HISTOGRAM_BUCKETS-1);
+    length = appendMetrics(buffer, size, length,
+                  "bot_request_duration_milliseconds_bucket{endpoint=\"%s\",le=\"+Inf\"} %u\n"
+                  "bot_request_duration_milliseconds_sum{endpoint=\"%s\"} %u\n"
+                  "bot_request_duration_milliseconds_count{endpoint=\"%s\"} %u\n",
+                  endPoint, cumulative, endPoint, histogram->getSum(), endPoint, cumulative);
+  }
+
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_action_lane_latency_milliseconds Time from trigger until BoT Service acknowledged the action, per priority lane\n"
+                  "# TYPE bot_action_lane_latency_milliseconds summary\n");
+  for(byte lane = 0; lane < ACTION_PRIORITY_LANES; lane++){
+    const struct LaneMetrics* metrics = actionService->getLaneMetrics(lane);
+    const char* laneName = (lane == ACTION_PRIORITY_HIGH)?"high":"low";
+    length = appendMetrics(buffer, size, length,
+                  "bot_action_lane_latency_milliseconds_sum{lane=\"%s\"} %lu\n"
+                  "bot_action_lane_latency_milliseconds_count{lane=\"%s\"} %lu\n",
+                  laneName, metrics->totalLatency, laneName, metrics->count);
+  }
+  length = appendMetrics(buffer, size, length,
+                  "# HELP bot_action_lane_latency_max_milliseconds Longest time until an action was acknowledged, per priority lane\n"
+                  "# TYPE bot_action_lane_latency_max_milliseconds gauge\n");
+  for(byte lane = 0; lane < ACTION_PRIORITY_LANES; lane++){
+    length = appendMetrics(buffer, size, length, "bot_action_lane_latency_max_milliseconds{lane=\"%s\"} %lu\n",
+                  (lane == ACTION_PRIORITY_HIGH)?"high":"low", actionService->getLaneMetrics(lane)->maxLatency);
+  }
+  return length;
+}
+
+void ControllerService :: getMetrics(AsyncWebServerRequest *request){
+  //Buffer is sent from as the client acknowledges, it stays taken until that connection is gone
+  if(metricsBufferInUse){
+    debugW("\nControllerService :: getMetrics: Previous scrape still being sent, returning 503 as web response");
+    AsyncWebServerResponse *response = request->beginResponse(503,"text/plain","Metrics scrape in progress");
+    response->addHeader("Retry-After", METRICS_RETRY_AFTER_SECONDS);
+    request->send(response);
+    return;
+  }
+
+  metricsBufferInUse = true;
+  request->onDisconnect([](){
+    metricsBufferInUse = false;
+  });
+  size_t length = renderMetrics(metricsBuffer, METRICS_BUFFER_SIZE);
+  if(length == METRICS_BUFFER_SIZE - 1)
+    debugW("\nControllerService :: getMetrics: Metrics truncated at %d bytes", length);
+  else
+    debugD("\nControllerService :: getMetrics: Rendered %d bytes of metrics", length);
+  request->send(request->beginResponse_P(200, METRICS_CONTENT_TYPE, (const uint8_t*)metricsBuffer, length));
 }
 
 void ControllerService :: getQRCode(AsyncWebServerRequest *request){
-  //Check QR Code generation qrCodeStatus
-  bool qrCodeStatus = store->isQRCodeGeneratedandSaved();
-  if(!qrCodeStatus){
-    debugD("\nControllerService :: getQRCode: Generating QR Code and saving to SPIFFS");
-    qrCodeStatus = store->generateAndSaveQRCode();
+  //Asset is built off the web server task, ETag is empty until it is ready for the present identity
+  String etag = store->getQRCodeETag();
+  if(etag.length() == 0){
+    debugW("\nControllerService :: getQRCode: QR Code not available yet, returning 503 as web response");
+    AsyncWebServerResponse *response = request->beginResponse(503,"text/plain","QR Code not available yet");
+    response->addHeader("Retry-After", QRCODE_RETRY_AFTER_SECONDS);
+    request->send(response);
+    return;
+  }
+
+  //Client already holds this QR Code
+  if(request->hasHeader("If-None-Match") &&
+     request->getHeader("If-None-Match")->value().indexOf(etag) >= 0){
+    debugD("\nControllerService :: getQRCode: ETag %s matches, returning 304 as web response", etag.c_str());
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", QRCODE_CACHE_CONTROL);
+    request->send(response);
+    return;
   }
-  if(qrCodeStatus){
+
+  if(request->hasHeader("Accept-Encoding") &&
+     request->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0){
+    //Response owns a copy of the compressed bytes, a rebuild meanwhile does not touch what is being sent
+    AsyncResponseStream *response = request->beginResponseStream("image/svg+xml");
+    size_t length = store->writeQRCodeAsset(*response, etag);
+    if(length == 0){
+      delete response;
+      debugW("\nControllerService :: getQRCode: QR Code changed while serving, returning 503 as web response");
+      request->send(503,"text/plain","QR Code not available yet");
+      return;
+    }
+    debugI("\nControllerService :: getQRCode: Serving gzipped QR Code of %d bytes from RAM", length);
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("Vary", "Accept-Encoding");
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", QRCODE_CACHE_CONTROL);
+    request->send(response);
+    return;
+  }
+
+  //Plain SVG for clients without gzip support, from the copy kept on SPIFFS
+  if(store->isQRCodeGeneratedandSaved()){
     debugI("\nControllerService :: getQRCode: QR Code exists on SPIFFS, serving through webresponse");
-    request->send(SPIFFS,QRCODE_FILE,"image/svg+xml");
+    AsyncWebServerResponse *response = request->beginResponse(SPIFFS,QRCODE_FILE,"image/svg+xml");
+    response->addHeader("Vary", "Accept-Encoding");
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", QRCODE_CACHE_CONTROL);
+    request->send(response);
   }
   else{
     debugE("\nControllerService :: getQRCode: QR Code not available on SPIFFS, returning 404 as web response");
@@ -145,6 +446,22 @@ void ControllerService :: getQRCode(AsyncWebServerRequest *request){
   }
 }
 
+void ControllerService :: getPairingStatus(AsyncWebServerRequest *request){
+  Webserver* webServer = Webserver :: getWebserverInstance(false);
+  DynamicJsonBuffer jsonBuffer;
+  JsonObject& doc = jsonBuffer.createObject();
+  char body[200];
+
+  doc["state"] = webServer->getProvisioningStatusMsg();
+  doc["deviceState"] = store->getDeviceStatusMsg();
+  doc["elapsed"] = webServer->getProvisioningElapsedTime();
+  doc["attempts"] = webServer->getProvisioningAttempts();
+  doc.printTo(body);
+  jsonBuffer.clear();
+  debugD("\nControllerService :: getPairingStatus: %s", body);
+  request->send(200, "application/json", body);
+}
+
 void ControllerService :: pairDevice(AsyncWebServerRequest *request){
   store->initializeEEPROM();
   DynamicJsonBuffer jsonBuffer;
@@ -159,12 +476,17 @@ void ControllerService :: pairDevice(AsyncWebServerRequest *request){
     request->send(400, "application/json", body);
   }
   else {
+    //Single pairing and activation check, request handler must not wait between retries
     PairingService* pairService = new PairingService();
-    pairService->pairDevice();
+    if(pairService->checkPairingStatus() && store->getDeviceState() == DEVICE_PAIRED){
+      ActivationService* activateService = new ActivationService();
+      activateService->checkActivationStatus();
+      delete activateService;
+    }
     delete pairService;
 
     int deviceState = store->getDeviceState();
-    debugD("\nControllerService :: pairDevice: Device state after return from pairService->pairDevice() : %d",deviceState);
+    debugD("\nControllerService :: pairDevice: Device state after pairing check : %d",deviceState);
     if( deviceState != DEVICE_NEW){
       doc["message"] = "Device pairing successful";
       doc.printTo(body);
@@ -197,11 +519,11 @@ void ControllerService :: activateDevice(AsyncWebServerRequest *request){
   }
   else {
     ActivationService* activateService = new ActivationService();
-    activateService->activateDevice();
+    activateService->checkActivationStatus();
     delete activateService;
 
     int deviceState = store->getDeviceState();
-    debugD("\nControllerService :: activateDevice: Device state after return from activateService->activateDevice : %d",deviceState);
+    debugD("\nControllerService :: activateDevice: Device state after activation check : %d",deviceState);
     if( deviceState > DEVICE_PAIRED){
       doc["message"] = "Device activation successful";
       doc.printTo(body);
@@ -13,6 +13,17 @@
 #include "ActionService.h"
 #include "ActivationService.h"
 #include "ConfigurationService.h"
+#include "BoTService.h"
+#include "JobService.h"
+#include "BootOrchestrator.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <stdarg.h>
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4"
+#define METRICS_BUFFER_SIZE 6144
+#define METRICS_RETRY_AFTER_SECONDS "1"
+#define QRCODE_RETRY_AFTER_SECONDS "1"
+#define QRCODE_CACHE_CONTROL "private, max-age=300, must-revalidate"
 
 class ActionService;
 class ControllerService {
@@ -20,12 +31,20 @@ class ControllerService {
           ControllerService();
           void getActions(AsyncWebServerRequest *request);
           void pairDevice(AsyncWebServerRequest *request);
+          void getPairingStatus(AsyncWebServerRequest *request);
           void activateDevice(AsyncWebServerRequest *request);
           void getQRCode(AsyncWebServerRequest *request);
           void postAction(AsyncWebServerRequest *request);
+          void getActionStatus(AsyncWebServerRequest *request);
+          void postActionBatch(AsyncWebServerRequest *request, JsonVariant &json);
+          void getDeadLetterActions(AsyncWebServerRequest *request);
+          void clearDeadLetterActions(AsyncWebServerRequest *request);
+          void getBootRecords(AsyncWebServerRequest *request);
+          void getMetrics(AsyncWebServerRequest *request);
   private:
     KeyStore* store;
     ActionService* actionService;
-    int triggerAction(const char* actionID);
+    size_t renderMetrics(char* buffer, const size_t size);
+    const char* validateBatchItem(JsonVariant item);
 };
 #endif
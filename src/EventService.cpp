@@ -0,0 +1,201 @@
+/*
+  EventService.cpp - Class and Methods to push action outcomes, offline action drains,
+                     device state and connectivity changes to Webserver clients as
+                     Server-Sent Events
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "EventService.h"
+EventService* EventService :: instance = NULL;
+
+EventService* EventService :: getEventServiceInstance(){
+  if(instance == NULL){
+    instance = new EventService();
+    debugI("\nEventService : getEventServiceInstance: EventService instance created...");
+  }
+  return instance;
+}
+
+EventService :: EventService(){
+  attached = false;
+  clients = 0;
+  ringMux = portMUX_INITIALIZER_UNLOCKED;
+  memset(ring, 0, sizeof(ring));
+  nextEventID = 1;
+  droppedEvents = 0;
+  WiFi.onEvent(onWiFiEvent);
+}
+
+void EventService :: attach(AsyncWebServer* server){
+  if(attached)
+    return;
+
+  server->on(EVENTS_END_POINT, HTTP_GET, [](AsyncWebServerRequest *request){
+    EventService :: getEventServiceInstance()->openStream(request);
+  });
+  attached = true;
+  debugI("\nEventService :: attach: Server-Sent Events available at %s", EVENTS_END_POINT);
+}
+
+void EventService :: publish(const char* name, const char* format, ...){
+  struct ServerEvent event;
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(event.data, sizeof(event.data), format, args);
+  va_end(args);
+  //Cut off data is not valid JSON anymore, clients would fail to parse it
+  if(length < 0 || length >= (int)sizeof(event.data)){
+    debugE("\nEventService :: publish: %s event data does not fit in %d bytes, not published", name, EVENT_DATA_LENGTH);
+    return;
+  }
+  strncpy(event.name, name, EVENT_NAME_LENGTH);
+  event.name[EVENT_NAME_LENGTH] = '\0';
+
+  //Ring slot of the oldest event gets overwritten, clients behind it skip ahead
+  portENTER_CRITICAL(&ringMux);
+  event.id = nextEventID++;
+  memcpy(&ring[event.id % EVENTS_RING_SIZE], &event, sizeof(struct ServerEvent));
+  portEXIT_CRITICAL(&ringMux);
+  debugD("\nEventService :: publish: %s - %s", event.name, event.data);
+}
+
+void EventService :: escapeJSON(char* out, const size_t size, const char* in){
+  size_t length = 0;
+  for(int i = 0; in != NULL && in[i] != '\0'; i++){
+    if(in[i] == '"' || in[i] == '\\'){
+      //Escape sequence goes in whole or not at all
+      if(length + 2 >= size)
+        break;
+      out[length++] = '\\';
+      out[length++] = in[i];
+    }
+    else if((unsigned char)in[i] >= ' '){
+      if(length + 1 >= size)
+        break;
+      out[length++] = in[i];
+    }
+  }
+  out[length] = '\0';
+}
+
+void EventService :: publishActionResult(const char* actionID, const byte result, const char* message){
+  const char* status = "failed";
+  if(result == ACTION_RESULT_SUCCEEDED)
+    status = "succeeded";
+  else if(result == ACTION_RESULT_OFFLINE)
+    status = "offline";
+
+  //Both come from outside, message can be a raw BoT Service response, bounded to fit in one event
+  char safeActionID[EVENT_ACTION_ID_LENGTH+1];
+  char safeMessage[EVENT_MESSAGE_LENGTH+1];
+  escapeJSON(safeActionID, sizeof(safeActionID), actionID);
+  escapeJSON(safeMessage, sizeof(safeMessage), message);
+  publish("action", "{\"actionID\":\"%s\",\"status\":\"%s\",\"message\":\"%s\"}",
+               safeActionID, status, safeMessage);
+}
+
+void EventService :: publishDeviceState(const int state){
+  const char* stateMsg = "INVALID";
+  switch(state){
+    case DEVICE_NEW: stateMsg = "DEVICE_NEW"; break;
+    case DEVICE_PAIRED: stateMsg = "DEVICE_PAIRED"; break;
+    case DEVICE_ACTIVE: stateMsg = "DEVICE_ACTIVE"; break;
+    case DEVICE_MULTIPAIR: stateMsg = "DEVICE_MULTIPAIR"; break;
+  }
+  publish("state", "{\"state\":\"%s\"}", stateMsg);
+}
+
+uint32_t EventService :: getDroppedEvents(){
+  return droppedEvents;
+}
+
+//Reads the event after the client's cursor and advances it, a cursor the ring has wrapped past
+//skips to the oldest event still held
+bool EventService :: readEvent(uint32_t* cursor, struct ServerEvent* event){
+  bool available = false;
+  portENTER_CRITICAL(&ringMux);
+  if(nextEventID - 1 - *cursor > EVENTS_RING_SIZE){
+    droppedEvents += nextEventID - 1 - *cursor - EVENTS_RING_SIZE;
+    *cursor = nextEventID - 1 - EVENTS_RING_SIZE;
+  }
+  uint32_t id = *cursor + 1;
+  if(id < nextEventID){
+    memcpy(event, &ring[id % EVENTS_RING_SIZE], sizeof(struct ServerEvent));
+    *cursor = id;
+    available = true;
+  }
+  portEXIT_CRITICAL(&ringMux);
+  return available;
+}
+
+void EventService :: openStream(AsyncWebServerRequest* request){
+  if(clients >= EVENTS_MAXIMUM_CLIENTS){
+    debugW("\nEventService :: openStream: %d clients already connected, returning 503 as web response", clients);
+    request->send(503, "text/plain", "Too many event clients");
+    return;
+  }
+
+  //New client starts with the next event, reconnecting client resumes from its Last-Event-ID
+  portENTER_CRITICAL(&ringMux);
+  uint32_t cursor = nextEventID - 1;
+  portEXIT_CRITICAL(&ringMux);
+  if(request->hasHeader("Last-Event-ID")){
+    uint32_t lastID = strtoul(request->getHeader("Last-Event-ID")->value().c_str(), NULL, 10);
+    if(lastID < cursor){
+      debugD("\nEventService :: openStream: Client resumes from event %u", lastID);
+      cursor = lastID;
+    }
+  }
+
+  //Each client pulls from the ring at its own pace whenever its connection has room,
+  //a slow client falls behind on its own cursor without holding back the others
+  AsyncWebServerResponse *response = request->beginChunkedResponse("text/event-stream",
+                        [cursor](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+    return EventService :: getEventServiceInstance()->fillStream(&cursor, buffer, maxLen, index);
+  });
+  response->addHeader("Cache-Control", "no-cache");
+  clients++;
+  request->onDisconnect([](){
+    EventService :: getEventServiceInstance()->clients--;
+  });
+  request->send(response);
+  debugI("\nEventService :: openStream: Event client connected, %d clients", clients);
+}
+
+size_t EventService :: fillStream(uint32_t* cursor, uint8_t* buffer, const size_t maxLen, const size_t index){
+  size_t length = 0;
+  if(index == 0){
+    int written = snprintf((char*)buffer, maxLen, "retry: %d\n\n", EVENTS_RECONNECT_IN_MILLISECONDS);
+    if(written > 0 && (size_t)written < maxLen)
+      length = written;
+  }
+
+  struct ServerEvent event;
+  while(readEvent(cursor, &event)){
+    int written = snprintf((char*)buffer + length, maxLen - length, "id: %u\nevent: %s\ndata: %s\n\n",
+                                                     event.id, event.name, event.data);
+    //Event that does not fit goes out with the next chunk
+    if(written < 0 || (size_t)written >= maxLen - length){
+      *cursor = event.id - 1;
+      break;
+    }
+    length += written;
+  }
+
+  //Empty chunk would end the stream, the connection poll asks again
+  return (length > 0) ? length : RESPONSE_TRY_AGAIN;
+}
+
+void EventService :: onWiFiEvent(WiFiEvent_t event){
+  EventService* service = EventService :: getEventServiceInstance();
+  switch(event){
+    case SYSTEM_EVENT_STA_GOT_IP:
+      service->publish("wifi", "{\"status\":\"connected\",\"ip\":\"%s\"}", WiFi.localIP().toString().c_str());
+      break;
+    case SYSTEM_EVENT_STA_DISCONNECTED:
+      service->publish("wifi", "{\"status\":\"disconnected\"}");
+      break;
+    default:
+      break;
+  }
+}
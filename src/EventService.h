@@ -0,0 +1,50 @@
+/*
+  EventService.h - Class and Methods to push action outcomes, offline action drains,
+                   device state and connectivity changes to Webserver clients as
+                   Server-Sent Events
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef EventService_h
+#define EventService_h
+#include "BoTESP32SDK.h"
+#include <stdarg.h>
+#define EVENTS_END_POINT "/events"
+#define EVENTS_RING_SIZE 16
+#define EVENT_NAME_LENGTH 15
+#define EVENT_DATA_LENGTH 159
+#define EVENTS_MAXIMUM_CLIENTS 4
+#define EVENT_ACTION_ID_LENGTH 40
+#define EVENT_MESSAGE_LENGTH 64
+#define EVENTS_RECONNECT_IN_MILLISECONDS 5000
+
+struct ServerEvent {
+  uint32_t id;
+  char name[EVENT_NAME_LENGTH+1];
+  char data[EVENT_DATA_LENGTH+1];
+};
+
+class EventService {
+  public:
+    static EventService* getEventServiceInstance();
+    void attach(AsyncWebServer* server);
+    void publish(const char* name, const char* format, ...);
+    void publishActionResult(const char* actionID, const byte result, const char* message);
+    void publishDeviceState(const int state);
+    uint32_t getDroppedEvents();
+  private:
+    bool attached;
+    int clients;
+    portMUX_TYPE ringMux;
+    struct ServerEvent ring[EVENTS_RING_SIZE];
+    uint32_t nextEventID;
+    uint32_t droppedEvents;
+    bool readEvent(uint32_t* cursor, struct ServerEvent* event);
+    void openStream(AsyncWebServerRequest* request);
+    size_t fillStream(uint32_t* cursor, uint8_t* buffer, const size_t maxLen, const size_t index);
+    static void escapeJSON(char* out, const size_t size, const char* in);
+    static void onWiFiEvent(WiFiEvent_t event);
+    EventService();
+    static EventService* instance;
+};
+#endif
@@ -0,0 +1,212 @@
+/*
+  GzipWriter.cpp - GzipWriter Class Methods definition to compress data into gzip in RAM
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "GzipWriter.h"
+#include <string.h>
+
+//Base values and extra bits of the deflate length codes 257 - 285 and distance codes 0 - 29
+static const uint16_t LENGTH_BASE[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const uint8_t LENGTH_EXTRA[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint16_t DISTANCE_BASE[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const uint8_t DISTANCE_EXTRA[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+GzipWriter :: GzipWriter(std::vector <uint8_t>& output) : out(output),
+    window(2 * GZIP_WINDOW_SIZE), head(1 << GZIP_HASH_BITS, -1), prev(GZIP_WINDOW_SIZE, 0){
+  position = 0;
+  lookahead = 0;
+  inputSize = 0;
+  crc = 0xffffffff;
+  bitBuffer = 0;
+  bitCount = 0;
+
+  //Header: magic, deflate, no flags, no mtime, no extra flags, unknown OS
+  const uint8_t header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+  out.insert(out.end(), header, header + sizeof(header));
+
+  //Single final block with fixed Huffman codes
+  putBits(1, 1);
+  putBits(1, 2);
+}
+
+size_t GzipWriter :: write(const uint8_t* data, size_t length){
+  crc = crc32(crc, data, length);
+  inputSize += length;
+
+  //Window holds two halves, once full the older half is compressed and dropped
+  size_t remaining = length;
+  while(remaining > 0){
+    int fill = position + lookahead;
+    if(fill == 2 * GZIP_WINDOW_SIZE){
+      deflate(false);
+      slideWindow();
+      fill = position + lookahead;
+    }
+    size_t chunk = 2 * GZIP_WINDOW_SIZE - fill;
+    if(chunk > remaining)
+      chunk = remaining;
+    memcpy(window.data() + fill, data, chunk);
+    lookahead += chunk;
+    data += chunk;
+    remaining -= chunk;
+  }
+  return length;
+}
+
+size_t GzipWriter :: getInputSize(){
+  return inputSize;
+}
+
+void GzipWriter :: finish(){
+  deflate(true);
+
+  //End of block, then trailer with CRC-32 and input size, both little endian
+  putHuffman(0, 7);
+  flushBits();
+  uint32_t checksum = crc ^ 0xffffffff;
+  for(int i = 0; i < 4; i++)
+    out.push_back((checksum >> (8 * i)) & 0xff);
+  for(int i = 0; i < 4; i++)
+    out.push_back((inputSize >> (8 * i)) & 0xff);
+
+  //Scratch space is not needed anymore, give its memory back
+  std::vector <uint8_t>().swap(window);
+  std::vector <int>().swap(head);
+  std::vector <uint16_t>().swap(prev);
+}
+
+void GzipWriter :: deflate(const bool flush){
+  //Without flush a full match worth of input is kept back, it may continue in the next write
+  const int limit = flush ? 0 : GZIP_MAX_MATCH;
+  const uint8_t* data = window.data();
+  while(lookahead > limit){
+    //Hash chains over 3 byte prefixes find earlier occurrences within the window. The chain links
+    //are distances kept in a ring of window size, so they stay valid when the window slides
+    int bestLength = 0;
+    int bestDistance = 0;
+    if(lookahead >= GZIP_MIN_MATCH){
+      int maxLength = (lookahead < GZIP_MAX_MATCH) ? lookahead : GZIP_MAX_MATCH;
+      int candidate = head[hash(data + position)];
+      for(int chain = 0; candidate >= 0 && position - candidate < GZIP_WINDOW_SIZE && chain < GZIP_MAX_CHAIN; chain++){
+        if(data[candidate + bestLength] == data[position + bestLength]){
+          int length = 0;
+          while(length < maxLength && data[candidate + length] == data[position + length])
+            length++;
+          if(length > bestLength){
+            bestLength = length;
+            bestDistance = position - candidate;
+            if(length == maxLength)
+              break;
+          }
+        }
+        uint16_t link = prev[candidate & (GZIP_WINDOW_SIZE - 1)];
+        if(link == 0)
+          break;
+        candidate -= link;
+      }
+    }
+
+    int advance = 1;
+    if(bestLength >= GZIP_MIN_MATCH){
+      putMatch(bestLength, bestDistance);
+      advance = bestLength;
+    }
+    else
+      putLiteral(data[position]);
+
+    //Every position consumed goes into the chains, including those inside a match
+    for(int i = 0; i < advance; i++){
+      if(lookahead >= GZIP_MIN_MATCH)
+        insertHash(position);
+      position++;
+      lookahead--;
+    }
+  }
+}
+
+void GzipWriter :: slideWindow(){
+  //Only called with the current position in the upper half, positions in the chain heads follow the move
+  memmove(window.data(), window.data() + GZIP_WINDOW_SIZE, GZIP_WINDOW_SIZE);
+  position -= GZIP_WINDOW_SIZE;
+  for(size_t i = 0; i < head.size(); i++)
+    head[i] = (head[i] >= GZIP_WINDOW_SIZE) ? (head[i] - GZIP_WINDOW_SIZE) : -1;
+}
+
+void GzipWriter :: insertHash(const int pos){
+  uint32_t h = hash(window.data() + pos);
+  int last = head[h];
+  prev[pos & (GZIP_WINDOW_SIZE - 1)] = (last >= 0 && pos - last < GZIP_WINDOW_SIZE) ? (pos - last) : 0;
+  head[h] = pos;
+}
+
+uint32_t GzipWriter :: hash(const uint8_t* data){
+  return ((data[0] << 16) | (data[1] << 8) | data[2]) * 2654435761u >> (32 - GZIP_HASH_BITS);
+}
+
+//Extra bits and block header go least significant bit first
+void GzipWriter :: putBits(uint32_t value, int length){
+  bitBuffer |= value << bitCount;
+  bitCount += length;
+  while(bitCount >= 8){
+    out.push_back(bitBuffer & 0xff);
+    bitBuffer >>= 8;
+    bitCount -= 8;
+  }
+}
+
+//Huffman codes go most significant bit first
+void GzipWriter :: putHuffman(uint32_t code, int length){
+  uint32_t reversed = 0;
+  for(int i = 0; i < length; i++){
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+  putBits(reversed, length);
+}
+
+void GzipWriter :: putLiteral(int value){
+  if(value < 144)
+    putHuffman(0x30 + value, 8);
+  else
+    putHuffman(0x190 + (value - 144), 9);
+}
+
+void GzipWriter :: putMatch(int length, int distance){
+  int code = 28;
+  while(LENGTH_BASE[code] > length)
+    code--;
+  int symbol = 257 + code;
+  if(symbol < 280)
+    putHuffman(symbol - 256, 7);
+  else
+    putHuffman(0xc0 + (symbol - 280), 8);
+  putBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+  code = 29;
+  while(DISTANCE_BASE[code] > distance)
+    code--;
+  putHuffman(code, 5);
+  putBits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+}
+
+void GzipWriter :: flushBits(){
+  if(bitCount > 0)
+    out.push_back(bitBuffer & 0xff);
+  bitBuffer = 0;
+  bitCount = 0;
+}
+
+//Nibble table driven CRC-32 as used by gzip, 16 entries instead of 256, updated per write
+uint32_t GzipWriter :: crc32(uint32_t crc, const uint8_t* data, size_t length){
+  static const uint32_t table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+  };
+  for(size_t i = 0; i < length; i++){
+    crc ^= data[i];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+    crc = (crc >> 4) ^ table[crc & 0x0f];
+  }
+  return crc;
+}
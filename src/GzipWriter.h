@@ -0,0 +1,51 @@
+/*
+  GzipWriter.h - Compresses written bytes into a gzip stream in RAM as they arrive,
+                 using LZ77 matching and the fixed Huffman codes of deflate
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef GzipWriter_h
+#define GzipWriter_h
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define GZIP_HASH_BITS 10
+#define GZIP_WINDOW_SIZE 4096
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+#define GZIP_MAX_CHAIN 32
+
+//Input side is write(const uint8_t*, size_t), so it can be the output of writeQRCodeSVG.
+//Only the last window of input is kept, compressed bytes are appended to output as they are produced
+class GzipWriter {
+  public:
+    GzipWriter(std::vector <uint8_t>& output);
+    size_t write(const uint8_t* data, size_t length);
+    size_t getInputSize();
+    //Compresses the input still pending and appends end of block and gzip trailer to output
+    void finish();
+  private:
+    std::vector <uint8_t>& out;
+    std::vector <uint8_t> window;
+    std::vector <int> head;
+    std::vector <uint16_t> prev;
+    int position;
+    int lookahead;
+    uint32_t inputSize;
+    uint32_t crc;
+    uint32_t bitBuffer;
+    int bitCount;
+    void deflate(const bool flush);
+    void slideWindow();
+    void insertHash(const int pos);
+    void putBits(uint32_t value, int length);
+    void putHuffman(uint32_t code, int length);
+    void putLiteral(int value);
+    void putMatch(int length, int distance);
+    void flushBits();
+    static uint32_t hash(const uint8_t* data);
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length);
+};
+
+#endif
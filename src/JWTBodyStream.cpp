@@ -0,0 +1,107 @@
+/*
+  JWTBodyStream.cpp - JWTBodyStream Class Methods definition to stream the JWT request body
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "JWTBodyStream.h"
+
+JWTBodyStream :: JWTBodyStream(const char* encodedHeader, const char* payload, const size_t payloadLength,
+                                                  const uint8_t* signature, const size_t signatureLength){
+  setPart(0, JWT_BODY_PREFIX, strlen(JWT_BODY_PREFIX), false);
+  setPart(1, encodedHeader, strlen(encodedHeader), false);
+  setPart(2, ".", 1, false);
+  setPart(3, payload, payloadLength, true);
+  setPart(4, ".", 1, false);
+  setPart(5, signature, signatureLength, true);
+  setPart(6, JWT_BODY_SUFFIX, strlen(JWT_BODY_SUFFIX), false);
+
+  length = 0;
+  for(int i = 0; i < JWT_BODY_PARTS; i++)
+    length += (parts[i].encode)?BASE64URL_ENCODED_LENGTH(parts[i].length):parts[i].length;
+
+  part = 0;
+  offset = 0;
+  sent = 0;
+  chunkLength = 0;
+  chunkPos = 0;
+}
+
+void JWTBodyStream :: setPart(int index, const void* data, const size_t size, const bool encode){
+  parts[index].data = (const uint8_t*)data;
+  parts[index].length = size;
+  parts[index].encode = encode;
+}
+
+size_t JWTBodyStream :: getLength(){
+  return length;
+}
+
+int JWTBodyStream :: available(){
+  return length - sent;
+}
+
+//Makes sure the chunk has unread characters, encoding the next slice of the current part if needed
+bool JWTBodyStream :: fillChunk(){
+  while(chunkPos == chunkLength){
+    if(part >= JWT_BODY_PARTS)
+      return false;
+    const struct BodyPart* current = &parts[part];
+    if(offset >= current->length){
+      part++;
+      offset = 0;
+      continue;
+    }
+
+    size_t remaining = current->length - offset;
+    if(current->encode){
+      size_t size = (remaining < JWT_STREAM_CHUNK_INPUT)?remaining:JWT_STREAM_CHUNK_INPUT;
+      unsigned int encodedLength = 0;
+      base64url_encode(current->data + offset, size, chunk, sizeof(chunk), &encodedLength);
+      chunkLength = encodedLength;
+      offset += size;
+    }
+    else {
+      size_t size = (remaining < JWT_STREAM_CHUNK_SIZE)?remaining:JWT_STREAM_CHUNK_SIZE;
+      memcpy(chunk, current->data + offset, size);
+      chunkLength = size;
+      offset += size;
+    }
+    chunkPos = 0;
+  }
+  return true;
+}
+
+int JWTBodyStream :: read(){
+  if(!fillChunk())
+    return -1;
+  sent++;
+  return (uint8_t)chunk[chunkPos++];
+}
+
+int JWTBodyStream :: peek(){
+  if(!fillChunk())
+    return -1;
+  return (uint8_t)chunk[chunkPos];
+}
+
+size_t JWTBodyStream :: readBytes(char* buffer, size_t size){
+  size_t copied = 0;
+  while(copied < size && fillChunk()){
+    size_t count = chunkLength - chunkPos;
+    if(count > size - copied)
+      count = size - copied;
+    memcpy(buffer + copied, chunk + chunkPos, count);
+    chunkPos += count;
+    copied += count;
+  }
+  sent += copied;
+  return copied;
+}
+
+//Body is read only
+size_t JWTBodyStream :: write(uint8_t){
+  return 0;
+}
+
+void JWTBodyStream :: flush(){
+}
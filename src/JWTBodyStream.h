@@ -0,0 +1,51 @@
+/*
+  JWTBodyStream.h - Stream producing the {"bot": "<JWT>"} request body in chunks, base64url encoding
+                    payload and signature on the fly, with its length known before sending
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef JWTBodyStream_h
+#define JWTBodyStream_h
+#include <Arduino.h>
+#include "base64url.h"
+
+//base64url of {"alg":"RS256","typ":"JWT"}, the header of every JWT sent to BoT Service
+#define JWT_HEADER_ENCODED "eyJhbGciOiJSUzI1NiIsInR5cCI6IkpXVCJ9"
+#define JWT_BODY_PREFIX "{\"bot\": \""
+#define JWT_BODY_SUFFIX "\"}"
+#define JWT_BODY_PARTS 7
+//Encoded characters per chunk, a multiple of 4 so that chunks split the input on 3 byte groups
+#define JWT_STREAM_CHUNK_SIZE 256
+#define JWT_STREAM_CHUNK_INPUT (JWT_STREAM_CHUNK_SIZE / 4 * 3)
+
+class JWTBodyStream : public Stream {
+  public:
+    JWTBodyStream(const char* encodedHeader, const char* payload, const size_t payloadLength,
+                                      const uint8_t* signature, const size_t signatureLength);
+    //Content-Length of the body, computed from the part lengths without encoding anything
+    size_t getLength();
+    int available();
+    int read();
+    int peek();
+    size_t readBytes(char* buffer, size_t length);
+    size_t write(uint8_t);
+    void flush();
+  private:
+    struct BodyPart {
+      const uint8_t* data;
+      size_t length;
+      bool encode;
+    };
+    struct BodyPart parts[JWT_BODY_PARTS];
+    int part;
+    size_t offset;
+    size_t length;
+    size_t sent;
+    char chunk[JWT_STREAM_CHUNK_SIZE + 1];
+    size_t chunkLength;
+    size_t chunkPos;
+    void setPart(int index, const void* data, const size_t size, const bool encode);
+    bool fillChunk();
+};
+
+#endif
@@ -0,0 +1,294 @@
+/*
+  JobService.cpp - Class and Methods to trigger actions in the background on behalf
+                   of Webserver End Points and track the outcome of each job
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "JobService.h"
+JobService* JobService :: instance = NULL;
+
+JobService* JobService :: getJobServiceInstance(){
+  if(instance == NULL){
+    instance = new JobService();
+    debugI("\nJobService : getJobServiceInstance: JobService instance created...");
+  }
+  return instance;
+}
+
+JobService :: JobService(){
+  actionService = ActionService :: getActionServiceInstance();
+  store = KeyStore :: getKeyStoreInstance();
+  memset(jobs, 0, sizeof(jobs));
+  nextJobID = 1;
+  nextBatchID = 1;
+  highLaneServed = 0;
+  jobsMutex = xSemaphoreCreateMutex();
+  jobsPending = xSemaphoreCreateCounting(MAXIMUM_JOBS, 0);
+  for(byte lane = 0; lane < ACTION_PRIORITY_LANES; lane++)
+    laneQueues[lane] = xQueueCreate(MAXIMUM_JOBS, sizeof(unsigned long));
+
+  //Actions are triggered from this task, keeps async_tcp task free from BoT Service latency
+  workerTask = NULL;
+  xTaskCreatePinnedToCore(jobWorker, "actionJobs", JOB_WORKER_STACK_SIZE, this,
+                                JOB_WORKER_PRIORITY, &workerTask, JOB_WORKER_CORE);
+}
+
+const char* JobService :: getJobStatusMsg(const byte status){
+  switch(status){
+    case JOB_QUEUED : return "queued";
+    case JOB_RUNNING : return "running";
+    case JOB_SUCCEEDED : return "succeeded";
+    case JOB_SAVED_OFFLINE : return "offline";
+    case JOB_FAILED : return "failed";
+    default : return "unknown";
+  }
+}
+
+struct ActionJob* JobService :: findJob(const unsigned long jobID){
+  for(int i = 0; i < MAXIMUM_JOBS; i++){
+    if(jobs[i].status != JOB_FREE && jobs[i].jobID == jobID)
+      return &jobs[i];
+  }
+  return NULL;
+}
+
+struct ActionJob* JobService :: allocateJob(){
+  //Prefer a free slot, otherwise recycle the job finished longest ago
+  struct ActionJob* oldest = NULL;
+  for(int i = 0; i < MAXIMUM_JOBS; i++){
+    if(jobs[i].status == JOB_FREE)
+      return &jobs[i];
+    if(jobs[i].status >= JOB_SUCCEEDED &&
+       (oldest == NULL || jobs[i].finishedTime < oldest->finishedTime))
+      oldest = &jobs[i];
+  }
+  return oldest;
+}
+
+int JobService :: countAvailableJobs(){
+  int available = 0;
+  for(int i = 0; i < MAXIMUM_JOBS; i++){
+    if(jobs[i].status == JOB_FREE || jobs[i].status >= JOB_SUCCEEDED)
+      available++;
+  }
+  return available;
+}
+
+bool JobService :: fillJob(struct ActionJob* job, const char* actionID, const char* value,
+                                    const char* altID, const byte priority){
+  if(actionID == NULL || strlen(actionID) == 0 || strlen(actionID) > JOB_ACTION_ID_LENGTH ||
+     (value != NULL && strlen(value) > JOB_VALUE_LENGTH) ||
+     (altID != NULL && strlen(altID) > JOB_ALT_ID_LENGTH))
+    return false;
+
+  const byte lane = (priority == ACTION_PRIORITY_DEFAULT)?store->getActionPriority(actionID):priority;
+  memset(job, 0, sizeof(struct ActionJob));
+  job->jobID = nextJobID++;
+  job->status = JOB_QUEUED;
+  job->priority = (lane == ACTION_PRIORITY_HIGH)?ACTION_PRIORITY_HIGH:ACTION_PRIORITY_LOW;
+  strcpy(job->actionID, actionID);
+  if(value != NULL){
+    strcpy(job->value, value);
+    job->hasValue = true;
+  }
+  if(altID != NULL){
+    strcpy(job->altID, altID);
+    job->hasAltID = true;
+  }
+  job->queuedTime = millis();
+  return true;
+}
+
+unsigned long JobService :: enqueueAction(const char* actionID, const char* value, const byte priority){
+  unsigned long jobID = 0;
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  struct ActionJob* job = allocateJob();
+  if(job != NULL && !fillJob(job, actionID, value, NULL, priority)){
+    debugE("\nJobService :: enqueueAction: Invalid actionID / value given");
+    xSemaphoreGive(jobsMutex);
+    return 0;
+  }
+  if(job != NULL){
+    if(xQueueSend(laneQueues[job->priority], &(job->jobID), 0) == pdTRUE){
+      jobID = job->jobID;
+    }
+    else {
+      job->status = JOB_FREE;
+    }
+  }
+  xSemaphoreGive(jobsMutex);
+
+  if(jobID != 0){
+    xSemaphoreGive(jobsPending);
+    debugI("\nJobService :: enqueueAction: Action %s queued as job %lu",actionID,jobID);
+  }
+  else {
+    debugE("\nJobService :: enqueueAction: No room to queue action %s",actionID);
+  }
+  return jobID;
+}
+
+bool JobService :: getJob(const unsigned long jobID, struct ActionJob* job){
+  bool found = false;
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  struct ActionJob* j = findJob(jobID);
+  if(j != NULL){
+    memcpy(job, j, sizeof(struct ActionJob));
+    found = true;
+  }
+  xSemaphoreGive(jobsMutex);
+  return found;
+}
+
+bool JobService :: dequeueJob(unsigned long* jobID){
+  //Weighted round robin between the lanes, same weights as offline actions
+  if(highLaneServed < PRIORITY_HIGH_LANE_WEIGHT &&
+     xQueueReceive(laneQueues[ACTION_PRIORITY_HIGH], jobID, 0) == pdTRUE){
+    highLaneServed++;
+    return true;
+  }
+  highLaneServed = 0;
+  if(xQueueReceive(laneQueues[ACTION_PRIORITY_LOW], jobID, 0) == pdTRUE)
+    return true;
+  return (xQueueReceive(laneQueues[ACTION_PRIORITY_HIGH], jobID, 0) == pdTRUE);
+}
+
+void JobService :: runJob(const unsigned long jobID){
+  struct ActionJob job;
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  struct ActionJob* j = findJob(jobID);
+  if(j != NULL){
+    j->status = JOB_RUNNING;
+    memcpy(&job, j, sizeof(struct ActionJob));
+  }
+  xSemaphoreGive(jobsMutex);
+  if(j == NULL)
+    return;
+
+  if(job.batchID != 0){
+    runBatch(job.batchID);
+    return;
+  }
+
+  debugD("\nJobService :: runJob: Triggering action %s for job %lu",job.actionID,jobID);
+  char message[JOB_MESSAGE_LENGTH+1];
+  byte status = JOB_FAILED;
+  switch(actionService->triggerAction(job.actionID, job.hasValue?job.value:NULL, job.priority, NULL, message)){
+    case ACTION_RESULT_SUCCEEDED : status = JOB_SUCCEEDED; break;
+    case ACTION_RESULT_OFFLINE : status = JOB_SAVED_OFFLINE; break;
+    default : status = JOB_FAILED; break;
+  }
+
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  j = findJob(jobID);
+  if(j != NULL){
+    j->status = status;
+    strncpy(j->message, message, JOB_MESSAGE_LENGTH);
+    j->message[JOB_MESSAGE_LENGTH] = '\0';
+    j->finishedTime = millis();
+  }
+  xSemaphoreGive(jobsMutex);
+
+  debugI("\nJobService :: runJob: Job %lu for action %s %s: %s",jobID,job.actionID,getJobStatusMsg(status),message);
+  debugI("\nJobService :: runJob: Number of offline actions triggered: %d",actionService->getOfflineActionsTriggerCount());
+  debugI("\nJobService :: runJob: Number of actions triggered: %d",actionService->getActionsTriggerCount());
+}
+
+bool JobService :: enqueueBatch(const struct ActionBatchItem* items, const int count, unsigned long* jobIDs){
+  if(count <= 0 || count > BATCH_MAXIMUM_ACTIONS)
+    return false;
+
+  bool queued = false;
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  //Either the whole batch gets queued or nothing
+  if(countAvailableJobs() >= count){
+    const unsigned long batchID = nextBatchID++;
+    byte lane = ACTION_PRIORITY_LOW;
+    struct ActionJob* first = NULL;
+    int filled = 0;
+    for(; filled < count; filled++){
+      struct ActionJob* job = allocateJob();
+      if(!fillJob(job, items[filled].actionID, items[filled].value, items[filled].altID, items[filled].priority)){
+        job->status = JOB_FREE;
+        break;
+      }
+      job->batchID = batchID;
+      jobIDs[filled] = job->jobID;
+      if(job->priority == ACTION_PRIORITY_HIGH)
+        lane = ACTION_PRIORITY_HIGH;
+      if(first == NULL)
+        first = job;
+    }
+
+    //Batch is served by the worker as one job, through the lane of its most urgent item
+    if(filled == count && xQueueSend(laneQueues[lane], &(first->jobID), 0) == pdTRUE){
+      queued = true;
+    }
+    else {
+      for(int i = 0; i < filled; i++){
+        struct ActionJob* job = findJob(jobIDs[i]);
+        if(job != NULL)
+          job->status = JOB_FREE;
+      }
+    }
+  }
+  xSemaphoreGive(jobsMutex);
+
+  if(queued){
+    xSemaphoreGive(jobsPending);
+    debugI("\nJobService :: enqueueBatch: %d actions queued as one batch",count);
+  }
+  else {
+    debugE("\nJobService :: enqueueBatch: Unable to queue batch of %d actions",count);
+  }
+  return queued;
+}
+
+void JobService :: runBatch(const unsigned long batchID){
+  struct ActionBatchItem* items = batchItems;
+  int count = 0;
+
+  //Running jobs are never recycled, items point into jobs[] until the batch is done
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  for(int i = 0; i < MAXIMUM_JOBS && count < BATCH_MAXIMUM_ACTIONS; i++){
+    if(jobs[i].batchID == batchID && jobs[i].status >= JOB_QUEUED && jobs[i].status <= JOB_RUNNING){
+      jobs[i].status = JOB_RUNNING;
+      batchJobIDs[count] = jobs[i].jobID;
+      items[count].actionID = jobs[i].actionID;
+      items[count].value = jobs[i].hasValue?jobs[i].value:NULL;
+      items[count].altID = jobs[i].hasAltID?jobs[i].altID:NULL;
+      items[count].priority = jobs[i].priority;
+      count++;
+    }
+  }
+  xSemaphoreGive(jobsMutex);
+
+  debugD("\nJobService :: runBatch: Triggering batch %lu with %d actions",batchID,count);
+  actionService->triggerActionBatch(items, count);
+
+  xSemaphoreTake(jobsMutex, portMAX_DELAY);
+  for(int i = 0; i < count; i++){
+    struct ActionJob* job = findJob(batchJobIDs[i]);
+    if(job == NULL)
+      continue;
+    switch(items[i].result){
+      case ACTION_RESULT_SUCCEEDED : job->status = JOB_SUCCEEDED; break;
+      case ACTION_RESULT_OFFLINE : job->status = JOB_SAVED_OFFLINE; break;
+      default : job->status = JOB_FAILED; break;
+    }
+    strcpy(job->message, items[i].message);
+    job->finishedTime = millis();
+  }
+  xSemaphoreGive(jobsMutex);
+  debugI("\nJobService :: runBatch: Batch %lu with %d actions done",batchID,count);
+}
+
+void JobService :: jobWorker(void* param){
+  JobService* service = (JobService*)param;
+  unsigned long jobID = 0;
+  for(;;){
+    xSemaphoreTake(service->jobsPending, portMAX_DELAY);
+    if(service->dequeueJob(&jobID))
+      service->runJob(jobID);
+  }
+}
@@ -0,0 +1,81 @@
+/*
+  JobService.h - Class and Methods to trigger actions in the background on behalf
+                 of Webserver End Points and track the outcome of each job
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef JobService_h
+#define JobService_h
+#include "BoTESP32SDK.h"
+#include "ActionService.h"
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+#define MAXIMUM_JOBS 24
+#define BATCH_MAXIMUM_ACTIONS 16
+#define JOB_ACTION_ID_LENGTH 40
+#define JOB_VALUE_LENGTH 16
+#define JOB_ALT_ID_LENGTH 40
+#define JOB_MESSAGE_LENGTH ACTION_RESULT_MESSAGE_LENGTH
+#define JOB_WORKER_STACK_SIZE 10240
+#define JOB_WORKER_PRIORITY 1
+#define JOB_WORKER_CORE 1
+
+#define JOB_FREE 0
+#define JOB_QUEUED 1
+#define JOB_RUNNING 2
+#define JOB_SUCCEEDED 3
+#define JOB_SAVED_OFFLINE 4
+#define JOB_FAILED 5
+
+class ActionService;
+
+struct ActionJob {
+  unsigned long jobID;
+  unsigned long batchID;
+  byte status;
+  byte priority;
+  char actionID[JOB_ACTION_ID_LENGTH+1];
+  char value[JOB_VALUE_LENGTH+1];
+  bool hasValue;
+  char altID[JOB_ALT_ID_LENGTH+1];
+  bool hasAltID;
+  char message[JOB_MESSAGE_LENGTH+1];
+  unsigned long queuedTime;
+  unsigned long finishedTime;
+};
+
+class JobService {
+  public:
+    static JobService* getJobServiceInstance();
+    unsigned long enqueueAction(const char* actionID, const char* value = NULL,
+                                     const byte priority = ACTION_PRIORITY_DEFAULT);
+    bool enqueueBatch(const struct ActionBatchItem* items, const int count, unsigned long* jobIDs);
+    bool getJob(const unsigned long jobID, struct ActionJob* job);
+    static const char* getJobStatusMsg(const byte status);
+  private:
+    ActionService* actionService;
+    KeyStore* store;
+    struct ActionJob jobs[MAXIMUM_JOBS];
+    unsigned long nextJobID;
+    unsigned long nextBatchID;
+    int highLaneServed;
+    SemaphoreHandle_t jobsMutex;
+    SemaphoreHandle_t jobsPending;
+    QueueHandle_t laneQueues[ACTION_PRIORITY_LANES];
+    TaskHandle_t workerTask;
+    //Working set of the batch being run, only ever touched by the single worker
+    struct ActionBatchItem batchItems[BATCH_MAXIMUM_ACTIONS];
+    unsigned long batchJobIDs[BATCH_MAXIMUM_ACTIONS];
+    struct ActionJob* findJob(const unsigned long jobID);
+    struct ActionJob* allocateJob();
+    int countAvailableJobs();
+    bool fillJob(struct ActionJob* job, const char* actionID, const char* value,
+                           const char* altID, const byte priority);
+    bool dequeueJob(unsigned long* jobID);
+    void runJob(const unsigned long jobID);
+    void runBatch(const unsigned long batchID);
+    static void jobWorker(void* param);
+    JobService();
+    static JobService* instance;
+};
+#endif
@@ -0,0 +1,130 @@
+/*
+  Metrics.cpp - Lock free latency histograms and request phase tracing
+                for the calls made to BoT Service
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "Metrics.h"
+
+static const uint32_t bucketBounds[LATENCY_HISTOGRAM_BUCKETS-1] = LATENCY_BUCKET_BOUNDS;
+static const char* endPointNames[METRICS_END_POINTS] = {"/actions", "/pair", "/status", "other"};
+static const char* phaseNames[REQUEST_PHASES] = {"dns", "connect", "verify", "sign", "send", "first_byte", "body", "decode"};
+
+LatencyHistogram :: LatencyHistogram(){
+  memset(buckets, 0, sizeof(buckets));
+  sum = 0;
+}
+
+void LatencyHistogram :: record(const uint32_t latency){
+  byte bucket = 0;
+  while(bucket < LATENCY_HISTOGRAM_BUCKETS-1 && latency > bucketBounds[bucket])
+    bucket++;
+
+  //Atomic adds, so readers from other tasks never need a lock
+  __atomic_fetch_add(&buckets[bucket], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&sum, latency, __ATOMIC_RELAXED);
+}
+
+uint32_t LatencyHistogram :: getBucketCount(const byte bucket) const {
+  if(bucket >= LATENCY_HISTOGRAM_BUCKETS)
+    return 0;
+  return __atomic_load_n(&buckets[bucket], __ATOMIC_RELAXED);
+}
+
+uint32_t LatencyHistogram :: getCount() const {
+  uint32_t count = 0;
+  for(byte i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    count += getBucketCount(i);
+  return count;
+}
+
+uint32_t LatencyHistogram :: getSum() const {
+  return __atomic_load_n(&sum, __ATOMIC_RELAXED);
+}
+
+uint32_t LatencyHistogram :: getBucketBound(const byte bucket){
+  if(bucket >= LATENCY_HISTOGRAM_BUCKETS-1)
+    return UINT32_MAX;
+  return bucketBounds[bucket];
+}
+
+RequestTracer :: RequestTracer(){
+  memset(&trace, 0, sizeof(trace));
+  memset(&lastTrace, 0, sizeof(lastTrace));
+  connectCount = 0;
+  connectFailureCount = 0;
+}
+
+byte RequestTracer :: getEndPointIndex(const char* endPoint){
+  for(byte i = 0; i < METRICS_OTHER; i++){
+    if(strcmp(endPoint, endPointNames[i]) == 0)
+      return i;
+  }
+  return METRICS_OTHER;
+}
+
+const char* RequestTracer :: getEndPointName(const byte endPoint){
+  return (endPoint < METRICS_END_POINTS)?endPointNames[endPoint]:NULL;
+}
+
+const char* RequestTracer :: getPhaseName(const byte phase){
+  return (phase < REQUEST_PHASES)?phaseNames[phase]:NULL;
+}
+
+void RequestTracer :: begin(const char* endPoint){
+  memset(&trace, 0, sizeof(trace));
+  trace.endPoint = getEndPointIndex(endPoint);
+  trace.startTime = millis();
+  trace.lastMarkTime = trace.startTime;
+}
+
+void RequestTracer :: mark(const byte phase){
+  unsigned long now = millis();
+  if(phase < REQUEST_PHASES)
+    trace.phases[phase] += now - trace.lastMarkTime;
+  trace.lastMarkTime = now;
+}
+
+void RequestTracer :: resume(){
+  //Restart the phase clock without accounting the elapsed time to any phase
+  trace.lastMarkTime = millis();
+}
+
+void RequestTracer :: setHTTPCode(const int httpCode){
+  trace.httpCode = httpCode;
+}
+
+void RequestTracer :: end(){
+  trace.total = millis() - trace.startTime;
+  histograms[trace.endPoint].record(trace.total);
+  lastTrace = trace;
+  debugD("\nRequestTracer :: end: %s returned %d in %u ms (dns %u, connect %u, verify %u, sign %u, send %u, first byte %u, body %u, decode %u)",
+            endPointNames[trace.endPoint], trace.httpCode, trace.total, trace.phases[PHASE_DNS], trace.phases[PHASE_CONNECT],
+            trace.phases[PHASE_VERIFY], trace.phases[PHASE_SIGN], trace.phases[PHASE_SEND], trace.phases[PHASE_FIRST_BYTE],
+            trace.phases[PHASE_BODY], trace.phases[PHASE_DECODE]);
+}
+
+void RequestTracer :: recordConnect(const bool connected){
+  //Every BoT Service call sets up a fresh TLS session, hence each one is a reconnect
+  __atomic_fetch_add(&connectCount, 1, __ATOMIC_RELAXED);
+  if(!connected)
+    __atomic_fetch_add(&connectFailureCount, 1, __ATOMIC_RELAXED);
+}
+
+uint32_t RequestTracer :: getConnectCount(){
+  return __atomic_load_n(&connectCount, __ATOMIC_RELAXED);
+}
+
+uint32_t RequestTracer :: getConnectFailureCount(){
+  return __atomic_load_n(&connectFailureCount, __ATOMIC_RELAXED);
+}
+
+const struct RequestTrace* RequestTracer :: getLastTrace(){
+  return &lastTrace;
+}
+
+const LatencyHistogram* RequestTracer :: getHistogram(const byte endPoint){
+  if(endPoint >= METRICS_END_POINTS)
+    return NULL;
+  return &histograms[endPoint];
+}
@@ -0,0 +1,80 @@
+/*
+  Metrics.h - Lock free latency histograms and request phase tracing
+              for the calls made to BoT Service
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef Metrics_h
+#define Metrics_h
+#include "BoTESP32SDK.h"
+
+//Upper bounds of the histogram buckets in milliseconds, last bucket is open ended
+#define LATENCY_BUCKET_BOUNDS {50, 100, 250, 500, 1000, 2500, 5000, 10000}
+#define LATENCY_HISTOGRAM_BUCKETS 9
+
+//BoT Service endpoints tracked with their own histogram
+#define METRICS_ACTIONS 0
+#define METRICS_PAIRING 1
+#define METRICS_ACTIVATION 2
+#define METRICS_OTHER 3
+#define METRICS_END_POINTS 4
+
+//Phases of a single BoT Service call, HTTPClient writes the request and waits for
+//the status line in one call, hence PHASE_FIRST_BYTE covers both while PHASE_SEND
+//covers preparing the request. Without HTTPS, TCP connect also falls into PHASE_FIRST_BYTE
+#define PHASE_DNS 0
+#define PHASE_CONNECT 1
+#define PHASE_VERIFY 2
+#define PHASE_SIGN 3
+#define PHASE_SEND 4
+#define PHASE_FIRST_BYTE 5
+#define PHASE_BODY 6
+#define PHASE_DECODE 7
+#define REQUEST_PHASES 8
+
+class LatencyHistogram {
+  public:
+    LatencyHistogram();
+    void record(const uint32_t latency);
+    uint32_t getBucketCount(const byte bucket) const;
+    uint32_t getCount() const;
+    uint32_t getSum() const;
+    static uint32_t getBucketBound(const byte bucket);
+  private:
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+    uint32_t sum;
+};
+
+struct RequestTrace {
+  byte endPoint;
+  int httpCode;
+  unsigned long startTime;
+  unsigned long lastMarkTime;
+  uint32_t phases[REQUEST_PHASES];
+  uint32_t total;
+};
+
+class RequestTracer {
+  public:
+    RequestTracer();
+    void begin(const char* endPoint);
+    void resume();
+    void mark(const byte phase);
+    void setHTTPCode(const int httpCode);
+    void end();
+    void recordConnect(const bool connected);
+    uint32_t getConnectCount();
+    uint32_t getConnectFailureCount();
+    const struct RequestTrace* getLastTrace();
+    const LatencyHistogram* getHistogram(const byte endPoint);
+    static byte getEndPointIndex(const char* endPoint);
+    static const char* getEndPointName(const byte endPoint);
+    static const char* getPhaseName(const byte phase);
+  private:
+    struct RequestTrace trace;
+    struct RequestTrace lastTrace;
+    LatencyHistogram histograms[METRICS_END_POINTS];
+    uint32_t connectCount;
+    uint32_t connectFailureCount;
+};
+#endif
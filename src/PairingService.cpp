@@ -22,12 +22,79 @@ bool PairingService :: isPairable(){
   return (store->getDeviceState() == DEVICE_NEW?true:false);
 }
 
-String* PairingService :: getPairingStatus(){
-  String* response = bot->get(PAIRING_END_POINT);
-  debugD("\nPairingService :: getPairingStatus : %s", response->c_str());
+String PairingService :: getPairingStatus(){
+  String response = bot->get(PAIRING_END_POINT);
+  debugD("\nPairingService :: getPairingStatus : %s", response.c_str());
   return response;
 }
 
+bool PairingService :: checkPairingStatus(){
+  //Single check without waiting, caller decides when to check again
+  store->initializeEEPROM();
+  if(isPairable() == false)
+    return false;
+
+  String response = getPairingStatus();
+  if(response.indexOf("true") == -1)
+    return false;
+
+  if(!isMultipair()){
+    store->setDeviceState(DEVICE_PAIRED);
+    debugI("\nPairingService :: checkPairingStatus: Device successfully paired. Ready to activate.");
+  }
+  return true;
+}
+
+bool PairingService :: isPersistedStateValid(){
+  //Device activated or multipaired earlier with same configuration can skip pairing check on boot
+  store->initializeEEPROM();
+  int state = store->getDeviceState();
+  if(store->isDeviceMultipair())
+    return (state == DEVICE_MULTIPAIR);
+  return (state == DEVICE_ACTIVE);
+}
+
+byte PairingService :: verifyPairingStatus(){
+  //Only an explicit answer from BoT Service counts, failed calls leave status unknown
+  String response = getPairingStatus();
+  if(response.indexOf("true") != -1)
+    return PAIRING_STATUS_PAIRED;
+  if(response.indexOf("false") != -1)
+    return PAIRING_STATUS_NOT_PAIRED;
+  return PAIRING_STATUS_UNKNOWN;
+}
+
+void PairingService :: startPairingVerification(){
+  xTaskCreate(pairingVerifier, "pairingVerifier", PAIRING_VERIFY_STACK_SIZE, NULL,
+                                                   PAIRING_VERIFY_PRIORITY, NULL);
+}
+
+void PairingService :: pairingVerifier(void* param){
+  PairingService* ps = new PairingService();
+  PollingPolicy policy(ps->store->getPollingInitialInterval(), ps->store->getPollingMaximumInterval());
+  byte status = PAIRING_STATUS_UNKNOWN;
+  for(int attempt = 1; attempt <= PAIRING_VERIFY_MAX_ATTEMPTS; attempt++){
+    status = ps->verifyPairingStatus();
+    if(status != PAIRING_STATUS_UNKNOWN)
+      break;
+    policy.wait();
+  }
+
+  if(status == PAIRING_STATUS_NOT_PAIRED){
+    debugW("\nPairingService :: pairingVerifier: BoT Service reports device not paired, resetting device state");
+    ps->store->resetDeviceState();
+    ps->store->resetQRCodeStatus();
+    BoTService :: getBoTServiceInstance()->resetSigningKey();
+  }
+  else if(status == PAIRING_STATUS_PAIRED)
+    debugI("\nPairingService :: pairingVerifier: Persisted device state confirmed by BoT Service");
+  else
+    debugW("\nPairingService :: pairingVerifier: Unable to verify pairing status, keeping persisted device state");
+
+  delete ps;
+  vTaskDelete(NULL);
+}
+
 bool PairingService :: pollPairingStatus(){
   if (isPairable() == false) {
       return false;
@@ -35,15 +102,17 @@ bool PairingService :: pollPairingStatus(){
 
   debugD("\nPairingService :: pollPairingStatus: Started polling BoT for pairing status for the device...");
   int counter = 1;
-  String* response;
+  String response;
+  PollingPolicy policy(store->getPollingInitialInterval(), store->getPollingMaximumInterval());
   do {
     debugD("\nPairingService :: pollPairingStatus: Checking pairing status, attempt %d of %d", counter,MAXIMUM_TRIES);
     response = getPairingStatus();
-    if(response->indexOf("true") != -1){
+    if(response.indexOf("true") != -1){
       return true;
     }
     ++counter;
-    delay(POLLING_INTERVAL_IN_MILLISECONDS);
+    if(counter <= MAXIMUM_TRIES)
+      policy.wait();
   }while(counter <= MAXIMUM_TRIES);
 
    return false;
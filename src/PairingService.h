@@ -10,20 +10,30 @@
 #include "Storage.h"
 #include "BoTService.h"
 #include "ActivationService.h"
-#define POLLING_INTERVAL_IN_MILLISECONDS 5000
 #define MAXIMUM_TRIES 2
 #define PAIRING_END_POINT "/pair"
+#define PAIRING_STATUS_UNKNOWN 0
+#define PAIRING_STATUS_PAIRED 1
+#define PAIRING_STATUS_NOT_PAIRED 2
+#define PAIRING_VERIFY_MAX_ATTEMPTS 5
+#define PAIRING_VERIFY_STACK_SIZE 8192
+#define PAIRING_VERIFY_PRIORITY 1
 
 class PairingService {
   public:
     PairingService();
     void pairDevice();
-    String* getPairingStatus();
+    String getPairingStatus();
+    bool checkPairingStatus();
+    bool isPersistedStateValid();
+    byte verifyPairingStatus();
+    static void startPairingVerification();
   private:
     KeyStore *store;
     BoTService *bot;
     bool isPairable();
     bool isMultipair();
     bool pollPairingStatus();
+    static void pairingVerifier(void* param);
 };
 #endif
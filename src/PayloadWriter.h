@@ -0,0 +1,167 @@
+/*
+  PayloadWriter.h - Writers for the fixed JSON payloads posted to BoT Service, counting the exact
+                    length while writing into a caller provided buffer, without any heap allocation
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef PayloadWriter_h
+#define PayloadWriter_h
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define PAYLOAD_VALUE_DECIMALS 6
+#define PAYLOAD_VALUE_SCALE 1000000UL
+#define PAYLOAD_VALUE_MAX 1e15
+#define ACTION_PAYLOAD_BUFFER_SIZE 512
+#define ACTIVATION_PAYLOAD_BUFFER_SIZE 128
+
+//Characters past the end of the buffer are counted but not written, so length() is exact either way
+class PayloadWriter {
+  public:
+    PayloadWriter(char* buffer, const size_t size) : out(buffer), capacity(size), used(0), valid(true) {}
+
+    //Keys and punctuation of the schema, their lengths are compile time constants
+    template <size_t N>
+    void literal(const char (&text)[N]){
+      raw(text, N - 1);
+    }
+
+    //Quoted string with '"', '\' and control characters escaped, NULL as null
+    void string(const char* text){
+      if(text == NULL){
+        literal("null");
+        return;
+      }
+      put('"');
+      for(const unsigned char* c = (const unsigned char*)text; *c != '\0'; c++){
+        if(*c == '"' || *c == '\\'){
+          put('\\');
+          put(*c);
+        }
+        else if(*c < 0x20){
+          static const char hex[] = "0123456789abcdef";
+          literal("\\u00");
+          put(hex[*c >> 4]);
+          put(hex[*c & 0x0f]);
+        }
+        else
+          put(*c);
+      }
+      put('"');
+    }
+
+    //Non negative value in fixed notation, at most PAYLOAD_VALUE_DECIMALS decimals without trailing zeros.
+    //A non zero value below the last decimal would be written as 0 and is rejected like one out of range
+    void number(const double value){
+      if(!(value >= 0.0 && value < PAYLOAD_VALUE_MAX)){
+        valid = false;
+        return;
+      }
+      //Integral part is split off first, scaling the whole value would run out of double precision
+      uint64_t integral = (uint64_t)value;
+      uint32_t fraction = (uint32_t)((value - (double)integral) * PAYLOAD_VALUE_SCALE + 0.5);
+      if(fraction >= PAYLOAD_VALUE_SCALE){
+        integral++;
+        fraction -= PAYLOAD_VALUE_SCALE;
+      }
+      if(value > 0.0 && integral == 0 && fraction == 0){
+        valid = false;
+        return;
+      }
+
+      char digits[24];
+      int count = 0;
+      do {
+        digits[count++] = '0' + integral % 10;
+        integral /= 10;
+      } while(integral > 0);
+      while(count > 0)
+        put(digits[--count]);
+
+      if(fraction > 0){
+        int decimals = PAYLOAD_VALUE_DECIMALS;
+        while(fraction % 10 == 0){
+          fraction /= 10;
+          decimals--;
+        }
+        put('.');
+        for(int i = decimals - 1; i >= 0; i--){
+          digits[i] = '0' + fraction % 10;
+          fraction /= 10;
+        }
+        for(int i = 0; i < decimals; i++)
+          put(digits[i]);
+      }
+    }
+
+    //NUL terminates the payload, false if a value was out of range or it did not fit
+    bool finish(){
+      if(used < capacity){
+        out[used] = '\0';
+        return valid;
+      }
+      if(capacity > 0)
+        out[capacity - 1] = '\0';
+      return false;
+    }
+
+    //Exact payload length, also when it did not fit
+    size_t length(){
+      return used;
+    }
+
+  private:
+    char* out;
+    size_t capacity;
+    size_t used;
+    bool valid;
+
+    void put(const char c){
+      if(used < capacity)
+        out[used] = c;
+      used++;
+    }
+
+    void raw(const char* text, const size_t length){
+      if(used + length <= capacity){
+        memcpy(out + used, text, length);
+        used += length;
+      }
+      else
+        for(size_t i = 0; i < length; i++)
+          put(text[i]);
+    }
+};
+
+//{"bot":{"deviceID":..,"actionID":..,"queueID":..,"alternativeID":..,"value":..}}, alternativeID only
+//for multipair devices and value only when positive
+inline bool writeActionPayload(PayloadWriter& payload, const char* deviceID, const char* actionID,
+                               const char* queueID, const bool multipair, const char* altID, const double value){
+  payload.literal("{\"bot\":{\"deviceID\":");
+  payload.string(deviceID);
+  payload.literal(",\"actionID\":");
+  payload.string(actionID);
+  payload.literal(",\"queueID\":");
+  payload.string(queueID);
+  if(multipair){
+    payload.literal(",\"alternativeID\":");
+    payload.string(altID);
+  }
+  if(value > 0.0){
+    payload.literal(",\"value\":");
+    payload.number(value);
+  }
+  payload.literal("}}");
+  return payload.finish();
+}
+
+//{"bot":{"deviceID":..}}
+inline bool writeActivationPayload(PayloadWriter& payload, const char* deviceID){
+  payload.literal("{\"bot\":{\"deviceID\":");
+  payload.string(deviceID);
+  payload.literal("}}");
+  return payload.finish();
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+  PollingPolicy.cpp - Class and Methods to space out polls to BoT Service, fast at first
+                      and backing off exponentially with jitter up to a ceiling, waking
+                      up early when device state changes
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#include "PollingPolicy.h"
+//Created once while global objects are constructed, before any task can signal or wait
+EventGroupHandle_t PollingPolicy :: stateEvents = xEventGroupCreate();
+
+PollingPolicy :: PollingPolicy(const unsigned long initial, const unsigned long maximum){
+  initialInterval = (initial > 0)?initial:POLLING_INITIAL_INTERVAL_IN_MILLISECONDS;
+  maximumInterval = (maximum >= initialInterval)?maximum:initialInterval;
+  attempts = 0;
+}
+
+void PollingPolicy :: signalStateChange(){
+  //Every poller waiting right now wakes up, the bit is cleared when the next wait begins
+  xEventGroupSetBits(stateEvents, STATE_CHANGE_BIT);
+}
+
+void PollingPolicy :: reset(){
+  attempts = 0;
+}
+
+int PollingPolicy :: getAttempts(){
+  return attempts;
+}
+
+unsigned long PollingPolicy :: nextInterval(){
+  attempts++;
+  //Few quick polls first, then doubling till the ceiling
+  unsigned long interval = maximumInterval;
+  int doublings = attempts - POLLING_FAST_ATTEMPTS;
+  if(doublings <= 0)
+    interval = initialInterval;
+  else if(doublings < 16 && (initialInterval << doublings) < maximumInterval)
+    interval = initialInterval << doublings;
+
+  //Equal jitter keeps devices booted together from polling in lock step
+  unsigned long halfInterval = interval / 2;
+  return halfInterval + (esp_random() % (halfInterval + 1));
+}
+
+bool PollingPolicy :: wait(){
+  return waitFor(nextInterval());
+}
+
+bool PollingPolicy :: waitFor(const unsigned long interval){
+  //Only a state change during this wait counts, one signalled while nobody waited is stale by now
+  xEventGroupClearBits(stateEvents, STATE_CHANGE_BIT);
+  EventBits_t bits = xEventGroupWaitBits(stateEvents, STATE_CHANGE_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(interval));
+  if(bits & STATE_CHANGE_BIT){
+    debugD("\nPollingPolicy :: waitFor: Woken up early by state change");
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,33 @@
+/*
+  PollingPolicy.h - Class and Methods to space out polls to BoT Service, fast at first
+                    and backing off exponentially with jitter up to a ceiling, waking
+                    up early when device state changes
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef PollingPolicy_h
+#define PollingPolicy_h
+#include "BoTESP32SDK.h"
+#include <freertos/event_groups.h>
+#define POLLING_INITIAL_INTERVAL_IN_MILLISECONDS 2000
+#define POLLING_MAXIMUM_INTERVAL_IN_MILLISECONDS 60000
+#define POLLING_FAST_ATTEMPTS 3
+#define STATE_CHANGE_BIT (1 << 0)
+
+class PollingPolicy {
+  public:
+    PollingPolicy(const unsigned long initialInterval = POLLING_INITIAL_INTERVAL_IN_MILLISECONDS,
+                  const unsigned long maximumInterval = POLLING_MAXIMUM_INTERVAL_IN_MILLISECONDS);
+    void reset();
+    unsigned long nextInterval();
+    bool wait();
+    bool waitFor(const unsigned long interval);
+    int getAttempts();
+    static void signalStateChange();
+  private:
+    unsigned long initialInterval;
+    unsigned long maximumInterval;
+    int attempts;
+    static EventGroupHandle_t stateEvents;
+};
+#endif
@@ -29,6 +29,7 @@
 #include <utility>
 #include "BitBuffer.hpp"
 #include "QrCode.hpp"
+#include "QrMatrix.hpp"
 
 using std::int8_t;
 using std::uint8_t;
@@ -93,18 +94,18 @@ QrCode QrCode::encodeSegments(const vector<QrSegment> &segs, Ecc ecl,
 			ecl = newEcl;
 	}
 
-	// Concatenate all segments to create the data bit string
-	BitBuffer bb;
+	// Concatenate all segments to create the data bit string, sized for the chosen version up front
+	size_t dataCapacityBits = getNumDataCodewords(version, ecl) * 8;
+	BitBuffer bb(dataCapacityBits);
 	for (const QrSegment &seg : segs) {
 		bb.appendBits(seg.getMode().getModeBits(), 4);
 		bb.appendBits(seg.getNumChars(), seg.getMode().numCharCountBits(version));
-		bb.insert(bb.end(), seg.getData().begin(), seg.getData().end());
+		bb.appendData(seg.getData());
 	}
 	if (bb.size() != static_cast<unsigned int>(dataUsedBits))
 		throw std::logic_error("Assertion error");
 
 	// Add terminator and pad up to a byte if applicable
-	size_t dataCapacityBits = getNumDataCodewords(version, ecl) * 8;
 	if (bb.size() > dataCapacityBits)
 		throw std::logic_error("Assertion error");
 	bb.appendBits(0, std::min<size_t>(4, dataCapacityBits - bb.size()));
@@ -116,10 +117,8 @@ QrCode QrCode::encodeSegments(const vector<QrSegment> &segs, Ecc ecl,
 	for (uint8_t padByte = 0xEC; bb.size() < dataCapacityBits; padByte ^= 0xEC ^ 0x11)
 		bb.appendBits(padByte, 8);
 
-	// Pack bits into bytes in big endian
-	vector<uint8_t> dataCodewords(bb.size() / 8);
-	for (size_t i = 0; i < bb.size(); i++)
-		dataCodewords[i >> 3] |= (bb.at(i) ? 1 : 0) << (7 - (i & 7));
+	// Bits are already packed big endian, take them as bytes
+	vector<uint8_t> dataCodewords = bb.getBytes();
 
 	// Create the QR Code object
 	return QrCode(version, ecl, dataCodewords, mask);
@@ -134,37 +133,22 @@ QrCode::QrCode(int ver, Ecc ecl, const vector<uint8_t> &dataCodewords, int mask)
 		throw std::domain_error("Version value out of range");
 	if (mask < -1 || mask > 7)
 		throw std::domain_error("Mask value out of range");
+	if (dataCodewords.size() != static_cast<unsigned int>(getNumDataCodewords(ver, ecl)))
+		throw std::invalid_argument("Invalid argument");
 	size = ver * 4 + 17;
-	modules    = vector<vector<bool> >(size, vector<bool>(size));  // Initially all white
-	isFunction = vector<vector<bool> >(size, vector<bool>(size));
-
-	// Compute ECC, draw modules
-	drawFunctionPatterns();
-	const vector<uint8_t> allCodewords = addEccAndInterleave(dataCodewords);
-	drawCodewords(allCodewords);
-
-	// Do masking
-	if (mask == -1) {  // Automatically choose best mask
-		long minPenalty = LONG_MAX;
-		for (int i = 0; i < 8; i++) {
-			applyMask(i);
-			drawFormatBits(i);
-			long penalty = getPenaltyScore();
-			if (penalty < minPenalty) {
-				mask = i;
-				minPenalty = penalty;
-			}
-			applyMask(i);  // Undoes the mask due to XOR
-		}
-	}
-	if (mask < 0 || mask > 7)
+	rowWords = (size + 31) / 32;
+
+	// Draw into packed grids; only the modules are kept once the constructor finishes
+	int gridWords = QrMatrix::getGridWords(ver);
+	modules = vector<uint32_t>(gridWords);
+	vector<uint32_t> isFunction(gridWords), modulesT(gridWords), isFunctionT(gridWords);
+	vector<uint8_t> data(QrMatrix::getNumRawCodewords(ver));
+	vector<uint8_t> allCodewords(data.size());
+	std::copy(dataCodewords.cbegin(), dataCodewords.cend(), data.begin());
+	QrMatrix matrix(ver, ecl, modules.data(), isFunction.data(), modulesT.data(), isFunctionT.data());
+	if (matrix.draw(data.data(), allCodewords.data(), mask) != QrStatus::OK)
 		throw std::logic_error("Assertion error");
-	this->mask = mask;
-	applyMask(mask);  // Apply the final choice of mask
-	drawFormatBits(mask);  // Overwrite old format bits
-
-	isFunction.clear();
-	isFunction.shrink_to_fit();
+	this->mask = matrix.getMask();
 }
 
 
@@ -221,303 +205,8 @@ std::string QrCode::toSvgString(int border) const {
 }
 
 
-void QrCode::drawFunctionPatterns() {
-	// Draw horizontal and vertical timing patterns
-	for (int i = 0; i < size; i++) {
-		setFunctionModule(6, i, i % 2 == 0);
-		setFunctionModule(i, 6, i % 2 == 0);
-	}
-
-	// Draw 3 finder patterns (all corners except bottom right; overwrites some timing modules)
-	drawFinderPattern(3, 3);
-	drawFinderPattern(size - 4, 3);
-	drawFinderPattern(3, size - 4);
-
-	// Draw numerous alignment patterns
-	const vector<int> alignPatPos = getAlignmentPatternPositions();
-	int numAlign = alignPatPos.size();
-	for (int i = 0; i < numAlign; i++) {
-		for (int j = 0; j < numAlign; j++) {
-			// Don't draw on the three finder corners
-			if (!((i == 0 && j == 0) || (i == 0 && j == numAlign - 1) || (i == numAlign - 1 && j == 0)))
-				drawAlignmentPattern(alignPatPos.at(i), alignPatPos.at(j));
-		}
-	}
-
-	// Draw configuration data
-	drawFormatBits(0);  // Dummy mask value; overwritten later in the constructor
-	drawVersion();
-}
-
-
-void QrCode::drawFormatBits(int mask) {
-	// Calculate error correction code and pack bits
-	int data = getFormatBits(errorCorrectionLevel) << 3 | mask;  // errCorrLvl is uint2, mask is uint3
-	int rem = data;
-	for (int i = 0; i < 10; i++)
-		rem = (rem << 1) ^ ((rem >> 9) * 0x537);
-	int bits = (data << 10 | rem) ^ 0x5412;  // uint15
-	if (bits >> 15 != 0)
-		throw std::logic_error("Assertion error");
-
-	// Draw first copy
-	for (int i = 0; i <= 5; i++)
-		setFunctionModule(8, i, getBit(bits, i));
-	setFunctionModule(8, 7, getBit(bits, 6));
-	setFunctionModule(8, 8, getBit(bits, 7));
-	setFunctionModule(7, 8, getBit(bits, 8));
-	for (int i = 9; i < 15; i++)
-		setFunctionModule(14 - i, 8, getBit(bits, i));
-
-	// Draw second copy
-	for (int i = 0; i < 8; i++)
-		setFunctionModule(size - 1 - i, 8, getBit(bits, i));
-	for (int i = 8; i < 15; i++)
-		setFunctionModule(8, size - 15 + i, getBit(bits, i));
-	setFunctionModule(8, size - 8, true);  // Always black
-}
-
-
-void QrCode::drawVersion() {
-	if (version < 7)
-		return;
-
-	// Calculate error correction code and pack bits
-	int rem = version;  // version is uint6, in the range [7, 40]
-	for (int i = 0; i < 12; i++)
-		rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
-	long bits = (long)version << 12 | rem;  // uint18
-	if (bits >> 18 != 0)
-		throw std::logic_error("Assertion error");
-
-	// Draw two copies
-	for (int i = 0; i < 18; i++) {
-		bool bit = getBit(bits, i);
-		int a = size - 11 + i % 3;
-		int b = i / 3;
-		setFunctionModule(a, b, bit);
-		setFunctionModule(b, a, bit);
-	}
-}
-
-
-void QrCode::drawFinderPattern(int x, int y) {
-	for (int dy = -4; dy <= 4; dy++) {
-		for (int dx = -4; dx <= 4; dx++) {
-			int dist = std::max(std::abs(dx), std::abs(dy));  // Chebyshev/infinity norm
-			int xx = x + dx, yy = y + dy;
-			if (0 <= xx && xx < size && 0 <= yy && yy < size)
-				setFunctionModule(xx, yy, dist != 2 && dist != 4);
-		}
-	}
-}
-
-
-void QrCode::drawAlignmentPattern(int x, int y) {
-	for (int dy = -2; dy <= 2; dy++) {
-		for (int dx = -2; dx <= 2; dx++)
-			setFunctionModule(x + dx, y + dy, std::max(std::abs(dx), std::abs(dy)) != 1);
-	}
-}
-
-
-void QrCode::setFunctionModule(int x, int y, bool isBlack) {
-	modules.at(y).at(x) = isBlack;
-	isFunction.at(y).at(x) = true;
-}
-
-
 bool QrCode::module(int x, int y) const {
-	return modules.at(y).at(x);
-}
-
-
-vector<uint8_t> QrCode::addEccAndInterleave(const vector<uint8_t> &data) const {
-	if (data.size() != static_cast<unsigned int>(getNumDataCodewords(version, errorCorrectionLevel)))
-		throw std::invalid_argument("Invalid argument");
-
-	// Calculate parameter numbers
-	int numBlocks = NUM_ERROR_CORRECTION_BLOCKS[static_cast<int>(errorCorrectionLevel)][version];
-	int blockEccLen = ECC_CODEWORDS_PER_BLOCK  [static_cast<int>(errorCorrectionLevel)][version];
-	int rawCodewords = getNumRawDataModules(version) / 8;
-	int numShortBlocks = numBlocks - rawCodewords % numBlocks;
-	int shortBlockLen = rawCodewords / numBlocks;
-
-	// Split data into blocks and append ECC to each block
-	vector<vector<uint8_t> > blocks;
-	const ReedSolomonGenerator rs(blockEccLen);
-	for (int i = 0, k = 0; i < numBlocks; i++) {
-		vector<uint8_t> dat(data.cbegin() + k, data.cbegin() + (k + shortBlockLen - blockEccLen + (i < numShortBlocks ? 0 : 1)));
-		k += dat.size();
-		const vector<uint8_t> ecc = rs.getRemainder(dat);
-		if (i < numShortBlocks)
-			dat.push_back(0);
-		dat.insert(dat.end(), ecc.cbegin(), ecc.cend());
-		blocks.push_back(std::move(dat));
-	}
-
-	// Interleave (not concatenate) the bytes from every block into a single sequence
-	vector<uint8_t> result;
-	for (size_t i = 0; i < blocks.at(0).size(); i++) {
-		for (size_t j = 0; j < blocks.size(); j++) {
-			// Skip the padding byte in short blocks
-			if (i != static_cast<unsigned int>(shortBlockLen - blockEccLen) || j >= static_cast<unsigned int>(numShortBlocks))
-				result.push_back(blocks.at(j).at(i));
-		}
-	}
-	if (result.size() != static_cast<unsigned int>(rawCodewords))
-		throw std::logic_error("Assertion error");
-	return result;
-}
-
-
-void QrCode::drawCodewords(const vector<uint8_t> &data) {
-	if (data.size() != static_cast<unsigned int>(getNumRawDataModules(version) / 8))
-		throw std::invalid_argument("Invalid argument");
-
-	size_t i = 0;  // Bit index into the data
-	// Do the funny zigzag scan
-	for (int right = size - 1; right >= 1; right -= 2) {  // Index of right column in each column pair
-		if (right == 6)
-			right = 5;
-		for (int vert = 0; vert < size; vert++) {  // Vertical counter
-			for (int j = 0; j < 2; j++) {
-				int x = right - j;  // Actual x coordinate
-				bool upward = ((right + 1) & 2) == 0;
-				int y = upward ? size - 1 - vert : vert;  // Actual y coordinate
-				if (!isFunction.at(y).at(x) && i < data.size() * 8) {
-					modules.at(y).at(x) = getBit(data.at(i >> 3), 7 - static_cast<int>(i & 7));
-					i++;
-				}
-				// If this QR Code has any remainder bits (0 to 7), they were assigned as
-				// 0/false/white by the constructor and are left unchanged by this method
-			}
-		}
-	}
-	if (i != data.size() * 8)
-		throw std::logic_error("Assertion error");
-}
-
-
-void QrCode::applyMask(int mask) {
-	if (mask < 0 || mask > 7)
-		throw std::domain_error("Mask value out of range");
-	for (int y = 0; y < size; y++) {
-		for (int x = 0; x < size; x++) {
-			bool invert;
-			switch (mask) {
-				case 0:  invert = (x + y) % 2 == 0;                    break;
-				case 1:  invert = y % 2 == 0;                          break;
-				case 2:  invert = x % 3 == 0;                          break;
-				case 3:  invert = (x + y) % 3 == 0;                    break;
-				case 4:  invert = (x / 3 + y / 2) % 2 == 0;            break;
-				case 5:  invert = x * y % 2 + x * y % 3 == 0;          break;
-				case 6:  invert = (x * y % 2 + x * y % 3) % 2 == 0;    break;
-				case 7:  invert = ((x + y) % 2 + x * y % 3) % 2 == 0;  break;
-				default:  throw std::logic_error("Assertion error");
-			}
-			modules.at(y).at(x) = modules.at(y).at(x) ^ (invert & !isFunction.at(y).at(x));
-		}
-	}
-}
-
-
-long QrCode::getPenaltyScore() const {
-	long result = 0;
-
-	// Adjacent modules in row having same color, and finder-like patterns
-	for (int y = 0; y < size; y++) {
-		std::deque<int> runHistory(7, 0);
-		bool color = false;
-		int runX = 0;
-		for (int x = 0; x < size; x++) {
-			if (module(x, y) == color) {
-				runX++;
-				if (runX == 5)
-					result += PENALTY_N1;
-				else if (runX > 5)
-					result++;
-			} else {
-				addRunToHistory(runX, runHistory);
-				if (!color && hasFinderLikePattern(runHistory))
-					result += PENALTY_N3;
-				color = module(x, y);
-				runX = 1;
-			}
-		}
-		addRunToHistory(runX, runHistory);
-		if (color)
-			addRunToHistory(0, runHistory);  // Dummy run of white
-		if (hasFinderLikePattern(runHistory))
-			result += PENALTY_N3;
-	}
-	// Adjacent modules in column having same color, and finder-like patterns
-	for (int x = 0; x < size; x++) {
-		std::deque<int> runHistory(7, 0);
-		bool color = false;
-		int runY = 0;
-		for (int y = 0; y < size; y++) {
-			if (module(x, y) == color) {
-				runY++;
-				if (runY == 5)
-					result += PENALTY_N1;
-				else if (runY > 5)
-					result++;
-			} else {
-				addRunToHistory(runY, runHistory);
-				if (!color && hasFinderLikePattern(runHistory))
-					result += PENALTY_N3;
-				color = module(x, y);
-				runY = 1;
-			}
-		}
-		addRunToHistory(runY, runHistory);
-		if (color)
-			addRunToHistory(0, runHistory);  // Dummy run of white
-		if (hasFinderLikePattern(runHistory))
-			result += PENALTY_N3;
-	}
-
-	// 2*2 blocks of modules having same color
-	for (int y = 0; y < size - 1; y++) {
-		for (int x = 0; x < size - 1; x++) {
-			bool  color = module(x, y);
-			if (  color == module(x + 1, y) &&
-			      color == module(x, y + 1) &&
-			      color == module(x + 1, y + 1))
-				result += PENALTY_N2;
-		}
-	}
-
-	// Balance of black and white modules
-	int black = 0;
-	for (const vector<bool> &row : modules) {
-		for (bool color : row) {
-			if (color)
-				black++;
-		}
-	}
-	int total = size * size;  // Note that size is odd, so black/total != 1/2
-	// Compute the smallest integer k >= 0 such that (45-5k)% <= black/total <= (55+5k)%
-	int k = static_cast<int>((std::abs(black * 20L - total * 10L) + total - 1) / total) - 1;
-	result += k * PENALTY_N4;
-	return result;
-}
-
-
-vector<int> QrCode::getAlignmentPatternPositions() const {
-	if (version == 1)
-		return vector<int>();
-	else {
-		int numAlign = version / 7 + 2;
-		int step = (version == 32) ? 26 :
-			(version*4 + numAlign*2 + 1) / (numAlign*2 - 2) * 2;
-		vector<int> result;
-		for (int i = 0, pos = size - 7; i < numAlign - 1; i++, pos -= step)
-			result.insert(result.begin(), pos);
-		result.insert(result.begin(), 6);
-		return result;
-	}
+	return ((modules[y * rowWords + (x >> 5)] >> (x & 31)) & 1) != 0;
 }
 
 
@@ -542,32 +231,6 @@ int QrCode::getNumDataCodewords(int ver, Ecc ecl) {
 }
 
 
-void QrCode::addRunToHistory(int run, std::deque<int> &history) {
-	history.pop_back();
-	history.push_front(run);
-}
-
-
-bool QrCode::hasFinderLikePattern(const std::deque<int> &runHistory) {
-	int n = runHistory.at(1);
-	return n > 0 && runHistory.at(2) == n && runHistory.at(4) == n && runHistory.at(5) == n
-		&& runHistory.at(3) == n * 3 && std::max(runHistory.at(0), runHistory.at(6)) >= n * 4;
-}
-
-
-bool QrCode::getBit(long x, int i) {
-	return ((x >> i) & 1) != 0;
-}
-
-
-/*---- Tables of constants ----*/
-
-const int QrCode::PENALTY_N1 =  3;
-const int QrCode::PENALTY_N2 =  3;
-const int QrCode::PENALTY_N3 = 40;
-const int QrCode::PENALTY_N4 = 10;
-
-
 const int8_t QrCode::ECC_CODEWORDS_PER_BLOCK[4][41] = {
 	// Version: (note that index 0 is for padding, and is set to an illegal value)
 	//0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40    Error correction level
@@ -587,58 +250,6 @@ const int8_t QrCode::NUM_ERROR_CORRECTION_BLOCKS[4][41] = {
 };
 
 
-QrCode::ReedSolomonGenerator::ReedSolomonGenerator(int degree) :
-		coefficients() {
-	if (degree < 1 || degree > 255)
-		throw std::domain_error("Degree out of range");
-
-	// Start with the monomial x^0
-	coefficients.resize(degree);
-	coefficients.at(degree - 1) = 1;
-
-	// Compute the product polynomial (x - r^0) * (x - r^1) * (x - r^2) * ... * (x - r^{degree-1}),
-	// drop the highest term, and store the rest of the coefficients in order of descending powers.
-	// Note that r = 0x02, which is a generator element of this field GF(2^8/0x11D).
-	uint8_t root = 1;
-	for (int i = 0; i < degree; i++) {
-		// Multiply the current product by (x - r^i)
-		for (size_t j = 0; j < coefficients.size(); j++) {
-			coefficients.at(j) = multiply(coefficients.at(j), root);
-			if (j + 1 < coefficients.size())
-				coefficients.at(j) ^= coefficients.at(j + 1);
-		}
-		root = multiply(root, 0x02);
-	}
-}
-
-
-vector<uint8_t> QrCode::ReedSolomonGenerator::getRemainder(const vector<uint8_t> &data) const {
-	// Compute the remainder by performing polynomial division
-	vector<uint8_t> result(coefficients.size());
-	for (uint8_t b : data) {
-		uint8_t factor = b ^ result.at(0);
-		result.erase(result.begin());
-		result.push_back(0);
-		for (size_t j = 0; j < result.size(); j++)
-			result.at(j) ^= multiply(coefficients.at(j), factor);
-	}
-	return result;
-}
-
-
-uint8_t QrCode::ReedSolomonGenerator::multiply(uint8_t x, uint8_t y) {
-	// Russian peasant multiplication
-	int z = 0;
-	for (int i = 7; i >= 0; i--) {
-		z = (z << 1) ^ ((z >> 7) * 0x11D);
-		z ^= ((y >> i) & 1) * x;
-	}
-	if (z >> 8 != 0)
-		throw std::logic_error("Assertion error");
-	return static_cast<uint8_t>(z);
-}
-
-
 data_too_long::data_too_long(const std::string &msg) :
 	std::length_error(msg) {}
 
@@ -24,7 +24,6 @@
 #pragma once
 
 #include <cstdint>
-#include <deque>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -33,6 +32,9 @@
 
 namespace qrcodegen {
 
+class QrMatrix;
+
+
 /*
  * A QR Code symbol, which is a type of two-dimension barcode.
  * Invented by Denso Wave and described in the ISO/IEC 18004 standard.
@@ -51,6 +53,9 @@ namespace qrcodegen {
  */
 class QrCode final {
 
+	// Draws the symbol for the constructor and QrCodeStatic, using the tables below.
+	friend class QrMatrix;
+
 	/*---- Public helper enumeration ----*/
 
 	/*
@@ -128,14 +133,13 @@ class QrCode final {
 	 * the resulting object still has a mask value between 0 and 7. */
 	private: int mask;
 
-	// Private grids of modules/pixels, with dimensions of size*size:
-
-	// The modules of this QR Code (false = white, true = black).
-	// Immutable after constructor finishes. Accessed through getModule().
-	private: std::vector<std::vector<bool> > modules;
+	// The modules of this QR Code (false = white, true = black), with dimensions of size*size,
+	// each row packed into rowWords 32-bit words with module x at bit (x % 32) of word (x / 32).
+	// Drawn by QrMatrix and immutable after constructor finishes. Accessed through getModule().
+	private: std::vector<std::uint32_t> modules;
 
-	// Indicates function modules that are not subjected to masking. Discarded when constructor finishes.
-	private: std::vector<std::vector<bool> > isFunction;
+	// Number of 32-bit words per packed row, between 1 and 6.
+	private: int rowWords;
 
 
 
@@ -193,75 +197,10 @@ class QrCode final {
 
 
 
-	/*---- Private helper methods for constructor: Drawing function modules ----*/
-
-	// Reads this object's version field, and draws and marks all function modules.
-	private: void drawFunctionPatterns();
-
-
-	// Draws two copies of the format bits (with its own error correction code)
-	// based on the given mask and this object's error correction level field.
-	private: void drawFormatBits(int mask);
-
-
-	// Draws two copies of the version bits (with its own error correction code),
-	// based on this object's version field, iff 7 <= version <= 40.
-	private: void drawVersion();
-
-
-	// Draws a 9*9 finder pattern including the border separator,
-	// with the center module at (x, y). Modules can be out of bounds.
-	private: void drawFinderPattern(int x, int y);
-
-
-	// Draws a 5*5 alignment pattern, with the center module
-	// at (x, y). All modules must be in bounds.
-	private: void drawAlignmentPattern(int x, int y);
-
-
-	// Sets the color of a module and marks it as a function module.
-	// Only used by the constructor. Coordinates must be in bounds.
-	private: void setFunctionModule(int x, int y, bool isBlack);
-
-
 	// Returns the color of the module at the given coordinates, which must be in range.
 	private: bool module(int x, int y) const;
-
-
-	/*---- Private helper methods for constructor: Codewords and masking ----*/
-
-	// Returns a new byte string representing the given data with the appropriate error correction
-	// codewords appended to it, based on this object's version and error correction level.
-	private: std::vector<std::uint8_t> addEccAndInterleave(const std::vector<std::uint8_t> &data) const;
-
-
-	// Draws the given sequence of 8-bit codewords (data and error correction) onto the entire
-	// data area of this QR Code. Function modules need to be marked off before this is called.
-	private: void drawCodewords(const std::vector<std::uint8_t> &data);
-
-
-	// XORs the codeword modules in this QR Code with the given mask pattern.
-	// The function modules must be marked and the codeword bits must be drawn
-	// before masking. Due to the arithmetic of XOR, calling applyMask() with
-	// the same mask value a second time will undo the mask. A final well-formed
-	// QR Code needs exactly one (not zero, two, etc.) mask applied.
-	private: void applyMask(int mask);
-
-
-	// Calculates and returns the penalty score based on state of this QR Code's current modules.
-	// This is used by the automatic mask choice algorithm to find the mask pattern that yields the lowest score.
-	private: long getPenaltyScore() const;
-
-
-
-	/*---- Private helper functions ----*/
-
-	// Returns an ascending list of positions of alignment patterns for this version number.
-	// Each position is in the range [0,177), and are used on both the x and y axes.
-	// This could be implemented as lookup table of 40 variable-length lists of unsigned bytes.
-	private: std::vector<int> getAlignmentPatternPositions() const;
-
-
+	
+	
 	// Returns the number of data bits that can be stored in a QR Code of the given version number, after
 	// all function modules are excluded. This includes remainder bits, so it might not be a multiple of 8.
 	// The result is in the range [208, 29648]. This could be implemented as a 40-entry lookup table.
@@ -274,21 +213,6 @@ class QrCode final {
 	private: static int getNumDataCodewords(int ver, Ecc ecl);
 
 
-	// Inserts the given value to the front of the given array, which shifts over the
-	// existing values and deletes the last value. A helper function for getPenaltyScore().
-	private: static void addRunToHistory(int run, std::deque<int> &history);
-
-
-	// Tests whether the given run history has the pattern of ratio 1:1:3:1:1 in the middle, and
-	// surrounded by at least 4 on either or both ends. A helper function for getPenaltyScore().
-	// Must only be called immediately after a run of white modules has ended.
-	private: static bool hasFinderLikePattern(const std::deque<int> &runHistory);
-
-
-	// Returns true iff the i'th bit of x is set to 1.
-	private: static bool getBit(long x, int i);
-
-
 	/*---- Constants and tables ----*/
 
 	// The minimum version number supported in the QR Code Model 2 standard.
@@ -298,61 +222,12 @@ class QrCode final {
 	public: static constexpr int MAX_VERSION = 40;
 
 
-	// For use in getPenaltyScore(), when evaluating which mask is best.
-	private: static const int PENALTY_N1;
-	private: static const int PENALTY_N2;
-	private: static const int PENALTY_N3;
-	private: static const int PENALTY_N4;
-
-
 	private: static const std::int8_t ECC_CODEWORDS_PER_BLOCK[4][41];
+	
+	// The largest value in ECC_CODEWORDS_PER_BLOCK, i.e. the highest Reed-Solomon degree needed.
+	public: static constexpr int MAX_ECC_CODEWORDS_PER_BLOCK = 30;
 	private: static const std::int8_t NUM_ERROR_CORRECTION_BLOCKS[4][41];
 
-
-
-	/*---- Private helper class ----*/
-
-	/*
-	 * Computes the Reed-Solomon error correction codewords for a sequence of data codewords
-	 * at a given degree. Objects are immutable, and the state only depends on the degree.
-	 * This class exists because each data block in a QR Code shares the same the divisor polynomial.
-	 */
-	private: class ReedSolomonGenerator final {
-
-		/*-- Immutable field --*/
-
-		// Coefficients of the divisor polynomial, stored from highest to lowest power, excluding the leading term which
-		// is always 1. For example the polynomial x^3 + 255x^2 + 8x + 93 is stored as the uint8 array {255, 8, 93}.
-		private: std::vector<std::uint8_t> coefficients;
-
-
-		/*-- Constructor --*/
-
-		/*
-		 * Creates a Reed-Solomon ECC generator for the given degree. This could be implemented
-		 * as a lookup table over all possible parameter values, instead of as an algorithm.
-		 */
-		public: explicit ReedSolomonGenerator(int degree);
-
-
-		/*-- Method --*/
-
-		/*
-		 * Computes and returns the Reed-Solomon error correction codewords for the given
-		 * sequence of data codewords. The returned object is always a new byte array.
-		 * This method does not alter this object's state (because it is immutable).
-		 */
-		public: std::vector<std::uint8_t> getRemainder(const std::vector<std::uint8_t> &data) const;
-
-
-		/*-- Static function --*/
-
-		// Returns the product of the two given field elements modulo GF(2^8/0x11D).
-		// All inputs are valid. This could be implemented as a 256*256 lookup table.
-		private: static std::uint8_t multiply(std::uint8_t x, std::uint8_t y);
-
-	};
-
 };
 
 
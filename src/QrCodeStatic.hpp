@@ -0,0 +1,172 @@
+/*
+ * QR Code generator library (C++)
+ *
+ * Copyright (c) Project Nayuki. (MIT License)
+ * https://www.nayuki.io/page/qr-code-generator-library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * - The above copyright notice and this permission notice shall be included in
+ *   all copies or substantial portions of the Software.
+ * - The Software is provided "as is", without warranty of any kind, express or
+ *   implied, including but not limited to the warranties of merchantability,
+ *   fitness for a particular purpose and noninfringement. In no event shall the
+ *   authors or copyright holders be liable for any claim, damages or other
+ *   liability, whether in an action of contract, tort or otherwise, arising from,
+ *   out of or in connection with the Software or the use or other dealings in the
+ *   Software.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "QrCode.hpp"
+#include "QrMatrix.hpp"
+
+
+namespace qrcodegen {
+
+/*
+ * A QR Code symbol of at most version MaxVersion, encoded into fixed-size buffers held inside
+ * the object. Encoding never allocates and reports failures as QrStatus codes instead of
+ * exceptions, so a symbol placed in static storage can be rendered even on a fragmented heap.
+ * The buffers grow with the square of MaxVersion; QrCodeStatic<23> takes about 9.5 KB.
+ * It exposes the same getters as QrCode, so it can be passed to writeQRCodeSVG().
+ */
+template<int MaxVersion>
+class QrCodeStatic final {
+
+	static_assert(QrCode::MIN_VERSION <= MaxVersion && MaxVersion <= QrCode::MAX_VERSION, "Version out of range");
+
+
+	/*---- Constructor ----*/
+
+	// Creates an empty symbol of size 0, to be filled by encodeText().
+	public: QrCodeStatic() :
+		version(0),
+		size(0),
+		rowWords(0),
+		errorCorrectionLevel(QrCode::Ecc::QRLOW),
+		mask(-1) {}
+
+
+	/*---- Encoding ----*/
+
+	/*
+	 * Encodes the given text at the given error correction level, or a higher one when that does
+	 * not need a larger version, into the smallest version that fits. Uses the automatically
+	 * chosen mask if mask is -1. Produces the same symbol as QrCode::encodeText() for any text
+	 * that fits in MaxVersion. On failure the symbol is left empty (size 0).
+	 */
+	public: QrStatus encodeText(const char *text, QrCode::Ecc ecl, int mask = -1) {
+		size = 0;
+		if (mask < -1 || mask > 7)
+			return QrStatus::INVALID_ARGUMENT;
+		int ver;
+		QrStatus status = QrMatrix::encodeText(text, ecl, QrCode::MIN_VERSION, MaxVersion, true, data, ver);
+		if (status != QrStatus::OK)
+			return status;
+		return draw(ver, ecl, mask);
+	}
+
+
+	/*
+	 * Encodes the given segments like QrCode::encodeSegments() with the default version range
+	 * and ECC boosting. Only the segments themselves live on the heap; the symbol does not.
+	 */
+	public: QrStatus encodeSegments(const std::vector<QrSegment> &segs, QrCode::Ecc ecl, int mask = -1) {
+		size = 0;
+		if (mask < -1 || mask > 7)
+			return QrStatus::INVALID_ARGUMENT;
+		int ver;
+		QrStatus status = QrMatrix::encodeSegments(segs, ecl, QrCode::MIN_VERSION, MaxVersion, true, data, ver);
+		if (status != QrStatus::OK)
+			return status;
+		return draw(ver, ecl, mask);
+	}
+
+
+	/*---- Public instance methods ----*/
+
+	public: int getVersion() const {
+		return version;
+	}
+
+
+	public: int getSize() const {
+		return size;
+	}
+
+
+	public: QrCode::Ecc getErrorCorrectionLevel() const {
+		return errorCorrectionLevel;
+	}
+
+
+	public: int getMask() const {
+		return mask;
+	}
+
+
+	// Returns the color of the module (pixel) at the given coordinates, which is false
+	// for white or true for black. Out of bounds coordinates return false (white).
+	public: bool getModule(int x, int y) const {
+		return 0 <= x && x < size && 0 <= y && y < size
+			&& ((modules[y * rowWords + (x >> 5)] >> (x & 31)) & 1) != 0;
+	}
+
+
+	/*---- Private helper method ----*/
+
+	// Draws the data codewords packed for the given version and level, and keeps the result.
+	private: QrStatus draw(int ver, QrCode::Ecc ecl, int mask) {
+		QrMatrix matrix(ver, ecl, modules, isFunction, modulesT, isFunctionT);
+		QrStatus status = matrix.draw(data, codewords, mask);
+		if (status != QrStatus::OK)
+			return status;
+		version = ver;
+		size = matrix.getSize();
+		rowWords = (size + 31) / 32;
+		errorCorrectionLevel = ecl;
+		this->mask = matrix.getMask();
+		return QrStatus::OK;
+	}
+
+
+	/*---- Buffer sizes ----*/
+
+	private: static constexpr int GRID_WORDS = QrMatrix::getGridWords(MaxVersion);
+
+	private: static constexpr int RAW_CODEWORDS = QrMatrix::getNumRawCodewords(MaxVersion);
+
+
+	/*---- Instance fields ----*/
+
+	private: int version;
+
+	private: int size;
+
+	private: int rowWords;
+
+	private: QrCode::Ecc errorCorrectionLevel;
+
+	private: int mask;
+
+	// The packed module grid kept after encoding, and the scratch grids for choosing the mask.
+	private: std::uint32_t modules[GRID_WORDS];
+	private: std::uint32_t isFunction[GRID_WORDS];
+	private: std::uint32_t modulesT[GRID_WORDS];
+	private: std::uint32_t isFunctionT[GRID_WORDS];
+
+	// Data codewords (also ECC scratch space), and the interleaved codeword sequence.
+	private: std::uint8_t data[RAW_CODEWORDS];
+	private: std::uint8_t codewords[RAW_CODEWORDS];
+
+};
+
+}
@@ -0,0 +1,710 @@
+/*
+ * QR Code generator library (C++)
+ *
+ * Copyright (c) Project Nayuki. (MIT License)
+ * https://www.nayuki.io/page/qr-code-generator-library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * - The above copyright notice and this permission notice shall be included in
+ *   all copies or substantial portions of the Software.
+ * - The Software is provided "as is", without warranty of any kind, express or
+ *   implied, including but not limited to the warranties of merchantability,
+ *   fitness for a particular purpose and noninfringement. In no event shall the
+ *   authors or copyright holders be liable for any claim, damages or other
+ *   liability, whether in an action of contract, tort or otherwise, arising from,
+ *   out of or in connection with the Software or the use or other dealings in the
+ *   Software.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include "BitBuffer.hpp"
+#include "QrMatrix.hpp"
+#include "QrSegment.hpp"
+
+using std::uint8_t;
+using std::uint32_t;
+
+
+namespace qrcodegen {
+
+/*---- Compile-time Reed-Solomon tables ----*/
+
+namespace {
+
+// A pack of the integers 0, 1, ..., N-1, built by halving so that long packs stay shallow.
+template<int... I> struct Indices {};
+
+template<class A, class B> struct ConcatIndices;
+template<int... A, int... B> struct ConcatIndices<Indices<A...>, Indices<B...> > {
+	typedef Indices<A..., (static_cast<int>(sizeof...(A)) + B)...> type;
+};
+
+template<int N> struct MakeIndices {
+	typedef typename ConcatIndices<typename MakeIndices<N / 2>::type, typename MakeIndices<N - N / 2>::type>::type type;
+};
+template<> struct MakeIndices<0> { typedef Indices<> type; };
+template<> struct MakeIndices<1> { typedef Indices<0> type; };
+
+
+// Multiplies a field element by the generator element 0x02 modulo GF(2^8/0x11D).
+constexpr int gfDouble(int x) {
+	return (x << 1) ^ ((x >> 7) * 0x11D);
+}
+
+// Returns 0x02 raised to the given power, starting from x.
+constexpr int gfPower(int power, int x = 1) {
+	return power == 0 ? x : gfPower(power - 1, gfDouble(x));
+}
+
+// Returns the discrete logarithm of the given non-zero element, searching upward from x = 0x02^power.
+constexpr int gfLogarithm(int value, int power = 0, int x = 1) {
+	return value == 0 ? 0 : (x == value ? power : gfLogarithm(value, power + 1, gfDouble(x)));
+}
+
+
+// Antilogarithms for powers 0 to 509, so the sum of two logarithms never needs reducing modulo 255.
+template<class Seq> struct ExpTable;
+template<int... I> struct ExpTable<Indices<I...> > {
+	static constexpr uint8_t VALUES[sizeof...(I)] = {static_cast<uint8_t>(gfPower(I % 255))...};
+};
+template<int... I> constexpr uint8_t ExpTable<Indices<I...> >::VALUES[sizeof...(I)];
+
+// Logarithms of the elements 0 to 255 (the entry for 0 is unused).
+template<class Seq> struct LogTable;
+template<int... I> struct LogTable<Indices<I...> > {
+	static constexpr uint8_t VALUES[sizeof...(I)] = {static_cast<uint8_t>(gfLogarithm(I))...};
+};
+template<int... I> constexpr uint8_t LogTable<Indices<I...> >::VALUES[sizeof...(I)];
+
+typedef ExpTable<MakeIndices<510>::type> GfExp;
+typedef LogTable<MakeIndices<256>::type> GfLog;
+
+
+constexpr int gfMultiply(int x, int y) {
+	return x == 0 || y == 0 ? 0 : GfExp::VALUES[GfLog::VALUES[x] + GfLog::VALUES[y]];
+}
+
+
+// Divisor polynomial (x - r^0) * (x - r^1) * ... * (x - r^{D-1}) with r = 0x02, stored from highest
+// to lowest power, excluding the leading term which is always 1. For example the polynomial
+// x^3 + 255x^2 + 8x + 93 is stored as the uint8 array {255, 8, 93}.
+// Each degree is computed from the one below by multiplying with (x - r^{D-1}).
+template<int D, class Seq = typename MakeIndices<D>::type> struct DivisorPolynomial;
+template<int D, int... J> struct DivisorPolynomial<D, Indices<J...> > {
+	static constexpr uint8_t VALUES[D] = {static_cast<uint8_t>(
+		(J < D - 1 ? DivisorPolynomial<D - 1>::VALUES[J] : 0) ^
+		gfMultiply(J == 0 ? 1 : DivisorPolynomial<D - 1>::VALUES[J - 1], GfExp::VALUES[D - 1]))...};
+};
+template<int D, int... J> constexpr uint8_t DivisorPolynomial<D, Indices<J...> >::VALUES[D];
+
+template<> struct DivisorPolynomial<0, Indices<> > {
+	static constexpr uint8_t VALUES[1] = {0};
+};
+constexpr uint8_t DivisorPolynomial<0, Indices<> >::VALUES[1];
+
+
+// Divisor polynomials for every degree from 0 up to the largest ECC block length of any version.
+template<class Seq> struct DivisorTable;
+template<int... D> struct DivisorTable<Indices<D...> > {
+	static const uint8_t *const POLYNOMIALS[sizeof...(D)];
+};
+template<int... D> const uint8_t *const DivisorTable<Indices<D...> >::POLYNOMIALS[sizeof...(D)] = {DivisorPolynomial<D>::VALUES...};
+
+typedef DivisorTable<MakeIndices<QrCode::MAX_ECC_CODEWORDS_PER_BLOCK + 1>::type> Divisors;
+
+
+// Appends bits big endian to a zero-filled codeword buffer.
+class CodewordWriter final {
+
+	public: explicit CodewordWriter(uint8_t *data) :
+		data(data),
+		bitLength(0) {}
+
+	public: void appendBits(uint32_t val, int len) {
+		if (len > 0)
+			appendWord(val << (32 - len), len);
+	}
+
+	// Appends all bits of the given buffer a word at a time.
+	public: void appendData(const BitBuffer &bits) {
+		size_t remaining = bits.size();
+		for (size_t i = 0; remaining > 0; i++) {
+			int len = remaining < 32 ? static_cast<int>(remaining) : 32;
+			appendWord(bits.getWord(i), len);
+			remaining -= len;
+		}
+	}
+
+	public: int size() const {
+		return bitLength;
+	}
+
+	// Adds the terminator, pads up to a byte, then pads with alternating bytes up to the given capacity.
+	public: void pad(int capacityBits) {
+		appendBits(0, std::min(4, capacityBits - bitLength));
+		appendBits(0, (8 - bitLength % 8) % 8);
+		for (uint8_t padByte = 0xEC; bitLength < capacityBits; padByte ^= 0xEC ^ 0x11)
+			appendBits(padByte, 8);
+	}
+
+	// Appends the top len bits of word, the rest of word must be 0s. Data bytes are
+	// zeroed beforehand, so each byte the bits straddle takes a single OR.
+	private: void appendWord(uint32_t word, int len) {
+		while (len > 0) {
+			int offset = bitLength & 7;
+			int take = std::min(8 - offset, len);
+			data[bitLength >> 3] |= static_cast<uint8_t>(word >> (24 + offset));
+			word <<= take;
+			len -= take;
+			bitLength += take;
+		}
+	}
+
+	private: uint8_t *data;
+	private: int bitLength;
+
+};
+
+}
+
+
+QrStatus QrMatrix::encodeText(const char *text, QrCode::Ecc &ecl, int minVersion, int maxVersion,
+		bool boostEcl, uint8_t *data, int &version) {
+	if (!(QrCode::MIN_VERSION <= minVersion && minVersion <= maxVersion && maxVersion <= QrCode::MAX_VERSION))
+		return QrStatus::INVALID_ARGUMENT;
+
+	// Select the segment mode the way QrSegment::makeSegments() does, and count the data bits
+	long numChars = std::strlen(text);
+	const QrSegment::Mode *mode = nullptr;
+	long segmentBits = 0;
+	if (numChars == 0);  // No segment at all
+	else if (QrSegment::isNumeric(text)) {
+		mode = &QrSegment::Mode::NUMERIC;
+		segmentBits = numChars / 3 * 10 + (numChars % 3 == 0 ? 0 : numChars % 3 * 3 + 1);
+	} else if (QrSegment::isAlphanumeric(text)) {
+		mode = &QrSegment::Mode::ALPHANUMERIC;
+		segmentBits = numChars / 2 * 11 + numChars % 2 * 6;
+	} else {
+		mode = &QrSegment::Mode::BYTE;
+		segmentBits = numChars * 8;
+	}
+
+	// Find the minimal version number to use
+	long dataUsedBits;
+	for (version = minVersion; ; version++) {
+		dataUsedBits = 0;
+		if (mode != nullptr) {
+			int ccbits = mode->numCharCountBits(version);
+			dataUsedBits = numChars < (1L << ccbits) ? 4 + ccbits + segmentBits : LONG_MAX;
+		}
+		if (dataUsedBits <= QrCode::getNumDataCodewords(version, ecl) * 8L)
+			break;  // This version number is found to be suitable
+		if (version >= maxVersion)  // All versions in the range could not fit the given data
+			return QrStatus::DATA_TOO_LONG;
+	}
+
+	if (boostEcl)
+		ecl = getBoostedEcl(ecl, version, dataUsedBits);
+
+	// Pack the segment header and data
+	int dataCapacityBits = QrCode::getNumDataCodewords(version, ecl) * 8;
+	std::memset(data, 0, dataCapacityBits / 8);
+	CodewordWriter bb(data);
+	if (mode != nullptr) {
+		bb.appendBits(mode->getModeBits(), 4);
+		bb.appendBits(numChars, mode->numCharCountBits(version));
+	}
+	int accumData = 0;
+	int accumCount = 0;
+	for (const char *c = text; *c != '\0'; c++) {
+		if (mode == &QrSegment::Mode::NUMERIC) {
+			accumData = accumData * 10 + (*c - '0');
+			if (++accumCount == 3) {
+				bb.appendBits(accumData, 10);
+				accumData = 0;
+				accumCount = 0;
+			}
+		} else if (mode == &QrSegment::Mode::ALPHANUMERIC) {
+			accumData = accumData * 45 + (std::strchr(QrSegment::ALPHANUMERIC_CHARSET, *c) - QrSegment::ALPHANUMERIC_CHARSET);
+			if (++accumCount == 2) {
+				bb.appendBits(accumData, 11);
+				accumData = 0;
+				accumCount = 0;
+			}
+		} else
+			bb.appendBits(static_cast<uint8_t>(*c), 8);
+	}
+	if (accumCount > 0)  // 1 or 2 digits, or 1 character, remaining
+		bb.appendBits(accumData, mode == &QrSegment::Mode::NUMERIC ? accumCount * 3 + 1 : 6);
+	bb.pad(dataCapacityBits);
+	return QrStatus::OK;
+}
+
+
+QrStatus QrMatrix::encodeSegments(const std::vector<QrSegment> &segs, QrCode::Ecc &ecl, int minVersion,
+		int maxVersion, bool boostEcl, uint8_t *data, int &version) {
+	if (!(QrCode::MIN_VERSION <= minVersion && minVersion <= maxVersion && maxVersion <= QrCode::MAX_VERSION))
+		return QrStatus::INVALID_ARGUMENT;
+
+	// Find the minimal version number to use
+	int dataUsedBits;
+	for (version = minVersion; ; version++) {
+		dataUsedBits = QrSegment::getTotalBits(segs, version);
+		if (dataUsedBits != -1 && dataUsedBits <= QrCode::getNumDataCodewords(version, ecl) * 8)
+			break;  // This version number is found to be suitable
+		if (version >= maxVersion)  // All versions in the range could not fit the given data
+			return QrStatus::DATA_TOO_LONG;
+	}
+	if (boostEcl)
+		ecl = getBoostedEcl(ecl, version, dataUsedBits);
+
+	// Concatenate all segments to create the data bit string
+	int dataCapacityBits = QrCode::getNumDataCodewords(version, ecl) * 8;
+	std::memset(data, 0, dataCapacityBits / 8);
+	CodewordWriter bb(data);
+	for (const QrSegment &seg : segs) {
+		bb.appendBits(seg.getMode().getModeBits(), 4);
+		bb.appendBits(seg.getNumChars(), seg.getMode().numCharCountBits(version));
+		bb.appendData(seg.getData());
+	}
+	bb.pad(dataCapacityBits);
+	return QrStatus::OK;
+}
+
+
+QrStatus QrMatrix::getEccCodewords(const uint8_t *data, int dataLen, int degree, uint8_t *result) {
+	if (degree < 1 || degree > QrCode::MAX_ECC_CODEWORDS_PER_BLOCK || dataLen < 0)
+		return QrStatus::INVALID_ARGUMENT;
+	getRemainder(data, dataLen, Divisors::POLYNOMIALS[degree], degree, result);
+	return QrStatus::OK;
+}
+
+
+QrCode::Ecc QrMatrix::getBoostedEcl(QrCode::Ecc ecl, int version, long dataUsedBits) {
+	// Increase the error correction level while the data still fits in the current version number
+	const QrCode::Ecc higherLevels[] = {QrCode::Ecc::QRMEDIUM, QrCode::Ecc::QRQUARTILE, QrCode::Ecc::QRHIGH};
+	for (QrCode::Ecc newEcl : higherLevels) {  // From low to high
+		if (dataUsedBits <= QrCode::getNumDataCodewords(version, newEcl) * 8L)
+			ecl = newEcl;
+	}
+	return ecl;
+}
+
+
+QrMatrix::QrMatrix(int ver, QrCode::Ecc ecl, uint32_t *modules, uint32_t *isFunction,
+		uint32_t *modulesT, uint32_t *isFunctionT) :
+		version(ver),
+		size(ver * 4 + 17),
+		errorCorrectionLevel(ecl),
+		mask(-1),
+		rowWords((ver * 4 + 17 + 31) / 32),
+		modules(modules),
+		isFunction(isFunction),
+		modulesT(modulesT),
+		isFunctionT(isFunctionT) {}
+
+
+QrStatus QrMatrix::draw(uint8_t *data, uint8_t *codewords, int mask) {
+	if (version < QrCode::MIN_VERSION || version > QrCode::MAX_VERSION || mask < -1 || mask > 7)
+		return QrStatus::INVALID_ARGUMENT;
+	size_t gridBytes = getGridWords(version) * sizeof(uint32_t);
+	std::memset(modules, 0, gridBytes);  // Initially all white
+	std::memset(isFunction, 0, gridBytes);
+	std::memset(modulesT, 0, gridBytes);
+	std::memset(isFunctionT, 0, gridBytes);
+
+	// Compute ECC, draw modules
+	drawFunctionPatterns();
+	addEccAndInterleave(data, codewords);
+	drawCodewords(codewords);
+
+	// Do masking
+	if (mask == -1) {  // Automatically choose best mask
+		long minPenalty = LONG_MAX;
+		for (int i = 0; i < 8; i++) {
+			applyMask(i);
+			drawFormatBits(i);
+			long penalty = getPenaltyScore();
+			if (penalty < minPenalty) {
+				mask = i;
+				minPenalty = penalty;
+			}
+			applyMask(i);  // Undoes the mask due to XOR
+		}
+	}
+	this->mask = mask;
+	applyMask(mask);  // Apply the final choice of mask
+	drawFormatBits(mask);  // Overwrite old format bits
+	return QrStatus::OK;
+}
+
+
+int QrMatrix::getSize() const {
+	return size;
+}
+
+
+int QrMatrix::getMask() const {
+	return mask;
+}
+
+
+void QrMatrix::drawFunctionPatterns() {
+	// Draw horizontal and vertical timing patterns
+	for (int i = 0; i < size; i++) {
+		setFunctionModule(6, i, i % 2 == 0);
+		setFunctionModule(i, 6, i % 2 == 0);
+	}
+
+	// Draw 3 finder patterns (all corners except bottom right; overwrites some timing modules)
+	drawFinderPattern(3, 3);
+	drawFinderPattern(size - 4, 3);
+	drawFinderPattern(3, size - 4);
+
+	// Draw numerous alignment patterns
+	int alignPatPos[7];
+	int numAlign = getAlignmentPatternPositions(alignPatPos);
+	for (int i = 0; i < numAlign; i++) {
+		for (int j = 0; j < numAlign; j++) {
+			// Don't draw on the three finder corners
+			if (!((i == 0 && j == 0) || (i == 0 && j == numAlign - 1) || (i == numAlign - 1 && j == 0)))
+				drawAlignmentPattern(alignPatPos[i], alignPatPos[j]);
+		}
+	}
+
+	// Draw configuration data
+	drawFormatBits(0);  // Dummy mask value; overwritten later by draw()
+	drawVersion();
+}
+
+
+void QrMatrix::drawFormatBits(int mask) {
+	// Calculate error correction code and pack bits
+	int data = QrCode::getFormatBits(errorCorrectionLevel) << 3 | mask;  // errCorrLvl is uint2, mask is uint3
+	int rem = data;
+	for (int i = 0; i < 10; i++)
+		rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+	int bits = (data << 10 | rem) ^ 0x5412;  // uint15
+
+	// Draw first copy
+	for (int i = 0; i <= 5; i++)
+		setFunctionModule(8, i, getBit(bits, i));
+	setFunctionModule(8, 7, getBit(bits, 6));
+	setFunctionModule(8, 8, getBit(bits, 7));
+	setFunctionModule(7, 8, getBit(bits, 8));
+	for (int i = 9; i < 15; i++)
+		setFunctionModule(14 - i, 8, getBit(bits, i));
+
+	// Draw second copy
+	for (int i = 0; i < 8; i++)
+		setFunctionModule(size - 1 - i, 8, getBit(bits, i));
+	for (int i = 8; i < 15; i++)
+		setFunctionModule(8, size - 15 + i, getBit(bits, i));
+	setFunctionModule(8, size - 8, true);  // Always black
+}
+
+
+void QrMatrix::drawVersion() {
+	if (version < 7)
+		return;
+
+	// Calculate error correction code and pack bits
+	int rem = version;  // version is uint6, in the range [7, 40]
+	for (int i = 0; i < 12; i++)
+		rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+	long bits = (long)version << 12 | rem;  // uint18
+
+	// Draw two copies
+	for (int i = 0; i < 18; i++) {
+		bool bit = getBit(bits, i);
+		int a = size - 11 + i % 3;
+		int b = i / 3;
+		setFunctionModule(a, b, bit);
+		setFunctionModule(b, a, bit);
+	}
+}
+
+
+void QrMatrix::drawFinderPattern(int x, int y) {
+	for (int dy = -4; dy <= 4; dy++) {
+		for (int dx = -4; dx <= 4; dx++) {
+			int dist = std::max(std::abs(dx), std::abs(dy));  // Chebyshev/infinity norm
+			int xx = x + dx, yy = y + dy;
+			if (0 <= xx && xx < size && 0 <= yy && yy < size)
+				setFunctionModule(xx, yy, dist != 2 && dist != 4);
+		}
+	}
+}
+
+
+void QrMatrix::drawAlignmentPattern(int x, int y) {
+	for (int dy = -2; dy <= 2; dy++) {
+		for (int dx = -2; dx <= 2; dx++)
+			setFunctionModule(x + dx, y + dy, std::max(std::abs(dx), std::abs(dy)) != 1);
+	}
+}
+
+
+void QrMatrix::setFunctionModule(int x, int y, bool isBlack) {
+	setModule(x, y, isBlack);
+	isFunction [y * rowWords + (x >> 5)] |= UINT32_C(1) << (x & 31);
+	isFunctionT[x * rowWords + (y >> 5)] |= UINT32_C(1) << (y & 31);
+}
+
+
+void QrMatrix::setModule(int x, int y, bool isBlack) {
+	uint32_t &word  = modules [y * rowWords + (x >> 5)];
+	uint32_t &wordT = modulesT[x * rowWords + (y >> 5)];
+	if (isBlack) {
+		word  |= UINT32_C(1) << (x & 31);
+		wordT |= UINT32_C(1) << (y & 31);
+	} else {
+		word  &= ~(UINT32_C(1) << (x & 31));
+		wordT &= ~(UINT32_C(1) << (y & 31));
+	}
+}
+
+
+void QrMatrix::addEccAndInterleave(uint8_t *data, uint8_t *result) const {
+	// Calculate parameter numbers
+	int numBlocks = QrCode::NUM_ERROR_CORRECTION_BLOCKS[static_cast<int>(errorCorrectionLevel)][version];
+	int blockEccLen = QrCode::ECC_CODEWORDS_PER_BLOCK  [static_cast<int>(errorCorrectionLevel)][version];
+	int rawCodewords = getNumRawCodewords(version);
+	int dataLen = QrCode::getNumDataCodewords(version, errorCorrectionLevel);
+	int numShortBlocks = numBlocks - rawCodewords % numBlocks;
+	int shortBlockLen = rawCodewords / numBlocks;
+
+	// Split data into blocks, compute the ECC of each block after the data codewords,
+	// and write the bytes of every block straight to their interleaved positions
+	const uint8_t *divisor = Divisors::POLYNOMIALS[blockEccLen];
+	uint8_t *ecc = &data[dataLen];
+	const uint8_t *dat = data;
+	for (int i = 0; i < numBlocks; i++) {
+		int datLen = shortBlockLen - blockEccLen + (i < numShortBlocks ? 0 : 1);
+		getRemainder(dat, datLen, divisor, blockEccLen, ecc);
+		for (int j = 0, k = i; j < datLen; j++, k += numBlocks) {  // Copy data
+			if (j == shortBlockLen - blockEccLen)
+				k -= numShortBlocks;  // Skip the padding byte in short blocks
+			result[k] = dat[j];
+		}
+		for (int j = 0, k = dataLen + i; j < blockEccLen; j++, k += numBlocks)  // Copy ECC
+			result[k] = ecc[j];
+		dat += datLen;
+	}
+}
+
+
+void QrMatrix::drawCodewords(const uint8_t *data) {
+	size_t dataBits = getNumRawCodewords(version) * 8;
+	size_t i = 0;  // Bit index into the data
+	// Do the funny zigzag scan
+	for (int right = size - 1; right >= 1; right -= 2) {  // Index of right column in each column pair
+		if (right == 6)
+			right = 5;
+		for (int vert = 0; vert < size; vert++) {  // Vertical counter
+			for (int j = 0; j < 2; j++) {
+				int x = right - j;  // Actual x coordinate
+				bool upward = ((right + 1) & 2) == 0;
+				int y = upward ? size - 1 - vert : vert;  // Actual y coordinate
+				if (((isFunction[y * rowWords + (x >> 5)] >> (x & 31)) & 1) == 0 && i < dataBits) {
+					setModule(x, y, getBit(data[i >> 3], 7 - static_cast<int>(i & 7)));
+					i++;
+				}
+				// If this QR Code has any remainder bits (0 to 7), they were assigned as
+				// 0/false/white by draw() and are left unchanged by this method
+			}
+		}
+	}
+}
+
+
+bool QrMatrix::isMasked(int mask, int x, int y) {
+	switch (mask) {
+		case 0:  return (x + y) % 2 == 0;
+		case 1:  return y % 2 == 0;
+		case 2:  return x % 3 == 0;
+		case 3:  return (x + y) % 3 == 0;
+		case 4:  return (x / 3 + y / 2) % 2 == 0;
+		case 5:  return x * y % 2 + x * y % 3 == 0;
+		case 6:  return (x * y % 2 + x * y % 3) % 2 == 0;
+		case 7:  return ((x + y) % 2 + x * y % 3) % 2 == 0;
+		default:  return false;
+	}
+}
+
+
+void QrMatrix::getMaskRows(int mask, bool transposed, uint32_t *rows) const {
+	std::memset(rows, 0, MASK_ROW_PERIOD * rowWords * sizeof(uint32_t));
+	for (int phase = 0; phase < MASK_ROW_PERIOD; phase++) {
+		uint32_t *row = &rows[phase * rowWords];
+		for (int i = 0; i < size; i++) {
+			if (transposed ? isMasked(mask, phase, i) : isMasked(mask, i, phase))
+				row[i >> 5] |= UINT32_C(1) << (i & 31);
+		}
+	}
+}
+
+
+void QrMatrix::applyMask(int mask) {
+	// Each row is XORed a word at a time with the pattern row of its phase, sparing function modules
+	uint32_t maskRows[MASK_ROW_PERIOD * MAX_ROW_WORDS];
+	getMaskRows(mask, false, maskRows);
+	for (int y = 0; y < size; y++) {
+		const uint32_t *maskRow = &maskRows[(y % MASK_ROW_PERIOD) * rowWords];
+		for (int i = 0; i < rowWords; i++)
+			modules[y * rowWords + i] ^= maskRow[i] & ~isFunction[y * rowWords + i];
+	}
+	getMaskRows(mask, true, maskRows);
+	for (int x = 0; x < size; x++) {
+		const uint32_t *maskRow = &maskRows[(x % MASK_ROW_PERIOD) * rowWords];
+		for (int i = 0; i < rowWords; i++)
+			modulesT[x * rowWords + i] ^= maskRow[i] & ~isFunctionT[x * rowWords + i];
+	}
+}
+
+
+long QrMatrix::getLinePenalty(const uint32_t *line) const {
+	long result = 0;
+	int runHistory[7] = {0, 0, 0, 0, 0, 0, 0};
+	bool color = false;
+	int runStart = 0;
+	uint32_t carry = 0;  // Color of the module before each word, white before the line starts
+	for (int i = 0; i < rowWords; i++) {
+		// Set bits mark modules whose color differs from the previous module
+		uint32_t changes = line[i] ^ ((line[i] << 1) | carry);
+		carry = line[i] >> 31;
+		if (i == rowWords - 1 && (size & 31) != 0)
+			changes &= (UINT32_C(1) << (size & 31)) - 1;
+		while (changes != 0) {
+			int x = i * 32 + __builtin_ctz(changes);
+			changes &= changes - 1;
+			int run = x - runStart;
+			if (run >= 5)
+				result += PENALTY_N1 + (run - 5);
+			addRunToHistory(run, runHistory);
+			if (!color && hasFinderLikePattern(runHistory))
+				result += PENALTY_N3;
+			color = !color;
+			runStart = x;
+		}
+	}
+	int run = size - runStart;
+	if (run >= 5)
+		result += PENALTY_N1 + (run - 5);
+	addRunToHistory(run, runHistory);
+	if (color)
+		addRunToHistory(0, runHistory);  // Dummy run of white
+	if (hasFinderLikePattern(runHistory))
+		result += PENALTY_N3;
+	return result;
+}
+
+
+long QrMatrix::getPenaltyScore() const {
+	long result = 0;
+
+	// Adjacent modules in row and in column having same color, and finder-like patterns
+	for (int i = 0; i < size; i++) {
+		result += getLinePenalty(&modules[i * rowWords]);
+		result += getLinePenalty(&modulesT[i * rowWords]);
+	}
+
+	// 2*2 blocks of modules having same color, as bits set where a module matches
+	// its right neighbour in both rows and the module below it
+	for (int y = 0; y < size - 1; y++) {
+		const uint32_t *upper = &modules[y * rowWords];
+		const uint32_t *lower = &modules[(y + 1) * rowWords];
+		for (int i = 0; i < rowWords; i++) {
+			uint32_t upperNext = (upper[i] >> 1) | (i + 1 < rowWords ? upper[i + 1] << 31 : 0);
+			uint32_t lowerNext = (lower[i] >> 1) | (i + 1 < rowWords ? lower[i + 1] << 31 : 0);
+			uint32_t same = ~(upper[i] ^ upperNext) & ~(lower[i] ^ lowerNext) & ~(upper[i] ^ lower[i]);
+			int valid = size - 1 - i * 32;  // Blocks start at x < size - 1
+			if (valid < 32)
+				same &= (UINT32_C(1) << valid) - 1;
+			result += __builtin_popcount(same) * PENALTY_N2;
+		}
+	}
+
+	// Balance of black and white modules
+	int black = 0;
+	for (int i = 0; i < size * rowWords; i++)
+		black += __builtin_popcount(modules[i]);
+	int total = size * size;  // Note that size is odd, so black/total != 1/2
+	// Compute the smallest integer k >= 0 such that (45-5k)% <= black/total <= (55+5k)%
+	int k = static_cast<int>((std::abs(black * 20L - total * 10L) + total - 1) / total) - 1;
+	result += k * PENALTY_N4;
+	return result;
+}
+
+
+int QrMatrix::getAlignmentPatternPositions(int result[7]) const {
+	if (version == 1)
+		return 0;
+	else {
+		int numAlign = version / 7 + 2;
+		int step = (version == 32) ? 26 :
+			(version*4 + numAlign*2 + 1) / (numAlign*2 - 2) * 2;
+		for (int i = numAlign - 1, pos = size - 7; i >= 1; i--, pos -= step)
+			result[i] = pos;
+		result[0] = 6;
+		return numAlign;
+	}
+}
+
+
+void QrMatrix::getRemainder(const uint8_t *data, int dataLen,
+		const uint8_t *divisor, int degree, uint8_t *result) {
+	// Compute the remainder by performing polynomial division
+	std::memset(result, 0, degree);
+	for (int i = 0; i < dataLen; i++) {
+		uint8_t factor = data[i] ^ result[0];
+		std::memmove(&result[0], &result[1], degree - 1);
+		result[degree - 1] = 0;
+		if (factor == 0)
+			continue;
+		int logFactor = GfLog::VALUES[factor];
+		for (int j = 0; j < degree; j++) {
+			if (divisor[j] != 0)
+				result[j] ^= GfExp::VALUES[GfLog::VALUES[divisor[j]] + logFactor];
+		}
+	}
+}
+
+
+void QrMatrix::addRunToHistory(int run, int history[7]) {
+	std::memmove(&history[1], &history[0], 6 * sizeof(history[0]));
+	history[0] = run;
+}
+
+
+bool QrMatrix::hasFinderLikePattern(const int runHistory[7]) {
+	int n = runHistory[1];
+	return n > 0 && runHistory[2] == n && runHistory[4] == n && runHistory[5] == n
+		&& runHistory[3] == n * 3 && std::max(runHistory[0], runHistory[6]) >= n * 4;
+}
+
+
+bool QrMatrix::getBit(long x, int i) {
+	return ((x >> i) & 1) != 0;
+}
+
+
+/*---- Tables of constants ----*/
+
+const int QrMatrix::PENALTY_N1 =  3;
+const int QrMatrix::PENALTY_N2 =  3;
+const int QrMatrix::PENALTY_N3 = 40;
+const int QrMatrix::PENALTY_N4 = 10;
+
+constexpr int QrMatrix::MASK_ROW_PERIOD;
+constexpr int QrMatrix::MAX_ROW_WORDS;
+
+}
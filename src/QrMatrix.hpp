@@ -0,0 +1,281 @@
+/*
+ * QR Code generator library (C++)
+ *
+ * Copyright (c) Project Nayuki. (MIT License)
+ * https://www.nayuki.io/page/qr-code-generator-library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * - The above copyright notice and this permission notice shall be included in
+ *   all copies or substantial portions of the Software.
+ * - The Software is provided "as is", without warranty of any kind, express or
+ *   implied, including but not limited to the warranties of merchantability,
+ *   fitness for a particular purpose and noninfringement. In no event shall the
+ *   authors or copyright holders be liable for any claim, damages or other
+ *   liability, whether in an action of contract, tort or otherwise, arising from,
+ *   out of or in connection with the Software or the use or other dealings in the
+ *   Software.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "QrCode.hpp"
+#include "QrSegment.hpp"
+
+
+namespace qrcodegen {
+
+/*
+ * The outcome of a heap-free encoding step, returned instead of throwing an exception.
+ */
+enum class QrStatus {
+	OK = 0          ,  // The symbol was built
+	INVALID_ARGUMENT,  // A version or mask argument is out of range
+	DATA_TOO_LONG   ,  // The data does not fit in any allowed version
+};
+
+
+
+/*
+ * The module grid of a QR Code symbol under construction, kept in caller-provided storage.
+ * It draws the function patterns, codewords with their error correction and the mask without
+ * allocating or throwing, and is the common core of QrCode (vector storage) and QrCodeStatic
+ * (fixed arrays). Each grid stores its rows as 32-bit words with module x at bit (x % 32)
+ * of word (x / 32), and must hold at least getGridWords(version) words.
+ */
+class QrMatrix final {
+
+	/*---- Static functions ----*/
+
+	// Returns the number of 32-bit words that one packed grid of the given version occupies.
+	public: static constexpr int getGridWords(int ver) {
+		return (ver * 4 + 17) * ((ver * 4 + 17 + 31) / 32);
+	}
+
+
+	// Returns the number of 8-bit codewords (data and error correction) in a QR Code of the given
+	// version, which is the length both codeword buffers passed to draw() must have.
+	public: static constexpr int getNumRawCodewords(int ver) {
+		return ((16 * ver + 128) * ver + 64
+			- (ver >= 2 ? (25 * (ver / 7 + 2) - 10) * (ver / 7 + 2) - 55 : 0)
+			- (ver >= 7 ? 36 : 0)) / 8;
+	}
+
+
+	/*
+	 * Packs the given text into the data codewords of the smallest version in the given range
+	 * that fits it, using a single numeric, alphanumeric or byte segment exactly as
+	 * QrSegment::makeSegments() chooses, then raises ecl while the data still fits if boostEcl
+	 * is set. The data buffer must hold getNumRawCodewords(maxVersion) bytes. On success,
+	 * version and ecl are set to the values the codewords were packed for.
+	 */
+	public: static QrStatus encodeText(const char *text, QrCode::Ecc &ecl, int minVersion, int maxVersion,
+		bool boostEcl, std::uint8_t *data, int &version);
+
+
+	/*
+	 * Packs the given segments into the data codewords of the smallest version in the given range
+	 * that fits them, like QrCode::encodeSegments() but into the given buffer, which must hold
+	 * getNumRawCodewords(maxVersion) bytes. On success, version and ecl are set as for encodeText().
+	 */
+	public: static QrStatus encodeSegments(const std::vector<QrSegment> &segs, QrCode::Ecc &ecl,
+		int minVersion, int maxVersion, bool boostEcl, std::uint8_t *data, int &version);
+
+
+	/*
+	 * Computes the Reed-Solomon error correction codewords of one block of dataLen data codewords
+	 * into the result array, using the precomputed divisor of the given degree. The degree is the
+	 * ECC length of one block, between 1 and QrCode::MAX_ECC_CODEWORDS_PER_BLOCK.
+	 */
+	public: static QrStatus getEccCodewords(const std::uint8_t *data, int dataLen, int degree, std::uint8_t *result);
+
+
+	// Returns the highest error correction level at which the given number of data bits
+	// still fits in the given version, or the given level if none of the higher ones fit.
+	private: static QrCode::Ecc getBoostedEcl(QrCode::Ecc ecl, int version, long dataUsedBits);
+
+
+
+	/*---- Instance fields ----*/
+
+	private: int version;
+
+	private: int size;
+
+	private: QrCode::Ecc errorCorrectionLevel;
+
+	// The mask chosen by draw(), or -1 before it succeeds.
+	private: int mask;
+
+	// Number of 32-bit words per packed row, between 1 and 6.
+	private: int rowWords;
+
+	// The modules being drawn, and which of them are function modules, in row order.
+	private: std::uint32_t *modules;
+	private: std::uint32_t *isFunction;
+
+	// Transposed copies of the grids above (row i holds column i), so columns are scored
+	// with the same word-wide operations as rows.
+	private: std::uint32_t *modulesT;
+	private: std::uint32_t *isFunctionT;
+
+
+
+	/*---- Constructor ----*/
+
+	/*
+	 * Creates a grid for a QR Code of the given version and error correction level over the given
+	 * storage, which is not touched until draw() is called and must outlive this object.
+	 */
+	public: QrMatrix(int ver, QrCode::Ecc ecl, std::uint32_t *modules, std::uint32_t *isFunction,
+		std::uint32_t *modulesT, std::uint32_t *isFunctionT);
+
+
+
+	/*---- Public instance methods ----*/
+
+	/*
+	 * Clears the grids and draws the complete symbol: function patterns, the data codewords with
+	 * their error correction codewords, and the given mask, or the lowest-penalty mask if it is -1.
+	 * The data buffer holds the data codewords at its start and is used as scratch space for the
+	 * error correction; the codewords buffer receives the interleaved sequence. Both must hold
+	 * getNumRawCodewords(version) bytes.
+	 */
+	public: QrStatus draw(std::uint8_t *data, std::uint8_t *codewords, int mask);
+
+
+	public: int getSize() const;
+
+
+	public: int getMask() const;
+
+
+
+	/*---- Private helper methods: Drawing function modules ----*/
+
+	// Reads this object's version field, and draws and marks all function modules.
+	private: void drawFunctionPatterns();
+
+
+	// Draws two copies of the format bits (with its own error correction code)
+	// based on the given mask and this object's error correction level field.
+	private: void drawFormatBits(int mask);
+
+
+	// Draws two copies of the version bits (with its own error correction code),
+	// based on this object's version field, iff 7 <= version <= 40.
+	private: void drawVersion();
+
+
+	// Draws a 9*9 finder pattern including the border separator,
+	// with the center module at (x, y). Modules can be out of bounds.
+	private: void drawFinderPattern(int x, int y);
+
+
+	// Draws a 5*5 alignment pattern, with the center module
+	// at (x, y). All modules must be in bounds.
+	private: void drawAlignmentPattern(int x, int y);
+
+
+	// Sets the color of a module and marks it as a function module.
+	// Coordinates must be in bounds.
+	private: void setFunctionModule(int x, int y, bool isBlack);
+
+
+	// Sets the color of a module in both the row and column grids. Coordinates must be in bounds.
+	private: void setModule(int x, int y, bool isBlack);
+
+
+	/*---- Private helper methods: Codewords and masking ----*/
+
+	// Appends the error correction codewords to the data codewords in the data buffer, based on
+	// this object's version and error correction level, and writes the interleaved result.
+	private: void addEccAndInterleave(std::uint8_t *data, std::uint8_t *result) const;
+
+
+	// Draws the given sequence of 8-bit codewords (data and error correction) onto the entire
+	// data area of this QR Code. Function modules need to be marked off before this is called.
+	private: void drawCodewords(const std::uint8_t *data);
+
+
+	// XORs the codeword modules in this QR Code with the given mask pattern.
+	// The function modules must be marked and the codeword bits must be drawn
+	// before masking. Due to the arithmetic of XOR, calling applyMask() with
+	// the same mask value a second time will undo the mask. A final well-formed
+	// QR Code needs exactly one (not zero, two, etc.) mask applied.
+	private: void applyMask(int mask);
+
+
+	// Calculates and returns the penalty score based on state of this QR Code's current modules.
+	// This is used by the automatic mask choice algorithm to find the mask pattern that yields the lowest score.
+	private: long getPenaltyScore() const;
+
+
+	// Calculates the penalty for runs of same color and finder-like patterns
+	// along one packed row of the given grid. A helper function for getPenaltyScore().
+	private: long getLinePenalty(const std::uint32_t *line) const;
+
+
+	// Fills one packed row per row phase (the patterns repeat every 12 rows and 6 columns)
+	// with the modules the given mask inverts, for either grid. The array holds
+	// MASK_ROW_PERIOD * rowWords words.
+	private: void getMaskRows(int mask, bool transposed, std::uint32_t *rows) const;
+
+
+	// Returns whether the given mask pattern inverts the module at (x, y).
+	private: static bool isMasked(int mask, int x, int y);
+
+
+
+	/*---- Private helper functions ----*/
+
+	// Stores the ascending positions of alignment patterns for this version number in the given
+	// array and returns how many there are, between 0 and 7. Each position is in the range [0,177),
+	// and are used on both the x and y axes.
+	private: int getAlignmentPatternPositions(int result[7]) const;
+
+
+	// Computes the Reed-Solomon error correction codewords for the given data codewords
+	// using the given divisor polynomial of the given degree, into the result array.
+	private: static void getRemainder(const std::uint8_t *data, int dataLen,
+		const std::uint8_t *divisor, int degree, std::uint8_t *result);
+
+
+	// Inserts the given value to the front of the given array, which shifts over the
+	// existing values and deletes the last value. A helper function for getPenaltyScore().
+	private: static void addRunToHistory(int run, int history[7]);
+
+
+	// Tests whether the given run history has the pattern of ratio 1:1:3:1:1 in the middle, and
+	// surrounded by at least 4 on either or both ends. A helper function for getPenaltyScore().
+	// Must only be called immediately after a run of white modules has ended.
+	private: static bool hasFinderLikePattern(const int runHistory[7]);
+
+
+	// Returns true iff the i'th bit of x is set to 1.
+	private: static bool getBit(long x, int i);
+
+
+	/*---- Constants ----*/
+
+	// For use in getPenaltyScore(), when evaluating which mask is best.
+	private: static const int PENALTY_N1;
+	private: static const int PENALTY_N2;
+	private: static const int PENALTY_N3;
+	private: static const int PENALTY_N4;
+
+	// Mask patterns repeat every MASK_ROW_PERIOD rows (and every 6 columns).
+	private: static constexpr int MASK_ROW_PERIOD = 12;
+
+	// The most words a packed row can take, for a version 40 symbol.
+	private: static constexpr int MAX_ROW_WORDS = (QrCode::MAX_VERSION * 4 + 17 + 31) / 32;
+
+};
+
+}
@@ -62,7 +62,7 @@ const QrSegment::Mode QrSegment::Mode::ECI         (0x7,  0,  0,  0);
 QrSegment QrSegment::makeBytes(const vector<uint8_t> &data) {
 	if (data.size() > static_cast<unsigned int>(INT_MAX))
 		throw std::length_error("Data too long");
-	BitBuffer bb;
+	BitBuffer bb(data.size() * 8);
 	for (uint8_t b : data)
 		bb.appendBits(b, 8);
 	return QrSegment(Mode::BYTE, static_cast<int>(data.size()), std::move(bb));
@@ -70,7 +70,7 @@ QrSegment QrSegment::makeBytes(const vector<uint8_t> &data) {
 
 
 QrSegment QrSegment::makeNumeric(const char *digits) {
-	BitBuffer bb;
+	BitBuffer bb(std::strlen(digits) * 10 / 3 + 7);
 	int accumData = 0;
 	int accumCount = 0;
 	int charCount = 0;
@@ -93,7 +93,7 @@ QrSegment QrSegment::makeNumeric(const char *digits) {
 
 
 QrSegment QrSegment::makeAlphanumeric(const char *text) {
-	BitBuffer bb;
+	BitBuffer bb(std::strlen(text) * 11 / 2 + 6);
 	int accumData = 0;
 	int accumCount = 0;
 	int charCount = 0;
@@ -151,7 +151,7 @@ QrSegment QrSegment::makeEci(long assignVal) {
 }
 
 
-QrSegment::QrSegment(Mode md, int numCh, const std::vector<bool> &dt) :
+QrSegment::QrSegment(Mode md, int numCh, const BitBuffer &dt) :
 		mode(md),
 		numChars(numCh),
 		data(dt) {
@@ -160,7 +160,7 @@ QrSegment::QrSegment(Mode md, int numCh, const std::vector<bool> &dt) :
 }
 
 
-QrSegment::QrSegment(Mode md, int numCh, std::vector<bool> &&dt) :
+QrSegment::QrSegment(Mode md, int numCh, BitBuffer &&dt) :
 		mode(md),
 		numChars(numCh),
 		data(std::move(dt)) {
@@ -215,7 +215,7 @@ int QrSegment::getNumChars() const {
 }
 
 
-const std::vector<bool> &QrSegment::getData() const {
+const BitBuffer &QrSegment::getData() const {
 	return data;
 }
 
@@ -158,7 +158,7 @@ class QrSegment final {
 	private: int numChars;
 	
 	/* The data bits of this segment. Accessed through getData(). */
-	private: std::vector<bool> data;
+	private: BitBuffer data;
 	
 	
 	/*---- Constructors (low level) ----*/
@@ -168,7 +168,7 @@ class QrSegment final {
 	 * The character count (numCh) must agree with the mode and the bit buffer length,
 	 * but the constraint isn't checked. The given bit buffer is copied and stored.
 	 */
-	public: QrSegment(Mode md, int numCh, const std::vector<bool> &dt);
+	public: QrSegment(Mode md, int numCh, const BitBuffer &dt);
 	
 	
 	/* 
@@ -176,7 +176,7 @@ class QrSegment final {
 	 * The character count (numCh) must agree with the mode and the bit buffer length,
 	 * but the constraint isn't checked. The given bit buffer is moved and stored.
 	 */
-	public: QrSegment(Mode md, int numCh, std::vector<bool> &&dt);
+	public: QrSegment(Mode md, int numCh, BitBuffer &&dt);
 	
 	
 	/*---- Methods ----*/
@@ -196,7 +196,7 @@ class QrSegment final {
 	/* 
 	 * Returns the data bits of this segment.
 	 */
-	public: const std::vector<bool> &getData() const;
+	public: const BitBuffer &getData() const;
 	
 	
 	// (Package-private) Calculates the number of bits needed to encode the given segments at
@@ -207,6 +207,10 @@ class QrSegment final {
 	
 	/*---- Private constant ----*/
 	
+	// Packs text segments without allocating, using the character set below.
+	friend class QrMatrix;
+	
+	
 	/* The set of all legal characters in alphanumeric mode, where
 	 * each character value maps to the index in the string. */
 	private: static const char *ALPHANUMERIC_CHARSET;
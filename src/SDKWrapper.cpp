@@ -16,11 +16,11 @@ SDKWrapper :: SDKWrapper(){
 
 bool SDKWrapper :: isDevicePaired(){
   //Check pairing status for the device
-  String* psResponse = pairService->getPairingStatus();
-  debugD("\nSDKWrapper :: isDevicePaired: Pairing Status Response: %s",psResponse->c_str());
+  String psResponse = pairService->getPairingStatus();
+  debugD("\nSDKWrapper :: isDevicePaired: Pairing Status Response: %s",psResponse.c_str());
   debugD("\nSDKWrapper :: isDevicePaired: Device State -> %s",store->getDeviceStatusMsg());
 
-  if(psResponse->indexOf("true") != -1)
+  if(psResponse.indexOf("true") != -1)
     return true;
   else
     return false;
@@ -41,8 +41,20 @@ void SDKWrapper :: waitForSeconds(const int seconds){
 
 bool SDKWrapper :: pairAndActivateDevice(){
   bool deviceStatus = false;
+  BootOrchestrator* boot = BootOrchestrator :: getBootOrchestratorInstance();
+  //Device activated earlier is trusted right away, pairing is verified in the background
+  if(pairService->isPersistedStateValid()){
+    debugI("\nSDKWrapper :: pairAndActivateDevice: Device State -> %s, verifying pairing in background",store->getDeviceStatusMsg());
+    PairingService :: startPairingVerification();
+    boot->recordBoot();
+    return true;
+  }
+
   //Device is already paired, check for device validity
-  if(isDevicePaired()){
+  boot->beginPhase(BOOT_PHASE_PAIRING_CHECK);
+  bool paired = isDevicePaired();
+  boot->endPhase(BOOT_PHASE_PAIRING_CHECK);
+  if(paired){
     debugI("\nSDKWrapper :: pairAndActivateDevice: Device is already paired, checking device's state is valid or not");
     //Below situation occurs when the same device is switched between Multipair and Singlepair
     //Reset Device State and Initialize
@@ -53,6 +65,7 @@ bool SDKWrapper :: pairAndActivateDevice(){
       debugI("\nSDKWrapper :: pairAndActivateDevice: Invalid device state, initializing as new device");
       store->resetDeviceState();
       store->resetQRCodeStatus();
+      BoTService :: getBoTServiceInstance()->resetSigningKey();
       configService->initialize();
       configService->configureDevice();
     }
@@ -65,11 +78,15 @@ bool SDKWrapper :: pairAndActivateDevice(){
   BluetoothService* bleService = new BluetoothService();
   configService->initialize();
   debugD("\nSDKWrapper :: pairAndActivateDevice: Free Heap before BLE Init: %u", ESP.getFreeHeap());
+  boot->beginPhase(BOOT_PHASE_BLE_INIT);
   bleService->initializeBLE();
+  boot->endPhase(BOOT_PHASE_BLE_INIT);
+  boot->recordBoot();
   bool bleClientConnected = false;
+  PollingPolicy blePolicy;
   //Wait till device gets paired from FINN APP through BLE
   do {
-    waitForSeconds(2);
+    blePolicy.waitFor(POLLING_INITIAL_INTERVAL_IN_MILLISECONDS);
     bleClientConnected = bleService->isBLEClientConnected();
     if(!bleClientConnected)
       debugI("\nSDKWrapper :: pairAndActivateDevice: Waiting for BLE Client to connect...");
@@ -80,6 +97,7 @@ bool SDKWrapper :: pairAndActivateDevice(){
   //Wait for client to complete it's job
   debugI("\nSDKWrapper :: pairAndActivateDevice: Waiting for BLE Client to provide WiFi Config Details / Skip WiFi Config");
   while(bleClientConnected) {
+    blePolicy.waitFor(POLLING_INITIAL_INTERVAL_IN_MILLISECONDS);
     bleClientConnected = bleService->isBLEClientConnected();
   }
 
@@ -95,14 +113,16 @@ bool SDKWrapper :: pairAndActivateDevice(){
   configService->configureDevice();
  }
 
- //Wait till device gets paired from FINN Application
+ //Wait till device gets paired from FINN Application, backing off between checks
+ PollingPolicy pairingPolicy(store->getPollingInitialInterval(), store->getPollingMaximumInterval());
  while(!isDevicePaired()){
    debugI("\nSDKWrapper :: pairAndActivateDevice: Waiting for device pairing get completed from FINN Application");
-   waitForSeconds(20);
+   pairingPolicy.wait();
  }
 
  //Call pairing service pairDevice method to activate the device
  pairService->pairDevice();
+ boot->recordBoot();
 
  //Device State should be active at this Point, if it's single pair
  if(!store->isDeviceMultipair() && (store->getDeviceState() == DEVICE_ACTIVE)){
@@ -119,11 +139,35 @@ bool SDKWrapper :: pairAndActivateDevice(){
  return deviceStatus;
 }
 
+String SDKWrapper :: retrieveActions(){
+  return actionService->retrieveActions();
+}
+
 String* SDKWrapper :: getActions(){
   return actionService->getActions();
 }
 
-bool SDKWrapper :: triggerAction(const char* actionID, const char* value, const char* altID){
+String SDKWrapper :: getDeadLetterActions(){
+  return store->getDeadLetterActions();
+}
+
+String SDKWrapper :: getBootRecords(){
+  return store->getBootRecords();
+}
+
+bool SDKWrapper :: clearDeadLetterActions(){
+  return store->clearDeadLetterActions();
+}
+
+const LatencyHistogram* SDKWrapper :: getLatencyHistogram(const char* endPoint){
+  return BoTService :: getBoTServiceInstance()->getLatencyHistogram(endPoint);
+}
+
+const struct RequestTrace* SDKWrapper :: getLastRequestTrace(){
+  return BoTService :: getBoTServiceInstance()->getLastRequestTrace();
+}
+
+bool SDKWrapper :: triggerAction(const char* actionID, const char* value, const char* altID, const byte priority){
   if(store->getDeviceState() < DEVICE_ACTIVE){
     debugW("\nSDKWrapper :: triggerAction : Invalid Device state to trigger action");
     return false;
@@ -146,14 +190,15 @@ bool SDKWrapper :: triggerAction(const char* actionID, const char* value, const
       }
 
       bool triggerResult = false;
-      String* response = actionService->triggerAction(actionID,value);
-      if(response != NULL){
-        debugD("\nSDKWrapper :: triggerAction: Response: %s", response->c_str());
-        if(response->indexOf("OK") != -1) {
+      char message[ACTION_RESULT_MESSAGE_LENGTH+1];
+      byte result = actionService->triggerAction(actionID,value,priority,altID,message);
+      if(result != ACTION_RESULT_OFFLINE){
+        debugD("\nSDKWrapper :: triggerAction: Response: %s", message);
+        if(result == ACTION_RESULT_SUCCEEDED) {
           debugI("\nSDKWrapper :: triggerAction: Action triggered successful");
           triggerResult = true;
         }
-        else if(response->indexOf("Action not found") != -1){
+        else if(strstr(message, "Action not found") != NULL){
           debugW("\nSDKWrapper :: triggerAction: Action not triggered as its not found");
           triggerResult = false;
         }
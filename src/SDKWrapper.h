@@ -13,12 +13,21 @@
 #include "ActionService.h"
 #include "ConfigurationService.h"
 #include "BluetoothService.h"
+#include "BootOrchestrator.h"
 class SDKWrapper {
   public:
           SDKWrapper();
+          String retrieveActions();
+          //Previous interface, the returned String is owned by the SDK and valid until the next call
           String* getActions();
           bool pairAndActivateDevice();
-          bool triggerAction(const char* actionID, const char* value = NULL, const char* altID = NULL);
+          bool triggerAction(const char* actionID, const char* value = NULL, const char* altID = NULL,
+                                                 const byte priority = ACTION_PRIORITY_DEFAULT);
+          String getDeadLetterActions();
+          bool clearDeadLetterActions();
+          String getBootRecords();
+          const LatencyHistogram* getLatencyHistogram(const char* endPoint);
+          const struct RequestTrace* getLastRequestTrace();
           void waitForSeconds(const int seconds);
   private:
     KeyStore* store;
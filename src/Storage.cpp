@@ -7,6 +7,7 @@
 #include "Storage.h"
 using namespace qrcodegen;
 KeyStore* KeyStore::store = NULL;
+DeviceQRCode KeyStore::qrCode;
 
 KeyStore* KeyStore:: getKeyStoreInstance(){
   if(store == NULL){
@@ -25,7 +26,8 @@ KeyStore :: KeyStore(){
   makerID = NULL;
   deviceID = NULL;
   deviceName = NULL;
-  deviceInfo = NULL;
+  qrCodeMutex = xSemaphoreCreateMutex();
+  qrCodeBuilderRunning = false;
   deviceStatus = NULL;
   altDeviceID = NULL;
   privateKey = NULL;
@@ -34,6 +36,10 @@ KeyStore :: KeyStore(){
   caCert = NULL;
   qrCACert = NULL;
   uuidStr = NULL;
+  offlineActionsDepth = -1;
+  pollingInitialInterval = POLLING_INITIAL_INTERVAL_IN_MILLISECONDS;
+  pollingMaximumInterval = POLLING_MAXIMUM_INTERVAL_IN_MILLISECONDS;
+  qrPayloadFormat = QR_PAYLOAD_JSON;
   qrCodeStatus = false;
   jsonCfgLoadStatus = NOT_LOADED;
   privateKeyLoadStatus = NOT_LOADED;
@@ -42,50 +48,61 @@ KeyStore :: KeyStore(){
   caCertLoadStatus = NOT_LOADED;
 }
 
-String* KeyStore :: getDeviceInfo(){
-  if(deviceInfo != NULL){
-    debugD("\nKeyStore :: getDeviceInfo: Already collected device info");
-    return deviceInfo;
-  }
-
-  if(isJSONConfigLoaded() && isPublicKeyLoaded()){
-    debugD("\nKeyStore :: getDeviceInfo: Getting device specific data");
-    const char* deviceID = getDeviceID();
-    const char* deviceName = getDeviceName();
-    const char* makerID = getMakerID();
-    const char* publicKey = getDevicePublicKey();
-
-    DynamicJsonBuffer jsonBuffer;
-    JsonObject& doc = jsonBuffer.createObject();
-    doc["deviceID"] = deviceID;
-    doc["name"] = deviceName;
-    doc["makerID"] = makerID;
-    doc["publicKey"] = publicKey;
-    doc["multipair"] = 0;
-    if (getDeviceState() == DEVICE_MULTIPAIR) {
-      doc["multipair"] = 1;
-      doc["aid"] = getAlternateDeviceID();
-    }
-
-    char dInfo[1024];
-    doc.printTo(dInfo);
-    jsonBuffer.clear();
-    debugD("\nKeyStore :: getDeviceInfo: Data: %s", dInfo);
-    debugD("\nKeyStore :: getDeviceInfo: Length: %d", strlen(dInfo));
-
-    deviceInfo = new String(dInfo);
-  }
+String KeyStore :: getDeviceInfo(){
+  //Built on every call, it is read from BLE and QR Code tasks while the identity may change
+  String deviceInfo;
+  char dInfo[DEVICE_INFO_MAX_LENGTH];
+  if(getDeviceInfo(dInfo, sizeof(dInfo)) > 0)
+    deviceInfo = dInfo;
   return deviceInfo;
 }
 
+size_t KeyStore :: getDeviceInfo(char* buffer, const size_t size){
+  if(!isJSONConfigLoaded() || !isPublicKeyLoaded())
+    return 0;
+
+  debugD("\nKeyStore :: getDeviceInfo: Getting device specific data");
+  //Values are referenced, not copied, the JSON buffer only holds the object nodes
+  StaticJsonBuffer<JSON_OBJECT_SIZE(DEVICE_INFO_FIELDS)> jsonBuffer;
+  JsonObject& doc = jsonBuffer.createObject();
+  doc["deviceID"] = getDeviceID();
+  doc["name"] = getDeviceName();
+  doc["makerID"] = getMakerID();
+  doc["publicKey"] = getDevicePublicKey();
+  doc["multipair"] = 0;
+  if (getDeviceState() == DEVICE_MULTIPAIR) {
+    doc["multipair"] = 1;
+    doc["aid"] = getAlternateDeviceID();
+  }
+
+  if(doc.measureLength() >= size){
+    debugE("\nKeyStore :: getDeviceInfo: Device Info of %d bytes does not fit in %d bytes", doc.measureLength(), size);
+    return 0;
+  }
+  size_t length = doc.printTo(buffer, size);
+  debugD("\nKeyStore :: getDeviceInfo: Data: %s", buffer);
+  debugD("\nKeyStore :: getDeviceInfo: Length: %d", length);
+  return length;
+}
+
 void KeyStore :: setDeviceState(int state){
+  bool stateChanged = (getDeviceState() != state);
   EEPROM.write(DEVICE_STATE_ADDR, state);
   EEPROM.commit();
+  if(stateChanged){
+    EventService :: getEventServiceInstance()->publishDeviceState(state);
+    PollingPolicy :: signalStateChange();
+  }
 }
 
 void KeyStore :: resetDeviceState(){
+  bool stateChanged = (getDeviceState() != DEVICE_NEW);
   EEPROM.write(DEVICE_STATE_ADDR, DEVICE_NEW);
   EEPROM.commit();
+  if(stateChanged){
+    EventService :: getEventServiceInstance()->publishDeviceState(DEVICE_NEW);
+    PollingPolicy :: signalStateChange();
+  }
 }
 
 const int KeyStore :: getDeviceState(){
@@ -361,6 +378,38 @@ bool KeyStore :: updateWiFiConfiguration(const char* ssid, const char* passwd){
       altDeviceID = new String(adId);
     }
 
+    //Actions listed as high priority are served ahead of the remaining actions
+    highPriorityActions.clear();
+    JsonArray& priorityActions = json["high_priority_actions"];
+    if(priorityActions.success()){
+      for(int i=0; i < priorityActions.size(); i++){
+        const char* pActionID = priorityActions[i];
+        if(pActionID != NULL){
+          highPriorityActions.push_back(String(pActionID));
+        }
+      }
+      LOG("\nKeyStore :: loadJSONConfiguration: Parsed %d high priority actions from configuration",highPriorityActions.size());
+    }
+
+    //Polling intervals for pairing and activation status in milliseconds
+    pollingInitialInterval = json["polling_initial_interval"] | POLLING_INITIAL_INTERVAL_IN_MILLISECONDS;
+    pollingMaximumInterval = json["polling_maximum_interval"] | POLLING_MAXIMUM_INTERVAL_IN_MILLISECONDS;
+    if(pollingInitialInterval == 0)
+      pollingInitialInterval = POLLING_INITIAL_INTERVAL_IN_MILLISECONDS;
+    if(pollingMaximumInterval < pollingInitialInterval)
+      pollingMaximumInterval = pollingInitialInterval;
+    LOG("\nKeyStore :: loadJSONConfiguration: Polling interval from %lu ms up to %lu ms",pollingInitialInterval,pollingMaximumInterval);
+
+    //Payload of the device QR Code, full JSON by default
+    const char* qrPayload = json["qr_payload"] | "json";
+    if(strcmp(qrPayload, "compact") == 0)
+      qrPayloadFormat = QR_PAYLOAD_COMPACT;
+    else if(strcmp(qrPayload, "compact_hash") == 0)
+      qrPayloadFormat = QR_PAYLOAD_COMPACT_HASH;
+    else
+      qrPayloadFormat = QR_PAYLOAD_JSON;
+    LOG("\nKeyStore :: loadJSONConfiguration: QR Code payload format: %s",qrPayload);
+
     delete buffer;
     jsonBuffer.clear();
     jsonCfgLoadStatus = LOADED;
@@ -454,6 +503,29 @@ const char* KeyStore ::generateUuid4() {
   return uuidStr->c_str();
 }
 
+unsigned long KeyStore :: getPollingInitialInterval(){
+  return pollingInitialInterval;
+}
+
+unsigned long KeyStore :: getPollingMaximumInterval(){
+  return pollingMaximumInterval;
+}
+
+byte KeyStore :: getQRPayloadFormat(){
+  return qrPayloadFormat;
+}
+
+byte KeyStore :: getActionPriority(const char* actionID){
+  if(actionID == NULL)
+    return ACTION_PRIORITY_LOW;
+
+  for (std::vector<String>::iterator i = highPriorityActions.begin() ; i != highPriorityActions.end(); ++i){
+    if(i->equals(actionID))
+      return ACTION_PRIORITY_HIGH;
+  }
+  return ACTION_PRIORITY_LOW;
+}
+
 const char* KeyStore :: getAlternateDeviceID(){
   return (altDeviceID != NULL) ? altDeviceID->c_str() : NULL;
 }
@@ -724,31 +796,259 @@ bool KeyStore :: saveActions(std::vector <struct Action> aList){
 }
 
 bool KeyStore :: generateAndSaveQRCode(){
-  //QR Code is already generated and saved to SPIFFS, just return true
-  if(isQRCodeGeneratedandSaved()){
-    debugD("\nKeyStore :: generateAndSaveQRCode: QR Code already generated and saved to SPIFFS");
+  //Boot, configuration and the QR Code builder task may all get here, static qrCode is shared by them
+  xSemaphoreTake(qrCodeMutex, portMAX_DELAY);
+  bool built = buildQRCodeAsset();
+  xSemaphoreGive(qrCodeMutex);
+  return built;
+}
+
+bool KeyStore :: buildQRCodeAsset(){
+  String etag = makeQRCodeETag();
+  if(etag.length() == 0){
+    debugE("\nKeyStore :: buildQRCodeAsset: Configuration or public key not loaded");
+    qrCodeStatus = false;
     return qrCodeStatus;
   }
 
-  //Otherwise generate QR Code and Save to SPIFFS, set qrCodeStatus to true
-  qrCodeStatus = false;
+  //Asset in RAM is rebuilt only when the device identity changes
+  if(etag != qrCodeAsset.etag){
+    debugI("\nKeyStore :: buildQRCodeAsset: Generating QR Code with ETag %s", etag.c_str());
+    qrCodeAsset.etag = "";
+    if(!encodeQRCode()){
+      qrCodeStatus = false;
+      return qrCodeStatus;
+    }
 
-  const char* dInfo = (getDeviceInfo())->c_str();
-  debugD("\nKeyStore :: generateAndSaveQRCode: Device Info: %s",dInfo);
+    //SVG is compressed while it is written, only the compressed bytes are held in RAM
+    std::vector <uint8_t> gzip;
+    GzipWriter gz(gzip);
+    size_t svgSize = writeQRCodeSVG(qrCode, QRCODE_BORDER, gz);
+    gz.finish();
+    qrCodeAsset.gzip.swap(gzip);
+    qrCodeAsset.etag = etag;
+    debugD("\nKeyStore :: buildQRCodeAsset: SVG of %d bytes compressed to %d bytes", svgSize, qrCodeAsset.gzip.size());
+  }
 
-  QrCode qr = QrCode::encodeText(dInfo, QrCode::Ecc::QRLOW);
-  debugD("\nKeyStore :: generateAndSaveQRCode: Size of Generated QR Code: %d",qr.getSize());
+  //Copy on SPIFFS is rewritten only when it holds another identity, qrCode still holds this one
+  if(isQRCodeGeneratedandSaved() && getSavedQRCodeETag() == etag){
+    debugD("\nKeyStore :: buildQRCodeAsset: QR Code already generated and saved to SPIFFS");
+    return qrCodeStatus;
+  }
+  qrCodeStatus = saveQRCode(qrCode, etag);
+  return qrCodeStatus;
+}
 
-  //Save generated QR Code onto file
-  qrCodeStatus = saveQRCode(qr);
+bool KeyStore :: encodeQRCode(){
+  //Symbol is statically allocated, the compact payload still builds its segments on the heap
+  QrStatus status = QrStatus::INVALID_ARGUMENT;
+  if(qrPayloadFormat != QR_PAYLOAD_JSON){
+    std::vector <QrSegment> segs;
+    if(makeCompactDeviceInfo(segs))
+      status = qrCode.encodeSegments(segs, QrCode::Ecc::QRLOW);
+    if(status != QrStatus::OK)
+      debugW("\nKeyStore :: encodeQRCode: Compact payload not available, falling back to JSON payload");
+  }
+  if(status != QrStatus::OK){
+    //JSON payload is printed into a stack buffer and encoded from there without heap allocation
+    char info[DEVICE_INFO_MAX_LENGTH];
+    if(getDeviceInfo(info, sizeof(info)) == 0){
+      debugE("\nKeyStore :: encodeQRCode: Device Info not available");
+      return false;
+    }
+    status = qrCode.encodeText(info, QrCode::Ecc::QRLOW);
+  }
+  if(status != QrStatus::OK){
+    debugE("\nKeyStore :: encodeQRCode: Failed to generate QR Code, status: %d", static_cast<int>(status));
+    return false;
+  }
+  debugD("\nKeyStore :: encodeQRCode: Size of Generated QR Code: %d",qrCode.getSize());
+  return true;
+}
 
-  return qrCodeStatus;
+String KeyStore :: getQRCodeETag(){
+  String etag = makeQRCodeETag();
+  if(etag.length() == 0){
+    debugE("\nKeyStore :: getQRCodeETag: Configuration or public key not loaded");
+    return etag;
+  }
+
+  xSemaphoreTake(qrCodeMutex, portMAX_DELAY);
+  bool current = (etag == qrCodeAsset.etag);
+  //Identity changed since the asset was built, it is rebuilt on its own task instead of the caller's one
+  if(!current && !qrCodeBuilderRunning){
+    debugI("\nKeyStore :: getQRCodeETag: Device identity changed, regenerating QR Code with ETag %s", etag.c_str());
+    qrCodeBuilderRunning = (xTaskCreate(qrCodeBuilder, "qrCodeBuilder", QRCODE_BUILDER_STACK_SIZE, this,
+                                                        QRCODE_BUILDER_PRIORITY, NULL) == pdPASS);
+  }
+  xSemaphoreGive(qrCodeMutex);
+  return current?etag:String("");
+}
+
+size_t KeyStore :: writeQRCodeAsset(Print& out, const String& etag){
+  //Bytes are copied out under the lock, a rebuild can not change them half way
+  size_t written = 0;
+  xSemaphoreTake(qrCodeMutex, portMAX_DELAY);
+  if(etag == qrCodeAsset.etag)
+    written = out.write(qrCodeAsset.gzip.data(), qrCodeAsset.gzip.size());
+  xSemaphoreGive(qrCodeMutex);
+  return written;
+}
+
+void KeyStore :: qrCodeBuilder(void* param){
+  KeyStore* ks = (KeyStore*)param;
+  ks->generateAndSaveQRCode();
+  xSemaphoreTake(ks->qrCodeMutex, portMAX_DELAY);
+  ks->qrCodeBuilderRunning = false;
+  xSemaphoreGive(ks->qrCodeMutex);
+  vTaskDelete(NULL);
+}
+
+String KeyStore :: makeQRCodeETag(){
+  if(!isJSONConfigLoaded() || !isPublicKeyLoaded())
+    return String("");
+
+  //Digest over every field the QR Code payload is built from, NUL separated
+  bool multipairDevice = (getDeviceState() == DEVICE_MULTIPAIR);
+  const char* fields[5] = {getDeviceID(), getDeviceName(), getMakerID(), getDevicePublicKey(),
+                           multipairDevice ? getAlternateDeviceID() : ""};
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts_ret(&ctx, 0);
+  for(int i = 0; i < 5; i++){
+    const char* field = (fields[i] != NULL) ? fields[i] : "";
+    mbedtls_sha256_update_ret(&ctx, (const unsigned char*)field, strlen(field) + 1);
+  }
+  const unsigned char variant[2] = {(unsigned char)multipairDevice, qrPayloadFormat};
+  mbedtls_sha256_update_ret(&ctx, variant, sizeof(variant));
+  uint8_t digest[32];
+  mbedtls_sha256_finish_ret(&ctx, digest);
+  mbedtls_sha256_free(&ctx);
+
+  //Quoted hex prefix of the digest, as a strong validator
+  char etag[QRCODE_ETAG_LENGTH + 3];
+  etag[0] = '"';
+  for(int i = 0; i < QRCODE_ETAG_LENGTH / 2; i++)
+    sprintf(etag + 1 + 2 * i, "%02x", digest[i]);
+  etag[QRCODE_ETAG_LENGTH + 1] = '"';
+  etag[QRCODE_ETAG_LENGTH + 2] = '\0';
+  return String(etag);
+}
+
+bool KeyStore :: makeCompactDeviceInfo(std::vector <QrSegment>& segs){
+  if(!isJSONConfigLoaded() || !isPublicKeyLoaded()){
+    debugE("\nKeyStore :: makeCompactDeviceInfo: Configuration or public key not loaded");
+    return false;
+  }
+
+  //IDs go out as 16 raw bytes each, so both have to be UUIDs
+  uint8_t deviceUuid[16];
+  uint8_t makerUuid[16];
+  if(!parseUuid(getDeviceID(), deviceUuid) || !parseUuid(getMakerID(), makerUuid)){
+    debugW("\nKeyStore :: makeCompactDeviceInfo: deviceID or makerID is not a UUID");
+    return false;
+  }
+
+  //Public key as DER, or its SHA-256 digest
+  uint8_t key[QR_COMPACT_KEY_MAX_LENGTH];
+  size_t keyLength = decodePublicKey(getDevicePublicKey(), key, sizeof(key));
+  if(keyLength == 0){
+    debugE("\nKeyStore :: makeCompactDeviceInfo: Failed to decode public key");
+    return false;
+  }
+  byte flags = 0;
+  if(qrPayloadFormat == QR_PAYLOAD_COMPACT_HASH){
+    uint8_t digest[32];
+    mbedtls_sha256_ret(key, keyLength, digest, 0);
+    memcpy(key, digest, sizeof(digest));
+    keyLength = sizeof(digest);
+    flags |= QR_COMPACT_FLAG_KEY_HASHED;
+  }
+  bool multipairDevice = (getDeviceState() == DEVICE_MULTIPAIR);
+  if(multipairDevice)
+    flags |= QR_COMPACT_FLAG_MULTIPAIR;
+
+  String name = String(getDeviceName()).substring(0, 255);
+
+  //Tag, then flags, IDs, key and name length as one byte segment
+  std::vector <uint8_t> fields;
+  fields.reserve(1 + 16 + 16 + 2 + keyLength + 1);
+  fields.push_back(flags);
+  fields.insert(fields.end(), deviceUuid, deviceUuid + 16);
+  fields.insert(fields.end(), makerUuid, makerUuid + 16);
+  fields.push_back((keyLength >> 8) & 0xFF);
+  fields.push_back(keyLength & 0xFF);
+  fields.insert(fields.end(), key, key + keyLength);
+  fields.push_back(name.length());
+  segs.push_back(QrSegment::makeAlphanumeric(QR_COMPACT_PAYLOAD_TAG));
+  segs.push_back(QrSegment::makeBytes(fields));
+
+  //Text fields in numeric or alphanumeric mode when their characters allow it
+  std::vector <QrSegment> nameSegs = QrSegment::makeSegments(name.c_str());
+  segs.insert(segs.end(), nameSegs.begin(), nameSegs.end());
+  if(multipairDevice){
+    String aid = String(getAlternateDeviceID()).substring(0, 255);
+    segs.push_back(QrSegment::makeBytes(std::vector <uint8_t> (1, aid.length())));
+    std::vector <QrSegment> aidSegs = QrSegment::makeSegments(aid.c_str());
+    segs.insert(segs.end(), aidSegs.begin(), aidSegs.end());
+  }
+
+  debugD("\nKeyStore :: makeCompactDeviceInfo: Compact payload with %d segments, %d bytes of key",segs.size(),keyLength);
+  return true;
 }
 
-bool KeyStore :: saveQRCode(QrCode qr){
-  const int border = 4;
-  const int size = qr.getSize();
+bool KeyStore :: parseUuid(const char* uuid, uint8_t* bytes){
+  if(uuid == NULL || strlen(uuid) != 36)
+    return false;
 
+  int nibbles = 0;
+  for(int i = 0; i < 36; i++){
+    char c = uuid[i];
+    if(i == 8 || i == 13 || i == 18 || i == 23){
+      if(c != '-')
+        return false;
+      continue;
+    }
+    int value;
+    if(c >= '0' && c <= '9') value = c - '0';
+    else if(c >= 'a' && c <= 'f') value = c - 'a' + 10;
+    else if(c >= 'A' && c <= 'F') value = c - 'A' + 10;
+    else return false;
+    if(nibbles % 2 == 0)
+      bytes[nibbles / 2] = value << 4;
+    else
+      bytes[nibbles / 2] |= value;
+    nibbles++;
+  }
+  return true;
+}
+
+size_t KeyStore :: decodePublicKey(const char* key, uint8_t* der, const size_t derSize){
+  if(key == NULL)
+    return 0;
+
+  //Key is stored as the base64 body, with or without the PEM armour lines
+  const char* body = key;
+  const char* bodyEnd = key + strlen(key);
+  const char* armour = strstr(key, "-----BEGIN");
+  if(armour != NULL){
+    body = strchr(armour, '\n');
+    bodyEnd = (body != NULL) ? strstr(body, "-----END") : NULL;
+    if(body == NULL || bodyEnd == NULL)
+      return 0;
+    body++;
+  }
+
+  size_t derLength = 0;
+  int rc = mbedtls_base64_decode(der, derSize, &derLength, (const unsigned char*)body, bodyEnd - body);
+  if(rc != 0){
+    debugE("\nKeyStore :: decodePublicKey: Failed to mbedtls_base64_decode: -0x%x", -rc);
+    return 0;
+  }
+  return derLength;
+}
+
+bool KeyStore :: saveQRCode(const DeviceQRCode& qr, const String& etag){
   if(!SPIFFS.begin(true)){
     debugE("\nKeyStore :: saveQRCode: An Error has occurred while mounting SPIFFS");
     return false;
@@ -760,72 +1060,35 @@ bool KeyStore :: saveQRCode(QrCode qr){
     return false;
   }
 
-  //Prepare SVG Header
-  String svgHeader = String("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-         svgHeader += String("<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n");
-	       svgHeader += String("<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" viewBox=\"0 0 ");
-	       svgHeader += String((size + border * 2));
-         svgHeader += String(" ");
-         svgHeader += String((size + border * 2));
-         svgHeader += String("\" stroke=\"none\">\n");
-	       svgHeader += String("\t<rect width=\"100%\" height=\"100%\" fill=\"#FFFFFF\"/>\n");
-	       svgHeader += String("\t<path d=\"");
-
-  //Get SVG Header Byte values
-  const char* svgHeaderBytes = svgHeader.c_str();
-
-  //Write SVG Header into qrcode File
-  int bytesWritten = 0;
-  int i = 0;
-  while(svgHeaderBytes[i] != '\0'){
-    bytesWritten += file.write(svgHeaderBytes[i++]);
-  }
-  debugD("\nKeyStore :: saveQRCode: Amount of bytes written to file - %s for SVG Header: %d", QRCODE_FILE,bytesWritten);
-
-  //Write individual qrcode modules values to file
-  for (int y = 0; y < size; y++) {
-		for (int x = 0; x < size; x++) {
-			if (qr.getModule(x, y)) {
-				if (x != 0 || y != 0)
-					bytesWritten += file.write(' ');
-        //Prepare svgData value
-        String* svgData = new String("M");
-				        svgData->concat(x + border);
-                svgData->concat(",");
-                svgData->concat(y + border);
-                svgData->concat("h1v1h-1z");
-
-        //Get bytes from svgData
-        const char* svgDataBytes = svgData->c_str();
-        //Write svgData to qrcode file
-        i=0;
-        while(svgDataBytes[i]!='\0'){
-          bytesWritten += file.write(svgDataBytes[i++]);
-        }
-        //Release memory holding svgData
-        delete svgData;
-			}
-		}
-	}
+  //Runs of dark modules go out as single path segments through a block buffer
+  int bytesWritten = writeQRCodeSVG(qr, QRCODE_BORDER, file);
 
-  //Write SVG footer to qrcode file
-  String svgFooter = String("\" fill=\"#000000\"/>\n");
-	       svgFooter += String("</svg>\n");
+  //Close qrcode file
+  file.close();
 
-  //Get SVG Footer Byte values
-  const char* svgFooterBytes = svgFooter.c_str();
+  debugD("\nKeyStore :: saveQRCode: Total amount of bytes written to file - %s for QRCode: %d", QRCODE_FILE,bytesWritten);
+  if(bytesWritten <= 0)
+    return false;
 
-  //Write SVG Footer bytes to file
-  i = 0;
-  while(svgFooterBytes[i] != '\0'){
-    bytesWritten += file.write(svgFooterBytes[i++]);
+  //ETag of the identity saved, to know on next boot whether the file needs to be written again
+  file = SPIFFS.open(QRCODE_ETAG_FILE, FILE_WRITE);
+  if(!file){
+    debugE("\nKeyStore :: saveQRCode: There was an error opening the file - %s for saving ETag", QRCODE_ETAG_FILE);
+    return true;
   }
-
-  //Close qrcode file
+  file.print(etag);
   file.close();
+  return true;
+}
 
-  debugD("\nKeyStore :: saveQRCode: Total amount of bytes written to file - %s for QRCode: %d", QRCODE_FILE,bytesWritten);
-  return ((bytesWritten>0)?true:false);
+String KeyStore :: getSavedQRCodeETag(){
+  String etag;
+  File file = SPIFFS.open(QRCODE_ETAG_FILE, FILE_READ);
+  if(file){
+    etag = file.readString();
+    file.close();
+  }
+  return etag;
 }
 
 bool KeyStore :: isQRCodeGeneratedandSaved(){
@@ -843,6 +1106,7 @@ bool KeyStore :: resetQRCodeStatus(){
     debugE("\nKeyStore :: resetQRCodeStatus: An Error has occurred while mounting SPIFFS");
     return false;
   }
+  SPIFFS.remove(QRCODE_ETAG_FILE);
   if(SPIFFS.remove(QRCODE_FILE)){
     qrCodeStatus = false;
     return true;
@@ -957,6 +1221,9 @@ std::vector <struct OfflineActionMetadata> KeyStore :: retrieveOfflineActions(bo
         const char* alternateID = actionsArray[i]["alternateID"];
         const double value = (actionsArray[i]["value"]).as<double>();
         const unsigned long timestamp = (actionsArray[i]["timestamp"]).as<unsigned long>();
+        const byte priority = actionsArray[i]["priority"] | ACTION_PRIORITY_LOW;
+        const byte attempts = actionsArray[i]["attempts"] | 0;
+        const unsigned long nextAttemptTime = actionsArray[i]["next_attempt"] | 0;
         debugD("\nKeyStore :: retrieveOfflineActions: Action - %d Details: %d - %s - %s - %lu",i+1,offline,actionID,deviceID,timestamp);
 
         if(offline == 1){
@@ -973,6 +1240,9 @@ std::vector <struct OfflineActionMetadata> KeyStore :: retrieveOfflineActions(bo
           actionItem.multipair = multipair;
           actionItem.value = value;
           actionItem.timestamp = timestamp;
+          actionItem.priority = priority;
+          actionItem.attempts = attempts;
+          actionItem.nextAttemptTime = nextAttemptTime;
           if(alternateID != NULL){
             actionItem.alternateID = new char[strlen(alternateID)+1];
             strcpy(actionItem.alternateID,alternateID);
@@ -989,6 +1259,7 @@ std::vector <struct OfflineActionMetadata> KeyStore :: retrieveOfflineActions(bo
       }
 
       debugD("\nKeyStore :: retrieveOfflineActions: Number of Pending Payments retrieved into offlineActionsList: %d", offlineActionsList.size());
+      offlineActionsDepth = offlineActionsList.size();
       jb.clear();
       //Make a check to remove offline actions file or not
       if(removeOfflineActionsFile){
@@ -1041,6 +1312,9 @@ bool KeyStore :: saveOfflineActions(std::vector <struct OfflineActionMetadata> a
       obj["alternateID"] = i->alternateID;
       obj["value"] = i->value;
       obj["timestamp"] = i->timestamp;
+      obj["priority"] = i->priority;
+      obj["attempts"] = i->attempts;
+      obj["next_attempt"] = i->nextAttemptTime;
       actionsArray.add(obj);
       debugD("\nKeyStore :: saveOfflineActions: %d : %s : %s : %lu -- Added to offline actions array", i->offline, i->actionID, i->deviceID, i->timestamp);
     }
@@ -1052,6 +1326,7 @@ bool KeyStore :: saveOfflineActions(std::vector <struct OfflineActionMetadata> a
   debugD("\nKeyStore :: saveOfflineActions: Number of actions in actionsArray to be saved to file - %s : %d", OFFLINE_ACTIONS_FILE,actionsArray.size());
   int nBytes = actionsArray.measureLength();
   actionsArray.printTo(file);
+  offlineActionsDepth = actionsArray.size();
   debugD("\nKeyStore :: saveOfflineActions: Number of bytes written to file - %s: %d",OFFLINE_ACTIONS_FILE,nBytes);
 
   jb.clear();
@@ -1064,14 +1339,17 @@ bool KeyStore :: saveOfflineActions(std::vector <struct OfflineActionMetadata> a
   return true;
 }
 
-bool KeyStore :: saveOfflineAction(const char* actionID, const char* value,const unsigned long paymentTime){
+bool KeyStore :: saveOfflineAction(const char* actionID, const char* value,const unsigned long paymentTime,
+                                                                                  const byte priority, const char* qID,
+                                                                                  const char* aID){
    bool isActionSaved = false;
 
   //Fill in action metadata for payment
   const char* deviceID = getDeviceID();
   const char* makerID = getMakerID();
-  const char* queueID = generateUuid4();
-  const char* altID = getAlternateDeviceID();
+  //Reuse the queueID of an already attempted action, so that BoT Service can deduplicate the retry
+  const char* queueID = (qID != NULL)?qID:generateUuid4();
+  const char* altID = (aID != NULL)?aID:getAlternateDeviceID();
 
   struct OfflineActionMetadata pendingPayment;
   pendingPayment.offline = 1;
@@ -1101,6 +1379,9 @@ bool KeyStore :: saveOfflineAction(const char* actionID, const char* value,const
     pendingPayment.value = 0.0;
   }
   pendingPayment.timestamp = paymentTime;
+  pendingPayment.priority = priority;
+  pendingPayment.attempts = 0;
+  pendingPayment.nextAttemptTime = 0;
   debugD("\nKeyStore: saveOfflineAction: Payment details added to pendingPayment variable for paymentTime: %lu",pendingPayment.timestamp);
 
   //Retrieve existing offline actions from SPIFFS
@@ -1134,6 +1415,7 @@ bool KeyStore :: clearOfflineActions() {
 
   //Remove Offline Actions File from SPIFFS
   if(SPIFFS.begin(true) && SPIFFS.remove(OFFLINE_ACTIONS_FILE)){
+    offlineActionsDepth = 0;
     debugD("\nKeyStore :: clearOfflineActions: %s file removed successfully",OFFLINE_ACTIONS_FILE);
     return true;
   }
@@ -1142,3 +1424,306 @@ bool KeyStore :: clearOfflineActions() {
     return false;
   }
 }
+
+int KeyStore :: getOfflineActionsDepth(){
+  //Depth is cached on every read / write of offline actions file,
+  //the file is parsed only when nothing is known yet
+  if(offlineActionsDepth < 0){
+    if(offlineActionsExist())
+      retrieveOfflineActions();
+    else
+      offlineActionsDepth = 0;
+  }
+  return (offlineActionsDepth < 0)?0:offlineActionsDepth;
+}
+
+bool KeyStore :: saveDeadLetterAction(const struct OfflineActionMetadata* action, const char* reason){
+  if(action == NULL)
+    return false;
+
+  if(!SPIFFS.begin(true)){
+    debugE("\nKeyStore :: saveDeadLetterAction: An Error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  DynamicJsonBuffer jb;
+  JsonArray* deadArray = NULL;
+
+  //Read already dead lettered actions, if any
+  if(SPIFFS.exists(DEAD_LETTER_ACTIONS_FILE)){
+    File file = SPIFFS.open(DEAD_LETTER_ACTIONS_FILE, FILE_READ);
+    if(file){
+      JsonArray& savedArray = jb.parseArray(file);
+      file.close();
+      if(savedArray.success())
+        deadArray = &savedArray;
+      else
+        debugW("\nKeyStore :: saveDeadLetterAction: Error while parsing the file - %s, starting afresh", DEAD_LETTER_ACTIONS_FILE);
+    }
+  }
+  if(deadArray == NULL)
+    deadArray = &(jb.createArray());
+
+  //Keep the dead letter store bounded, oldest entries go first
+  while(deadArray->size() >= DEAD_LETTER_MAX_ACTIONS){
+    deadArray->remove(0);
+  }
+
+  JsonObject& obj = deadArray->createNestedObject();
+  obj["actionID"] = action->actionID;
+  obj["queueID"] = action->queueID;
+  obj["deviceID"] = action->deviceID;
+  obj["alternateID"] = action->alternateID;
+  obj["value"] = action->value;
+  obj["timestamp"] = action->timestamp;
+  obj["priority"] = action->priority;
+  obj["attempts"] = action->attempts;
+  obj["reason"] = reason;
+
+  File file = SPIFFS.open(DEAD_LETTER_ACTIONS_FILE, FILE_WRITE);
+  if(!file){
+    debugE("\nKeyStore :: saveDeadLetterAction: There was an error opening the file - %s for saving actions", DEAD_LETTER_ACTIONS_FILE);
+    jb.clear();
+    return false;
+  }
+  deadArray->printTo(file);
+  file.close();
+  debugW("\nKeyStore :: saveDeadLetterAction: Action - %s with queueID - %s moved to %s: %s", action->actionID, action->queueID, DEAD_LETTER_ACTIONS_FILE, reason);
+
+  jb.clear();
+  return true;
+}
+
+String KeyStore :: getDeadLetterActions(){
+  String actions;
+  if(!SPIFFS.begin(true)){
+    debugE("\nKeyStore :: getDeadLetterActions: An Error has occurred while mounting SPIFFS");
+    return actions;
+  }
+
+  if(SPIFFS.exists(DEAD_LETTER_ACTIONS_FILE)){
+    File file = SPIFFS.open(DEAD_LETTER_ACTIONS_FILE, FILE_READ);
+    if(!file){
+      debugE("\nKeyStore :: getDeadLetterActions: There was an error opening the file - %s for reading actions", DEAD_LETTER_ACTIONS_FILE);
+      return actions;
+    }
+    size_t size = file.size();
+    char* buffer = new char[size+1];
+    file.readBytes(buffer,size);
+    buffer[size] = '\0';
+    file.close();
+    actions = buffer;
+    delete[] buffer;
+  }
+  else {
+    actions = "[]";
+  }
+  debugD("\nKeyStore :: getDeadLetterActions: %s", actions.c_str());
+  return actions;
+}
+
+bool KeyStore :: clearDeadLetterActions(){
+  if(!SPIFFS.begin(true)){
+    debugE("\nKeyStore :: clearDeadLetterActions: An Error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  if(!SPIFFS.exists(DEAD_LETTER_ACTIONS_FILE))
+    return true;
+
+  if(SPIFFS.remove(DEAD_LETTER_ACTIONS_FILE)){
+    debugD("\nKeyStore :: clearDeadLetterActions: %s file removed successfully",DEAD_LETTER_ACTIONS_FILE);
+    return true;
+  }
+  else {
+    debugE("\nKeyStore :: clearDeadLetterActions: Error during removing %s file",DEAD_LETTER_ACTIONS_FILE);
+    return false;
+  }
+}
+
+bool KeyStore :: saveBootRecord(const char* record){
+  if(record == NULL)
+    return false;
+
+  if(!SPIFFS.begin(true)){
+    debugE("\nKeyStore :: saveBootRecord: An Error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  DynamicJsonBuffer jb;
+  JsonArray* bootArray = NULL;
+
+  //Read records of previous boots, if any
+  if(SPIFFS.exists(BOOT_RECORDS_FILE)){
+    File file = SPIFFS.open(BOOT_RECORDS_FILE, FILE_READ);
+    if(file){
+      JsonArray& savedArray = jb.parseArray(file);
+      file.close();
+      if(savedArray.success())
+        bootArray = &savedArray;
+      else
+        debugW("\nKeyStore :: saveBootRecord: Error while parsing the file - %s, starting afresh", BOOT_RECORDS_FILE);
+    }
+  }
+  if(bootArray == NULL)
+    bootArray = &(jb.createArray());
+
+  JsonObject& obj = jb.parseObject(record);
+  if(!obj.success()){
+    debugE("\nKeyStore :: saveBootRecord: Invalid boot record: %s", record);
+    jb.clear();
+    return false;
+  }
+
+  //Boots are numbered on from the latest record kept
+  unsigned long bootNumber = 1;
+  if(bootArray->size() > 0){
+    JsonObject& lastRecord = (*bootArray)[bootArray->size()-1];
+    bootNumber = lastRecord["boot"].as<unsigned long>() + 1;
+  }
+  obj["boot"] = bootNumber;
+
+  //Only last few boots are kept, oldest records go first
+  while(bootArray->size() >= BOOT_RECORDS_MAX){
+    bootArray->remove(0);
+  }
+  bootArray->add(obj);
+
+  File file = SPIFFS.open(BOOT_RECORDS_FILE, FILE_WRITE);
+  if(!file){
+    debugE("\nKeyStore :: saveBootRecord: There was an error opening the file - %s for saving boot record", BOOT_RECORDS_FILE);
+    jb.clear();
+    return false;
+  }
+  bootArray->printTo(file);
+  file.close();
+  debugD("\nKeyStore :: saveBootRecord: Boot record %lu saved to %s", bootNumber, BOOT_RECORDS_FILE);
+
+  jb.clear();
+  return true;
+}
+
+String KeyStore :: getBootRecords(){
+  //Returned by value, the /boot handler and the SDK wrapper call this from different tasks
+  String records;
+  if(!SPIFFS.begin(true)){
+    debugE("\nKeyStore :: getBootRecords: An Error has occurred while mounting SPIFFS");
+    return records;
+  }
+
+  if(SPIFFS.exists(BOOT_RECORDS_FILE)){
+    File file = SPIFFS.open(BOOT_RECORDS_FILE, FILE_READ);
+    if(!file){
+      debugE("\nKeyStore :: getBootRecords: There was an error opening the file - %s for reading boot records", BOOT_RECORDS_FILE);
+      return records;
+    }
+    size_t size = file.size();
+    char* buffer = new char[size+1];
+    file.readBytes(buffer,size);
+    buffer[size] = '\0';
+    file.close();
+    records = buffer;
+    delete[] buffer;
+  }
+  else {
+    records = "[]";
+  }
+  debugD("\nKeyStore :: getBootRecords: %s", records.c_str());
+  return records;
+}
+
+bool KeyStore :: loadWiFiCache(struct WiFiCache* cache){
+  if(cache == NULL)
+    return false;
+
+  if(!SPIFFS.begin(true)){
+    LOG("\nKeyStore :: loadWiFiCache: An Error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  if(!SPIFFS.exists(WIFI_CACHE_FILE))
+    return false;
+
+  File file = SPIFFS.open(WIFI_CACHE_FILE, FILE_READ);
+  if(!file){
+    LOG("\nKeyStore :: loadWiFiCache: There was an error opening the file - %s", WIFI_CACHE_FILE);
+    return false;
+  }
+
+  DynamicJsonBuffer jb;
+  JsonObject& json = jb.parseObject(file);
+  file.close();
+  if(!json.success()){
+    LOG("\nKeyStore :: loadWiFiCache: Error while parsing the file - %s", WIFI_CACHE_FILE);
+    jb.clear();
+    return false;
+  }
+
+  const char* ssid = json["ssid"] | "";
+  const char* bssid = json["bssid"] | "";
+  unsigned int mac[6];
+  bool valid = (strlen(ssid) > 0 && strlen(ssid) < sizeof(cache->ssid) &&
+                sscanf(bssid, "%x:%x:%x:%x:%x:%x", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]) == 6 &&
+                cache->ip.fromString(json["ip"] | "") && cache->gateway.fromString(json["gateway"] | "") &&
+                cache->subnet.fromString(json["subnet"] | "") && cache->dns.fromString(json["dns"] | ""));
+  if(valid){
+    strcpy(cache->ssid, ssid);
+    for(int i=0; i < 6; i++)
+      cache->bssid[i] = (uint8_t)mac[i];
+    cache->channel = json["channel"] | 0;
+  }
+  else
+    LOG("\nKeyStore :: loadWiFiCache: Invalid contents in %s, ignoring", WIFI_CACHE_FILE);
+
+  jb.clear();
+  return valid;
+}
+
+bool KeyStore :: saveWiFiCache(const struct WiFiCache* cache){
+  if(cache == NULL)
+    return false;
+
+  if(!SPIFFS.begin(true)){
+    LOG("\nKeyStore :: saveWiFiCache: An Error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  char bssid[18];
+  sprintf(bssid, "%02X:%02X:%02X:%02X:%02X:%02X", cache->bssid[0], cache->bssid[1],
+                  cache->bssid[2], cache->bssid[3], cache->bssid[4], cache->bssid[5]);
+
+  DynamicJsonBuffer jb;
+  JsonObject& json = jb.createObject();
+  json["ssid"] = cache->ssid;
+  json["bssid"] = bssid;
+  json["channel"] = cache->channel;
+  json["ip"] = cache->ip.toString();
+  json["gateway"] = cache->gateway.toString();
+  json["subnet"] = cache->subnet.toString();
+  json["dns"] = cache->dns.toString();
+
+  File file = SPIFFS.open(WIFI_CACHE_FILE, FILE_WRITE);
+  if(!file){
+    LOG("\nKeyStore :: saveWiFiCache: There was an error opening the file - %s for saving", WIFI_CACHE_FILE);
+    jb.clear();
+    return false;
+  }
+  json.printTo(file);
+  file.close();
+  LOG("\nKeyStore :: saveWiFiCache: Cached BSSID %s on channel %d with IP %s", bssid, cache->channel, cache->ip.toString().c_str());
+
+  jb.clear();
+  return true;
+}
+
+bool KeyStore :: clearWiFiCache(){
+  if(!SPIFFS.begin(true)){
+    LOG("\nKeyStore :: clearWiFiCache: An Error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  if(!SPIFFS.exists(WIFI_CACHE_FILE))
+    return true;
+
+  return SPIFFS.remove(WIFI_CACHE_FILE);
+}
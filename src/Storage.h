@@ -6,7 +6,12 @@
 #ifndef Storage_h
 #define Storage_h
 #include "BoTESP32SDK.h"
-#include "QrCode.hpp"
+#include "EventService.h"
+#include "PollingPolicy.h"
+#include "QrCodeStatic.hpp"
+#include "SvgWriter.h"
+#include "GzipWriter.h"
+#include <freertos/semphr.h>
 #define JSON_CONFIG_FILE "/configuration.json"
 #define PRIVATE_KEY_FILE "/private.key"
 #define PUBLIC_KEY_FILE "/public.key"
@@ -14,10 +19,31 @@
 #define CA_CERT_FILE "/cacert.cer"
 #define ACTIONS_FILE "/actions.json"
 #define QRCODE_FILE "/qrcode.svg"
+#define DEVICE_INFO_MAX_LENGTH 1024
+#define DEVICE_INFO_FIELDS 6
+#define QRCODE_MAX_VERSION 23
+#define QRCODE_BORDER 4
+#define QRCODE_ETAG_LENGTH 16
+#define QRCODE_ETAG_FILE "/qrcode.etag"
+#define QRCODE_BUILDER_STACK_SIZE 8192
+#define QRCODE_BUILDER_PRIORITY 1
+#define QR_PAYLOAD_JSON 0
+#define QR_PAYLOAD_COMPACT 1
+#define QR_PAYLOAD_COMPACT_HASH 2
+#define QR_COMPACT_PAYLOAD_TAG "BOT1"
+#define QR_COMPACT_FLAG_MULTIPAIR 0x01
+#define QR_COMPACT_FLAG_KEY_HASHED 0x02
+#define QR_COMPACT_KEY_MAX_LENGTH 600
 #define OFFLINE_ACTIONS_FILE "/offline.json"
+#define DEAD_LETTER_ACTIONS_FILE "/deadletter.json"
+#define DEAD_LETTER_MAX_ACTIONS 50
+#define BOOT_RECORDS_FILE "/boot.json"
+#define BOOT_RECORDS_MAX 8
+#define WIFI_CACHE_FILE "/wificache.json"
 #define NOT_LOADED 0
 #define LOADED 1
 #define DEVICE_STATE_ADDR 0
+typedef qrcodegen::QrCodeStatic<QRCODE_MAX_VERSION> DeviceQRCode;
 class KeyStore {
   public:
     static KeyStore* getKeyStoreInstance();
@@ -52,13 +78,31 @@ class KeyStore {
     const char* getDeviceStatusMsg();
     std::vector <struct Action> retrieveActions();
     bool saveActions(std::vector <struct Action> aList);
-    String *getDeviceInfo();
+    String getDeviceInfo();
+    size_t getDeviceInfo(char* buffer, const size_t size);
     bool generateAndSaveQRCode();
     bool resetQRCodeStatus();
+    String getQRCodeETag();
+    size_t writeQRCodeAsset(Print& out, const String& etag);
     std::vector <struct OfflineActionMetadata> retrieveOfflineActions(bool removeFile = false);
     bool saveOfflineActions(std::vector <struct OfflineActionMetadata> aList);
-    bool saveOfflineAction(const char* actionID, const char* value, const unsigned long paymentTime);
+    bool saveOfflineAction(const char* actionID, const char* value, const unsigned long paymentTime,
+                                                  const byte priority = ACTION_PRIORITY_LOW, const char* qID = NULL,
+                                                  const char* aID = NULL);
+    byte getActionPriority(const char* actionID);
     bool clearOfflineActions();
+    int getOfflineActionsDepth();
+    unsigned long getPollingInitialInterval();
+    unsigned long getPollingMaximumInterval();
+    byte getQRPayloadFormat();
+    bool saveDeadLetterAction(const struct OfflineActionMetadata* action, const char* reason);
+    String getDeadLetterActions();
+    bool clearDeadLetterActions();
+    bool saveBootRecord(const char* record);
+    String getBootRecords();
+    bool loadWiFiCache(struct WiFiCache* cache);
+    bool saveWiFiCache(const struct WiFiCache* cache);
+    bool clearWiFiCache();
     bool updateWiFiConfiguration(const char* ssid, const char* passwd);
     bool resetBoard();
   private:
@@ -70,7 +114,6 @@ class KeyStore {
     String *makerID;
     String *deviceID;
     String *deviceName;
-    String *deviceInfo;
     String *deviceStatus;
     String *altDeviceID;
     String *privateKey;
@@ -79,6 +122,10 @@ class KeyStore {
     String *caCert;
     String *qrCACert;
     String *uuidStr;
+    int offlineActionsDepth;
+    unsigned long pollingInitialInterval;
+    unsigned long pollingMaximumInterval;
+    byte qrPayloadFormat;
     byte jsonCfgLoadStatus;
     byte privateKeyLoadStatus;
     byte publicKeyLoadStatus;
@@ -90,7 +137,20 @@ class KeyStore {
     KeyStore();
     std::vector <struct Action> actionsList;
     std::vector <struct OfflineActionMetadata> offlineActionsList;
-    bool saveQRCode(qrcodegen::QrCode qr);
+    std::vector <String> highPriorityActions;
+    static DeviceQRCode qrCode;
+    struct QRCodeAsset qrCodeAsset;
+    SemaphoreHandle_t qrCodeMutex;
+    bool qrCodeBuilderRunning;
+    bool buildQRCodeAsset();
+    static void qrCodeBuilder(void* param);
+    bool encodeQRCode();
+    bool saveQRCode(const DeviceQRCode& qr, const String& etag);
+    String getSavedQRCodeETag();
+    String makeQRCodeETag();
+    bool makeCompactDeviceInfo(std::vector <qrcodegen::QrSegment>& segs);
+    static bool parseUuid(const char* uuid, uint8_t* bytes);
+    static size_t decodePublicKey(const char* key, uint8_t* der, const size_t derSize);
     void clearActionsList();
     void clearOfflineActionsList();
     char* configRead();
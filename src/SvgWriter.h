@@ -0,0 +1,123 @@
+/*
+  SvgWriter.h - Buffered writer to save QR Code as SVG, merging horizontal runs of
+                dark modules into single path segments and writing in blocks
+  Released into the repository BoT-ESP32-SDK.
+*/
+
+#ifndef SvgWriter_h
+#define SvgWriter_h
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SVG_WRITER_BUFFER_SIZE 512
+#define SVG_WRITER_NUMBER_LENGTH 12
+
+//Output is anything with write(const uint8_t*, size_t), such as Arduino File / Print
+template <class Output>
+class SvgWriter {
+  public:
+    SvgWriter(Output& output) : out(output), used(0), written(0) {}
+    ~SvgWriter() { flush(); }
+
+    void write(const char* text){
+      write(text, strlen(text));
+    }
+
+    void write(const char* text, size_t length){
+      while(length > 0){
+        if(used == SVG_WRITER_BUFFER_SIZE)
+          flush();
+        size_t chunk = SVG_WRITER_BUFFER_SIZE - used;
+        if(chunk > length)
+          chunk = length;
+        memcpy(buffer + used, text, chunk);
+        used += chunk;
+        text += chunk;
+        length -= chunk;
+      }
+    }
+
+    void write(const int number){
+      //Digits are filled from the end, no printf formatting per coordinate
+      char digits[SVG_WRITER_NUMBER_LENGTH];
+      char* start = digits + sizeof(digits);
+      unsigned int value = (number < 0)?(0u - (unsigned int)number):(unsigned int)number;
+      do {
+        *--start = (char)('0' + value % 10);
+        value /= 10;
+      } while(value > 0);
+      if(number < 0)
+        *--start = '-';
+      write(start, (digits + sizeof(digits)) - start);
+    }
+
+    void flush(){
+      if(used > 0){
+        written += out.write((const uint8_t*)buffer, used);
+        used = 0;
+      }
+    }
+
+    //Bytes handed over to output so far
+    size_t getBytesWritten(){
+      return written;
+    }
+
+  private:
+    Output& out;
+    char buffer[SVG_WRITER_BUFFER_SIZE];
+    size_t used;
+    size_t written;
+};
+
+//Writes given QR Code as SVG to output, one path segment per horizontal run of dark modules
+template <class Symbol, class Output>
+size_t writeQRCodeSVG(const Symbol& qr, const int border, Output& output){
+  const int size = qr.getSize();
+  SvgWriter<Output> svg(output);
+
+  svg.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  svg.write("<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n");
+  svg.write("<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" viewBox=\"0 0 ");
+  svg.write(size + border * 2);
+  svg.write(" ");
+  svg.write(size + border * 2);
+  svg.write("\" stroke=\"none\">\n");
+  svg.write("\t<rect width=\"100%\" height=\"100%\" fill=\"#FFFFFF\"/>\n");
+  svg.write("\t<path d=\"");
+
+  bool first = true;
+  for(int y = 0; y < size; y++){
+    int x = 0;
+    while(x < size){
+      if(!qr.getModule(x, y)){
+        x++;
+        continue;
+      }
+      int run = 1;
+      while(x + run < size && qr.getModule(x + run, y))
+        run++;
+
+      if(!first)
+        svg.write(" ");
+      first = false;
+      svg.write("M");
+      svg.write(x + border);
+      svg.write(",");
+      svg.write(y + border);
+      svg.write("h");
+      svg.write(run);
+      svg.write("v1h-");
+      svg.write(run);
+      svg.write("z");
+      x += run;
+    }
+  }
+
+  svg.write("\" fill=\"#000000\"/>\n");
+  svg.write("</svg>\n");
+  svg.flush();
+  return svg.getBytesWritten();
+}
+#endif
@@ -33,6 +33,12 @@ Webserver :: Webserver(bool loadConfig, const char *ssid, const char *passwd, co
   ble = NULL;
   debugLevel = logLevel;
   serverStatus = NOT_STARTED;
+  provisioningState = PROVISIONING_IDLE;
+  provisioningStartTime = 0;
+  stateEnteredTime = 0;
+  provisioningAttempts = 0;
+  provisioningTask = NULL;
+  provisioningPolicy = NULL;
   pinMode(ledPin, OUTPUT);
   digitalWrite(ledPin, LOW);
   Serial.begin(115200);
@@ -45,23 +51,65 @@ Webserver :: Webserver(bool loadConfig, const char *ssid, const char *passwd, co
 }
 
 void Webserver :: connectWiFi(){
+  BootOrchestrator* boot = BootOrchestrator :: getBootOrchestratorInstance();
+  boot->begin();
+  boot->beginPhase(BOOT_PHASE_FS_MOUNT);
+  boot->endPhase(BOOT_PHASE_FS_MOUNT, SPIFFS.begin(true));
+  boot->beginPhase(BOOT_PHASE_CONFIG);
+  store->loadJSONConfiguration();
+  store->initializeEEPROM();
   if(WiFi_SSID == NULL || WiFi_Passwd == NULL){
-    store->loadJSONConfiguration();
-    store->initializeEEPROM();
     WiFi_SSID = new String(store->getWiFiSSID());
     WiFi_Passwd = new String(store->getWiFiPasswd());
   }
+  boot->endPhase(BOOT_PHASE_CONFIG, store->isJSONConfigLoaded());
 
   LOG("\nWebserver :: connectWiFi: Connecting to WiFi SSID: %s", WiFi_SSID->c_str());
   if(!isWiFiConnected()){
+    boot->setWiFiConnected(false);
+    boot->beginPhase(BOOT_PHASE_WIFI);
     WiFi.mode(WIFI_STA);
-    WiFi.begin(WiFi_SSID->c_str(), WiFi_Passwd->c_str());
 
+    //Access point and channel from last good connection skip the scan, address still comes from DHCP
+    struct WiFiCache cache;
+    bool cached = store->loadWiFiCache(&cache) && WiFi_SSID->equals(cache.ssid);
+    associateWiFi(cached?&cache:NULL);
+
+    //Keys, signing key and QR Code get ready on the other core while associating
+    boot->startPreparation();
+
+    //Failed connects are retried with backoff for as long as it takes, the board is not rebooted
+    PollingPolicy retryPolicy(WIFI_RETRY_INITIAL_INTERVAL_IN_MILLISECONDS, WIFI_RETRY_MAXIMUM_INTERVAL_IN_MILLISECONDS);
+    int attempts = 1;
     while (WiFi.waitForConnectResult() != WL_CONNECTED) {
-        LOG("\nWebserver :: connectWiFi: Trying to Connect to WiFi SSID: %s failed, rebooting the board", WiFi_SSID->c_str());
-        delay(5000);
-        ESP.restart();
+        if(cached){
+          //Access point moved or changed channel, fall back to scan
+          LOG("\nWebserver :: connectWiFi: Connecting with cached BSSID failed, scanning for SSID: %s", WiFi_SSID->c_str());
+          store->clearWiFiCache();
+          cached = false;
+          associateWiFi(NULL);
+          continue;
+        }
+        unsigned long interval = retryPolicy.nextInterval();
+        LOG("\nWebserver :: connectWiFi: Trying to Connect to WiFi SSID: %s failed %d times, retrying in %lu ms", WiFi_SSID->c_str(), attempts, interval);
+        delay(interval);
+        attempts++;
+        associateWiFi(NULL);
     }
+    updateWiFiCache(cached?&cache:NULL);
+    //Normally closed from WiFi events, association and DHCP apart
+    if(boot->isPhaseRunning(BOOT_PHASE_WIFI))
+      boot->endPhase(BOOT_PHASE_WIFI);
+    if(boot->isPhaseRunning(BOOT_PHASE_DHCP))
+      boot->endPhase(BOOT_PHASE_DHCP);
+  }
+  else
+    boot->startPreparation();
+  boot->setWiFiConnected(true);
+  //Keys, signing key and QR Code are needed by everything after this point, preparation may still be
+  //running on the other core with slow SPIFFS, so keep waiting instead of going on without them
+  while(!boot->waitUntilReady()){
+    LOG("\nWebserver :: connectWiFi: Still waiting for keys and QR Code to get ready");
   }
     LOG("\nWebserver :: connectWiFi: Board Connected to WiFi SSID: %s, assigned IP: %s", WiFi_SSID->c_str(), (getBoardIP().toString()).c_str());
     blinkLED();
@@ -83,6 +131,36 @@ void Webserver :: connectWiFi(){
     #endif
  }
 
+void Webserver :: associateWiFi(const struct WiFiCache* cache){
+  WiFi.disconnect();
+  //Zero addresses keep DHCP on, a cached address may have been leased to another host since
+  WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+  if(cache != NULL){
+    LOG("\nWebserver :: associateWiFi: Connecting directly on channel %d, last IP %s", cache->channel, cache->ip.toString().c_str());
+    WiFi.begin(WiFi_SSID->c_str(), WiFi_Passwd->c_str(), cache->channel, cache->bssid);
+    return;
+  }
+  WiFi.begin(WiFi_SSID->c_str(), WiFi_Passwd->c_str());
+}
+
+void Webserver :: updateWiFiCache(const struct WiFiCache* cache){
+  struct WiFiCache current;
+  strncpy(current.ssid, WiFi_SSID->c_str(), sizeof(current.ssid) - 1);
+  current.ssid[sizeof(current.ssid) - 1] = '\0';
+  memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+  current.channel = WiFi.channel();
+  current.ip = WiFi.localIP();
+  current.gateway = WiFi.gatewayIP();
+  current.subnet = WiFi.subnetMask();
+  current.dns = WiFi.dnsIP();
+
+  //Flash is written only when the access point changed, a new DHCP lease alone does not matter
+  if(cache != NULL && memcmp(cache->bssid, current.bssid, sizeof(current.bssid)) == 0 &&
+     cache->channel == current.channel)
+    return;
+  store->saveWiFiCache(&current);
+}
+
 IPAddress Webserver :: getBoardIP(){
   if(isWiFiConnected() == true){
     return WiFi.localIP();
@@ -104,18 +182,231 @@ bool Webserver :: isWiFiConnected(){
 bool Webserver :: isDevicePaired(){
   //Check pairing status for the device
   PairingService* ps = new PairingService();
-  String* psResponse = ps->getPairingStatus();
+  String psResponse = ps->getPairingStatus();
   delete ps;
 
-  if((psResponse->indexOf("true")) != -1)
+  if((psResponse.indexOf("true")) != -1)
     return true;
   else
     return false;
 }
 
+void Webserver :: setProvisioningState(const byte state){
+  if(state != provisioningState){
+    provisioningState = state;
+    stateEnteredTime = millis();
+    provisioningAttempts = 0;
+    if(provisioningPolicy != NULL)
+      provisioningPolicy->reset();
+    debugI("\nWebserver :: setProvisioningState: Provisioning state -> %s", getProvisioningStatusMsg());
+    //Boot is over once the device is either provisioned or waiting on the user
+    if(state == PROVISIONING_BLE_WAIT || state == PROVISIONING_DONE || state == PROVISIONING_FAILED)
+      BootOrchestrator :: getBootOrchestratorInstance()->recordBoot();
+    EventService :: getEventServiceInstance()->publish("provisioning", "{\"state\":\"%s\"}", getProvisioningStatusMsg());
+  }
+}
+
+byte Webserver :: getProvisioningState(){
+  return provisioningState;
+}
+
+const char* Webserver :: getProvisioningStatusMsg(){
+  switch(provisioningState){
+    case PROVISIONING_IDLE: return "IDLE";
+    case PROVISIONING_CHECK_PAIRED: return "CHECKING_PAIRING";
+    case PROVISIONING_BLE_WAIT: return "WAITING_FOR_BLE_CLIENT";
+    case PROVISIONING_BLE_CONNECTED: return "BLE_CLIENT_CONNECTED";
+    case PROVISIONING_QR_WAIT: return "WAITING_FOR_QR_PAIRING";
+    case PROVISIONING_ACTIVATING: return "ACTIVATING";
+    case PROVISIONING_DONE: return "DONE";
+    case PROVISIONING_FAILED: return "FAILED";
+    case PROVISIONING_VERIFYING: return "VERIFYING_PAIRING";
+    default: return "INVALID";
+  }
+}
+
+unsigned long Webserver :: getProvisioningElapsedTime(){
+  return (provisioningState == PROVISIONING_IDLE)?0:(millis() - provisioningStartTime);
+}
+
+int Webserver :: getProvisioningAttempts(){
+  return provisioningAttempts;
+}
+
+byte Webserver :: getConfigureState(){
+  //Same decisions as ConfigurationService::configureDevice, without waiting in between
+  switch(store->getDeviceState()){
+    case DEVICE_NEW: return PROVISIONING_QR_WAIT;
+    case DEVICE_PAIRED: return PROVISIONING_ACTIVATING;
+    default: return PROVISIONING_DONE;
+  }
+}
+
+void Webserver :: completeBLEPairing(){
+  //Release memory used by BLE Service once BLE Client is done or never showed up
+  ble->deInitializeBLE();
+  debugD("\nWebserver :: completeBLEPairing: Free Heap after BLE deInit: %u", ESP.getFreeHeap());
+
+  //If device does not get paired through BLE,
+  //wait now till it gets paired through QR Code if QR Code is available
+  if(store->isQRCodeGeneratedandSaved()){
+    setProvisioningState(PROVISIONING_QR_WAIT);
+  }
+  else {
+    debugW("\nWebserver :: completeBLEPairing: QR Code not available for the device, try again!!!");
+    setProvisioningState(PROVISIONING_FAILED);
+  }
+}
+
+unsigned long Webserver :: advanceProvisioning(){
+  provisioningAttempts++;
+  switch(provisioningState){
+    case PROVISIONING_CHECK_PAIRED: {
+      //Device activated earlier serves actions right away, pairing is confirmed afterwards
+      PairingService* pairService = new PairingService();
+      bool persistedStateValid = pairService->isPersistedStateValid();
+      delete pairService;
+      BootOrchestrator* boot = BootOrchestrator :: getBootOrchestratorInstance();
+      boot->beginPhase(BOOT_PHASE_PAIRING_CHECK);
+      if(persistedStateValid){
+        debugI("\nWebserver :: advanceProvisioning: Device State -> %s, verifying pairing in background", store->getDeviceStatusMsg());
+        setProvisioningState(PROVISIONING_VERIFYING);
+        break;
+      }
+      //Device is already paired, then device initialization is skipped
+      //Otherwise waits till device gets paired using FINN APP either by
+      //BLE client connects and key exchanges happen or by QR Code
+      bool paired = isDevicePaired();
+      boot->endPhase(BOOT_PHASE_PAIRING_CHECK);
+      if(paired){
+        debugI("\nWebserver :: advanceProvisioning: Device is already paired, checking device's state is valid or not");
+        //Below situation occurs when the same device is switched between Multipair and Singlepair
+        //Reset Device State and Initialize
+        if((!store->isDeviceMultipair() && store->getDeviceState() == DEVICE_MULTIPAIR) ||
+           (store->isDeviceMultipair() && store->getDeviceState() != DEVICE_MULTIPAIR))
+        {
+          debugI("\nWebserver :: advanceProvisioning: Invalid device state, initializing as new device");
+          store->resetDeviceState();
+          store->resetQRCodeStatus();
+          BoTService :: getBoTServiceInstance()->resetSigningKey();
+          config->initialize();
+          setProvisioningState(getConfigureState());
+        }
+        else {
+          debugI("\nWebserver :: advanceProvisioning: Valid device state, no need to initialize and configure");
+          setProvisioningState(PROVISIONING_DONE);
+        }
+      }
+      else {
+        debugI("\nWebserver :: advanceProvisioning: Device is not paired yet, needs initialization");
+        config->initialize();
+        debugD("\nWebserver :: advanceProvisioning: Free Heap before BLE Init: %u", ESP.getFreeHeap());
+        boot->beginPhase(BOOT_PHASE_BLE_INIT);
+        ble->initializeBLE();
+        boot->endPhase(BOOT_PHASE_BLE_INIT);
+        setProvisioningState(PROVISIONING_BLE_WAIT);
+      }
+      break;
+    }
+
+    case PROVISIONING_VERIFYING: {
+      PairingService* pairService = new PairingService();
+      byte status = pairService->verifyPairingStatus();
+      delete pairService;
+      BootOrchestrator* boot = BootOrchestrator :: getBootOrchestratorInstance();
+      if(boot->isPhaseRunning(BOOT_PHASE_PAIRING_CHECK) &&
+         (status != PAIRING_STATUS_UNKNOWN || provisioningAttempts >= PAIRING_VERIFY_MAX_ATTEMPTS))
+        boot->endPhase(BOOT_PHASE_PAIRING_CHECK, status != PAIRING_STATUS_UNKNOWN);
+      if(status == PAIRING_STATUS_PAIRED){
+        debugI("\nWebserver :: advanceProvisioning: Persisted device state confirmed by BoT Service");
+        setProvisioningState(PROVISIONING_DONE);
+      }
+      else if(status == PAIRING_STATUS_NOT_PAIRED){
+        //BoT Service disagrees with EEPROM, start over as a new device
+        debugW("\nWebserver :: advanceProvisioning: BoT Service reports device not paired, initializing as new device");
+        store->resetDeviceState();
+        store->resetQRCodeStatus();
+        BoTService :: getBoTServiceInstance()->resetSigningKey();
+        config->initialize();
+        ble->initializeBLE();
+        setProvisioningState(PROVISIONING_BLE_WAIT);
+      }
+      else if(provisioningAttempts >= PAIRING_VERIFY_MAX_ATTEMPTS){
+        debugW("\nWebserver :: advanceProvisioning: Unable to verify pairing status, keeping persisted device state");
+        setProvisioningState(PROVISIONING_DONE);
+      }
+      else
+        return provisioningPolicy->nextInterval();
+      break;
+    }
+
+    case PROVISIONING_BLE_WAIT:
+      //Wait till device gets paired from FINN APP for 2 mins through BLE
+      if(ble->isBLEClientConnected()){
+        debugI("\nWebserver :: advanceProvisioning: BLE Client connected to BLE Server...");
+        setProvisioningState(PROVISIONING_BLE_CONNECTED);
+      }
+      else if((millis() - stateEnteredTime) >= PROVISIONING_BLE_WAIT_IN_MILLISECONDS){
+        completeBLEPairing();
+      }
+      else
+        debugI("\nWebserver :: advanceProvisioning: Waiting for BLE Client to connect...");
+      break;
+
+    case PROVISIONING_BLE_CONNECTED:
+      //Wait till BLE Client disconnects from BLE Server
+      if(!ble->isBLEClientConnected())
+        completeBLEPairing();
+      else
+        debugI("\nWebserver :: advanceProvisioning: Waiting for BLE Client to disconnect from BLE Server");
+      break;
+
+    case PROVISIONING_QR_WAIT: {
+      debugI("\nWebserver :: advanceProvisioning: Waiting for device pairing through QR Code...");
+      PairingService* pairService = new PairingService();
+      bool paired = pairService->checkPairingStatus();
+      delete pairService;
+      if(!paired)
+        return provisioningPolicy->nextInterval();
+      setProvisioningState(getConfigureState());
+      break;
+    }
+
+    case PROVISIONING_ACTIVATING: {
+      ActivationService* activateService = new ActivationService();
+      if(activateService->checkActivationStatus())
+        setProvisioningState(PROVISIONING_DONE);
+      else
+        debugW("\nWebserver :: advanceProvisioning: Unable to activate device yet, trying again");
+      delete activateService;
+      if(provisioningState == PROVISIONING_ACTIVATING)
+        return provisioningPolicy->nextInterval();
+      break;
+    }
+  }
+  return PROVISIONING_TICK_IN_MILLISECONDS;
+}
+
+void Webserver :: provisioningWorker(void* param){
+  Webserver* webServer = (Webserver*)param;
+  while(webServer->provisioningState != PROVISIONING_DONE &&
+        webServer->provisioningState != PROVISIONING_FAILED){
+    unsigned long tick = webServer->advanceProvisioning();
+    //Next step once the tick elapses or earlier when device or BLE state changes
+    webServer->provisioningPolicy->waitFor(tick);
+  }
+  debugI("\nWebserver :: provisioningWorker: Provisioning finished with state %s", webServer->getProvisioningStatusMsg());
+  delete webServer->provisioningPolicy;
+  webServer->provisioningPolicy = NULL;
+  webServer->provisioningTask = NULL;
+  vTaskDelete(NULL);
+}
+
 void Webserver :: startServer(){
    if(isWiFiConnected() == true){
      debugD("\nWebserver :: startServer: Starting the Async Webserver...");
+     BootOrchestrator* boot = BootOrchestrator :: getBootOrchestratorInstance();
+     boot->beginPhase(BOOT_PHASE_SERVER_START);
 
      server = new AsyncWebServer(port);
 
@@ -130,9 +421,16 @@ void Webserver :: startServer(){
         JsonObject& root = response->getRoot();
         root["actionsEndPoint"] = "/actions";
         root["pairingEndPoint"] = "/pairing";
+        root["pairingStatusEndPoint"] = "/pairing/status";
         root["activateEndPoint"] = "/activate";
         root["qrCodeEndPoint"] = "/qrcode";
         root["actionEndPoint"] = "/action?actionID=`actionID-value`";
+        root["actionsBatchEndPoint"] = "/actions/batch";
+        root["actionStatusEndPoint"] = "/action/status?id=`jobID-value`";
+        root["deadLettersEndPoint"] = "/deadletters";
+        root["metricsEndPoint"] = "/metrics";
+        root["bootEndPoint"] = "/boot";
+        root["eventsEndPoint"] = EVENTS_END_POINT;
         response->setLength();
         request->send(response);
       });
@@ -142,11 +440,30 @@ void Webserver :: startServer(){
          cs.getActions(request);
       });
 
+      AsyncCallbackJsonWebHandler* batchHandler = new AsyncCallbackJsonWebHandler("/actions/batch",
+                               [](AsyncWebServerRequest *request, JsonVariant &json){
+         ControllerService cs;
+         cs.postActionBatch(request, json);
+      });
+      server->addHandler(batchHandler);
+
+      //Registered ahead of `/action` as that handler also matches its sub paths
+      server->on("/action/status", HTTP_GET, [](AsyncWebServerRequest *request){
+         ControllerService cs;
+         cs.getActionStatus(request);
+      });
+
       server->on("/action", HTTP_GET, [](AsyncWebServerRequest *request){
          ControllerService cs;
          cs.postAction(request);
       });
 
+      //Registered ahead of `/pairing` as that handler also matches its sub paths
+      server->on("/pairing/status", HTTP_GET, [](AsyncWebServerRequest *request){
+         ControllerService cs;
+         cs.getPairingStatus(request);
+      });
+
       server->on("/pairing", HTTP_GET, [](AsyncWebServerRequest *request){
          ControllerService cs;
          cs.pairDevice(request);
@@ -162,71 +479,40 @@ void Webserver :: startServer(){
          cs.getQRCode(request);
       });
 
+      server->on("/boot", HTTP_GET, [](AsyncWebServerRequest *request){
+         ControllerService cs;
+         cs.getBootRecords(request);
+      });
+
+      server->on("/deadletters", HTTP_GET, [](AsyncWebServerRequest *request){
+         ControllerService cs;
+         cs.getDeadLetterActions(request);
+      });
+
+      server->on("/deadletters", HTTP_DELETE, [](AsyncWebServerRequest *request){
+         ControllerService cs;
+         cs.clearDeadLetterActions(request);
+      });
+
+      server->on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+         ControllerService cs;
+         cs.getMetrics(request);
+      });
+
+      EventService :: getEventServiceInstance()->attach(server);
+
       server->begin();
       serverStatus = STARTED;
+      boot->endPhase(BOOT_PHASE_SERVER_START);
       debugI("\nWebserver :: startServer: BoT Async Webserver started on ESP-32 board at port: %d, \nAccessible using the URL: http://%s:%d/", port,(getBoardIP().toString()).c_str(),port);
 
-      //Device is already paired, then device initialization is skipped
-      //Otherwise waits till device gets paired using FINN APP either by
-      //BLE client connects and key exchanges happen or by QR Code
-      if(isDevicePaired()){
-        debugI("\nWebserver :: startServer: Device is already paired, checking device's state is valid or not");
-        //Below situation occurs when the same device is switched between Multipair and Singlepair
-        //Reset Device State and Initialize
-        if((!store->isDeviceMultipair() && store->getDeviceState() == DEVICE_MULTIPAIR) ||
-           (store->isDeviceMultipair() && store->getDeviceState() != DEVICE_MULTIPAIR))
-        {
-          debugI("\nWebserver :: startServer: Invalid device state, initializing as new device");
-          store->resetDeviceState();
-          store->resetQRCodeStatus();
-          config->initialize();
-          config->configureDevice();
-        }
-        else
-          debugI("\nWebserver :: startServer: Valid device state, no need to initialize and configure");
-      }
-      else {
-        debugI("\nWebserver :: startServer: Device is not paired yet, needs initialization");
-        config->initialize();
-        debugD("\nWebserver :: startServer: Free Heap before BLE Init: %u", ESP.getFreeHeap());
-        ble->initializeBLE();
-        bool bleClientConnected = false;
-        unsigned long startTime = millis();
-        //Wait till device gets paired from FINN APP for 2 mins through BLE
-        do {
-          delay(2000);
-          bleClientConnected = ble->isBLEClientConnected();
-          if(!bleClientConnected)
-            debugI("\nWebserver :: startServer: Waiting for BLE Client to connect...");
-          else
-            debugI("\nWebserver :: startServer: BLE Client connected to BLE Server...");
-        }while(!bleClientConnected && (millis() - startTime)<(2*60*1000));
-
-        //Wait till BLE Client disconnects from BLE Server
-        while(bleClientConnected){
-          debugI("\nWebserver :: startServer: Waiting for BLE Client to disconnect from BLE Server");
-          bleClientConnected = ble->isBLEClientConnected();
-          delay(2000);
-        }
-
-        //Release memory used by BLE Service once BLE Client gets disconnected
-        if(!bleClientConnected) ble->deInitializeBLE();
-        debugD("\nWebserver :: startServer: Free Heap after BLE deInit: %u", ESP.getFreeHeap());
-
-        //If device does not get paired through BLE,
-        //wait now till it gets paired through QR Code if QR Code is available
-        if(store->isQRCodeGeneratedandSaved()){
-          while(!isDevicePaired()){
-            debugI("\nWebserver :: startServer: Waiting for device pairing through QR Code...");
-            delay(2000);
-          }
-          //Proceed with configuring the device
-          config->configureDevice();
-        }
-        else
-          debugW("\nWebserver :: startServer: QR Code not available for the device, try again!!!");
-
-     }
+      //Pairing and activation are driven from provisioning task, startServer returns right away
+      provisioningStartTime = millis();
+      provisioningAttempts = 0;
+      provisioningPolicy = new PollingPolicy(store->getPollingInitialInterval(), store->getPollingMaximumInterval());
+      setProvisioningState(PROVISIONING_CHECK_PAIRED);
+      xTaskCreate(provisioningWorker, "provisioning", PROVISIONING_STACK_SIZE, this,
+                                       PROVISIONING_PRIORITY, &provisioningTask);
    }
    else {
      LOG("\nWebserver :: startServer: ESP-32 board not connected to WiFi Network");
@@ -12,9 +12,28 @@
 #include "ConfigurationService.h"
 #include "BluetoothService.h"
 #include "PairingService.h"
+#include "EventService.h"
+#include "BootOrchestrator.h"
 #define STARTED 1
 #define NOT_STARTED 0
 
+//Provisioning states, advanced in the background while the server keeps serving requests
+#define PROVISIONING_IDLE 0
+#define PROVISIONING_CHECK_PAIRED 1
+#define PROVISIONING_BLE_WAIT 2
+#define PROVISIONING_BLE_CONNECTED 3
+#define PROVISIONING_QR_WAIT 4
+#define PROVISIONING_ACTIVATING 5
+#define PROVISIONING_DONE 6
+#define PROVISIONING_FAILED 7
+#define PROVISIONING_VERIFYING 8
+#define WIFI_RETRY_INITIAL_INTERVAL_IN_MILLISECONDS 1000
+#define WIFI_RETRY_MAXIMUM_INTERVAL_IN_MILLISECONDS 30000
+#define PROVISIONING_TICK_IN_MILLISECONDS 2000
+#define PROVISIONING_BLE_WAIT_IN_MILLISECONDS (2*60*1000)
+#define PROVISIONING_STACK_SIZE 10240
+#define PROVISIONING_PRIORITY 1
+
 class ConfigurationService;
 class Webserver
 {
@@ -27,6 +46,10 @@ class Webserver
     void connectWiFi();
     void startServer();
     IPAddress getBoardIP();
+    byte getProvisioningState();
+    const char* getProvisioningStatusMsg();
+    unsigned long getProvisioningElapsedTime();
+    int getProvisioningAttempts();
   private:
     int port;
     int ledPin;
@@ -39,7 +62,20 @@ class Webserver
     ConfigurationService *config;
     static Webserver *webServer;
     BluetoothService *ble;
+    byte provisioningState;
+    unsigned long provisioningStartTime;
+    unsigned long stateEnteredTime;
+    int provisioningAttempts;
+    TaskHandle_t provisioningTask;
+    PollingPolicy *provisioningPolicy;
     bool isDevicePaired();
+    void associateWiFi(const struct WiFiCache* cache);
+    void updateWiFiCache(const struct WiFiCache* cache);
+    void setProvisioningState(const byte state);
+    byte getConfigureState();
+    void completeBLEPairing();
+    unsigned long advanceProvisioning();
+    static void provisioningWorker(void* param);
     Webserver(bool loadConfig, const char *ssid = NULL, const char *passwd = NULL,
                                                    const int logLevel = BoT_INFO);
 };
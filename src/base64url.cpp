@@ -1,5 +1,6 @@
 // https://raw.githubusercontent.com/zhicheng/base64/master/base64.c
 /* This is a public domain base64 implementation written by WEI Zhicheng. */
+/* Reworked to encode and decode whole blocks per iteration through lookup tables. */
 
 #include <stdio.h>
 
@@ -19,118 +20,108 @@ static const char base64en[] = {
 
 #define BASE64_PAD  '='
 
-
-#define BASE64DE_FIRST  '+'
-#define BASE64DE_LAST 'z'
-/* ASCII order for BASE 64 decode, -1 in unused character */
-static const signed char base64de[] = {
-  /* '+', ',', '-', '.', '/', '0', '1', '2', */ 
-      62,  -1,  -1,  -1,  63,  52,  53,  54,
-
-  /* '3', '4', '5', '6', '7', '8', '9', ':', */
-      55,  56,  57,  58,  59,  60,  61,  -1,
-
-  /* ';', '<', '=', '>', '?', '@', 'A', 'B', */
-      -1,  -1,  -1,  -1,  -1,  -1,   0,   1, 
-
-  /* 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', */
-       2,   3,   4,   5,   6,   7,   8,   9,
-
-  /* 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', */ 
-      10,  11,  12,  13,  14,  15,  16,  17,
-
-  /* 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', */
-      18,  19,  20,  21,  22,  23,  24,  25,
-
-  /* '[', '\', ']', '^', '_', '`', 'a', 'b', */ 
-      -1,  -1,  -1,  -1,  -1,  -1,  26,  27,
-
-  /* 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', */ 
-      28,  29,  30,  31,  32,  33,  34,  35,
-
-  /* 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', */
-      36,  37,  38,  39,  40,  41,  42,  43,
-
-  /* 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', */
-      44,  45,  46,  47,  48,  49,  50,  51,
+#define BASE64DE_INVALID  0xFF
+/* Character to 6 bit value for both alphabets ('-' and '+' are 62, '_' and '/' are 63), BASE64DE_INVALID otherwise */
+static const unsigned char base64de[256] = {
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255,  62, 255,  63,
+   52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 255, 255, 255,
+  255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+   15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255,  63,
+  255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+   41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+  255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
 };
 
-int base64url_encode(const unsigned char *in, unsigned int inlen, char *out)
+int base64url_encode(const unsigned char *in, unsigned int inlen, char *out,
+                     unsigned int outsize, unsigned int *outlen)
 {
   unsigned int i, j;
-
-  for (i = j = 0; i < inlen; i++) {
-    int s = i % 3;      /* from 6/gcd(6, 8) */
-
-    switch (s) {
-    case 0:
-      out[j++] = base64en[(in[i] >> 2) & 0x3F];
-      continue;
-    case 1:
-      out[j++] = base64en[((in[i-1] & 0x3) << 4) + ((in[i] >> 4) & 0xF)];
-      continue;
-    case 2:
-      out[j++] = base64en[((in[i-1] & 0xF) << 2) + ((in[i] >> 6) & 0x3)];
-      out[j++] = base64en[in[i] & 0x3F];
-    }
+  unsigned int len = (inlen / 3) * 4 + ((inlen % 3) ? (inlen % 3) + 1 : 0);
+
+  if (outsize < len + 1)
+    return BASE64_OVERFLOW;
+
+  /* whole blocks, 3 bytes to 4 characters */
+  for (i = j = 0; i + 3 <= inlen; i += 3, j += 4) {
+    unsigned long v = ((unsigned long)in[i] << 16) | ((unsigned long)in[i + 1] << 8) | in[i + 2];
+    out[j]     = base64en[(v >> 18) & 0x3F];
+    out[j + 1] = base64en[(v >> 12) & 0x3F];
+    out[j + 2] = base64en[(v >> 6) & 0x3F];
+    out[j + 3] = base64en[v & 0x3F];
   }
 
-  /* move back */
-  i -= 1;
-
-  /* check the last and add padding */
-    
-  if ((i % 3) == 0) {
+  /* last 1 or 2 bytes, without padding */
+  if (inlen - i == 1) {
+    out[j++] = base64en[in[i] >> 2];
     out[j++] = base64en[(in[i] & 0x3) << 4];
-    //out[j++] = BASE64_PAD;
-    //out[j++] = BASE64_PAD;
-  } else if ((i % 3) == 1) {
-    out[j++] = base64en[(in[i] & 0xF) << 2];
-    //out[j++] = BASE64_PAD;
+  } else if (inlen - i == 2) {
+    out[j++] = base64en[in[i] >> 2];
+    out[j++] = base64en[((in[i] & 0x3) << 4) | (in[i + 1] >> 4)];
+    out[j++] = base64en[(in[i + 1] & 0xF) << 2];
   }
 
-    out[j++] = 0;
+  out[j] = 0;
+  if (outlen != NULL)
+    *outlen = j;
 
   return BASE64_OK;
 }
 
-int base64url_decode(const char *in, unsigned int inlen, unsigned char *out)
+int base64url_decode(const char *in, unsigned int inlen, unsigned char *out,
+                     unsigned int outsize, unsigned int *outlen)
 {
-  unsigned int i, j;
-
-  for (i = j = 0; i < inlen; i++) {
-    int c;
-    int s = i % 4;      /* from 8/gcd(6, 8) */
-
-    if (in[i] == '=')
-      return BASE64_OK;
-
-    if (in[i] < BASE64DE_FIRST || in[i] > BASE64DE_LAST ||
-        (c = base64de[in[i] - BASE64DE_FIRST]) == -1)
+  const unsigned char *s = (const unsigned char *)in;
+  unsigned int i, j, len, tail;
+
+  /* padding is optional, at most two characters of it */
+  if (inlen > 0 && s[inlen - 1] == BASE64_PAD)
+    inlen--;
+  if (inlen > 0 && s[inlen - 1] == BASE64_PAD)
+    inlen--;
+
+  tail = inlen % 4;
+  if (tail == 1)
+    return BASE64_INVALID;
+  len = (inlen / 4) * 3 + (tail ? tail - 1 : 0);
+  if (outsize < len)
+    return BASE64_OVERFLOW;
+
+  /* whole blocks, 4 characters to 3 bytes. All 4 are read before
+   * any byte is written, so out may trail in within the same buffer */
+  for (i = j = 0; i + 4 <= inlen; i += 4, j += 3) {
+    unsigned char a = base64de[s[i]], b = base64de[s[i + 1]];
+    unsigned char c = base64de[s[i + 2]], d = base64de[s[i + 3]];
+    /* BASE64DE_INVALID is the only entry with the top bit set */
+    if ((a | b | c | d) & 0x80)
       return BASE64_INVALID;
+    unsigned long v = ((unsigned long)a << 18) | ((unsigned long)b << 12) | (c << 6) | d;
+    out[j]     = (v >> 16) & 0xFF;
+    out[j + 1] = (v >> 8) & 0xFF;
+    out[j + 2] = v & 0xFF;
+  }
 
-    switch (s) {
-    case 0:
-      out[j] = ((unsigned int)c << 2) & 0xFF;
-      continue;
-    case 1:
-      out[j++] += ((unsigned int)c >> 4) & 0x3;
-
-      /* if not last char with padding */
-      if (i < (inlen - 3) || in[inlen - 2] != '=')
-        out[j] = ((unsigned int)c & 0xF) << 4; 
-      continue;
-    case 2:
-      out[j++] += ((unsigned int)c >> 2) & 0xF;
-
-      /* if not last char with padding */
-      if (i < (inlen - 2) || in[inlen - 1] != '=')
-        out[j] =  ((unsigned int)c & 0x3) << 6;
-      continue;
-    case 3:
-      out[j++] += (unsigned char)c;
-    }
+  /* last 2 or 3 characters */
+  if (tail) {
+    unsigned char a = base64de[s[i]], b = base64de[s[i + 1]];
+    unsigned char c = (tail == 3) ? base64de[s[i + 2]] : 0;
+    if ((a | b | c) & 0x80)
+      return BASE64_INVALID;
+    out[j++] = (a << 2) | (b >> 4);
+    if (tail == 3)
+      out[j++] = ((b & 0xF) << 4) | (c >> 2);
   }
 
+  if (outlen != NULL)
+    *outlen = j;
+
   return BASE64_OK;
 }
@@ -2,14 +2,31 @@
 #ifndef __BASE64URL_H__
 #define __BASE64URL_H__
 
-enum {BASE64_OK = 0, BASE64_INVALID};
+enum {BASE64_OK = 0, BASE64_INVALID, BASE64_OVERFLOW};
 
-#define BASE64_ENCODE_OUT_SIZE(s)  (((s) + 2) / 3 * 4)
-#define BASE64_DECODE_OUT_SIZE(s) (((s)) / 4 * 3)
+/* Exact unpadded length of s bytes once encoded */
+#define BASE64URL_ENCODED_LENGTH(s)  ((((s) * 4) + 2) / 3)
 
-int base64url_encode(const unsigned char *in, unsigned int inlen, char *out);
+/* Buffer sizes, encoded size includes room for the terminating NUL */
+#define BASE64_ENCODE_OUT_SIZE(s)  (BASE64URL_ENCODED_LENGTH(s) + 1)
+#define BASE64_DECODE_OUT_SIZE(s) ((((s) + 3) / 4) * 3)
 
-int base64url_decode(const char *in, unsigned int inlen, unsigned char *out);
+/*
+ * Encodes inlen bytes into unpadded base64url followed by a NUL, 3 bytes per 4 characters.
+ * Returns BASE64_OVERFLOW without writing anything if outsize is too small, otherwise
+ * BASE64_OK with the number of characters (excluding NUL) in *outlen, if not NULL.
+ */
+int base64url_encode(const unsigned char *in, unsigned int inlen, char *out,
+                     unsigned int outsize, unsigned int *outlen);
+
+/*
+ * Decodes base64url or standard base64, padded or not, 4 characters per 3 bytes.
+ * out may be the same buffer as in, to decode in place. Returns BASE64_INVALID for
+ * characters outside both alphabets or a dangling last character, BASE64_OVERFLOW if
+ * outsize is too small, otherwise BASE64_OK with the number of bytes in *outlen, if not NULL.
+ */
+int base64url_decode(const char *in, unsigned int inlen, unsigned char *out,
+                     unsigned int outsize, unsigned int *outlen);
 
 
 #endif /* __BASE64URL_H__ */
@@ -0,0 +1,58 @@
+/*
+  actionAcknowledgement.ino - Example sketch program to check which BoT Service responses acknowledge a
+                              triggered action, with JWT payloads decoded the way BoTService decodes them.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <ActionService.h>
+
+#define QUEUE_ID "0B8F6A3C-1D2E-4F50-8A9B-C0D1E2F30415"
+#define JWT_HEADER "{\"alg\":\"RS256\",\"typ\":\"JWT\"}"
+
+//Response body as BoT Service sends it, header.payload.signature in base64url
+String makeJWT(const char* payload){
+  char encoded[BASE64_ENCODE_OUT_SIZE(256)];
+  base64url_encode((const unsigned char*)JWT_HEADER, strlen(JWT_HEADER), encoded, sizeof(encoded), NULL);
+  String jwt(encoded);
+  base64url_encode((const unsigned char*)payload, strlen(payload), encoded, sizeof(encoded), NULL);
+  jwt += ".";
+  jwt += encoded;
+  jwt += ".c2lnbmF0dXJl";
+  return jwt;
+}
+
+//Same split BoTService does on a 200 response before decoding the "bot" value
+String decodeResponse(const String& jwt){
+  int firstDoTIdx = jwt.indexOf(".");
+  int secDoTIdx = jwt.indexOf(".", firstDoTIdx + 1);
+  String* encodedPayload = new String(jwt.substring(firstDoTIdx + 1, secDoTIdx));
+  String* botValue = BoTService :: decodePayload(encodedPayload);
+  String response = *botValue;
+  delete encodedPayload;
+  delete botValue;
+  return response;
+}
+
+void check(const char* name, const int httpCode, const String& response, const bool expected){
+  bool acknowledged = ActionService :: isActionAcknowledged(httpCode, response, QUEUE_ID);
+  Serial.printf("\n%s %-42s %3d \"%s\" -> %s", acknowledged == expected ? "Passed" : "FAILED", name, httpCode,
+                                         response.c_str(), acknowledged ? "acknowledged" : "not acknowledged");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  check("Accepted action", HTTP_CODE_OK, decodeResponse(makeJWT("{\"bot\":\"OK\"}")), true);
+  check("Echoed queueID", HTTP_CODE_OK,
+        decodeResponse(makeJWT("{\"bot\":\"{\\\"queueID\\\":\\\"" QUEUE_ID "\\\"}\"}")), true);
+  check("Echoed queueID of another action", HTTP_CODE_OK,
+        decodeResponse(makeJWT("{\"bot\":\"{\\\"queueID\\\":\\\"A4C1F2D0-0000-4000-8000-000000000000\\\"}\"}")), false);
+  check("Rejected action", HTTP_CODE_OK, decodeResponse(makeJWT("{\"bot\":\"Action not found\"}")), false);
+  check("Payload without bot value", HTTP_CODE_OK, decodeResponse(makeJWT("{\"status\":\"OK\"}")), false);
+  check("Conflict", HTTP_CODE_CONFLICT, "HTTP POST with endpoint /actions failed with status code: 409", false);
+  check("Server error", HTTP_CODE_INTERNAL_SERVER_ERROR,
+        "HTTP POST with endpoint /actions failed with status code: 500", false);
+  check("Not sent", 0, "Board Not Connected to WiFi...", false);
+}
+
+void loop() {
+}
@@ -42,7 +42,7 @@ void loop() {
   //Proceed further if board connects to WiFi Network
   if(server->isWiFiConnected()){
     //GET Actions for given device from BoT Service
-    if(actService->getActions() != NULL){
+    if(actService->retrieveActions().length() > 0){
       debugI("\nactionService: Actions retrieval from server is success..");
     }
     else {
@@ -51,9 +51,9 @@ void loop() {
 
     //Trigger an action defined with the deviceID
     const char* actionID = "A42ABD19-3226-47AB-8045-8129DBDF117E";
-    String* paymentResponse = actService->triggerAction(actionID);
-    if(paymentResponse != NULL){
-      debugI("\nactionService: Response from triggering action: %s",paymentResponse->c_str());
+    char paymentResponse[ACTION_RESULT_MESSAGE_LENGTH+1];
+    if(actService->triggerAction(actionID, NULL, ACTION_PRIORITY_DEFAULT, NULL, paymentResponse) != ACTION_RESULT_OFFLINE){
+      debugI("\nactionService: Response from triggering action: %s",paymentResponse);
     }
     else {
       debugI("\nactionService: No Response from triggering action, action saved as offline action");
@@ -0,0 +1,112 @@
+/*
+  base64url.ino - Example sketch program to check the block-wise base64url codec with randomized
+                  round trips against mbedtls_base64, and to time it against mbedtls_base64.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <mbedtls/base64.h>
+#include <base64url.h>
+
+#define ROUNDS 2000
+#define MAX_INPUT 600
+#define ITERATIONS 1000
+
+unsigned char input[MAX_INPUT];
+unsigned char decoded[MAX_INPUT];
+char encoded[BASE64_ENCODE_OUT_SIZE(MAX_INPUT) + 4];
+unsigned char reference[BASE64_ENCODE_OUT_SIZE(MAX_INPUT) + 4];
+
+//mbedtls output with the URL alphabet and padding removed
+size_t referenceEncode(const unsigned char* in, size_t inlen){
+  size_t olen = 0;
+  mbedtls_base64_encode(reference, sizeof(reference), &olen, in, inlen);
+  while(olen > 0 && reference[olen - 1] == '=')
+    olen--;
+  for(size_t i = 0; i < olen; i++){
+    if(reference[i] == '+') reference[i] = '-';
+    else if(reference[i] == '/') reference[i] = '_';
+  }
+  reference[olen] = '\0';
+  return olen;
+}
+
+bool roundTrips(){
+  for(int round = 0; round < ROUNDS; round++){
+    unsigned int inlen = random(MAX_INPUT + 1);
+    for(unsigned int i = 0; i < inlen; i++)
+      input[i] = random(256);
+
+    unsigned int outlen = 0;
+    if(base64url_encode(input, inlen, encoded, sizeof(encoded), &outlen) != BASE64_OK ||
+       outlen != referenceEncode(input, inlen) || strcmp(encoded, (char*)reference) != 0){
+      Serial.printf("\nEncode mismatch for %u bytes", inlen);
+      return false;
+    }
+    if(inlen > 0 && base64url_encode(input, inlen, encoded, outlen, NULL) != BASE64_OVERFLOW){
+      Serial.printf("\nEncode did not report overflow for %u bytes", inlen);
+      return false;
+    }
+
+    unsigned int declen = 0;
+    if(base64url_decode(encoded, outlen, decoded, sizeof(decoded), &declen) != BASE64_OK ||
+       declen != inlen || memcmp(decoded, input, inlen) != 0){
+      Serial.printf("\nDecode mismatch for %u bytes", inlen);
+      return false;
+    }
+
+    //In place, the buffer holding the characters receives the bytes
+    if(base64url_decode(encoded, outlen, (unsigned char*)encoded, sizeof(encoded), &declen) != BASE64_OK ||
+       declen != inlen || memcmp(encoded, input, inlen) != 0){
+      Serial.printf("\nIn place decode mismatch for %u bytes", inlen);
+      return false;
+    }
+  }
+
+  const char* invalid[] = {"a", "abcde", "ab!c", "ab c"};
+  for(int i = 0; i < 4; i++){
+    if(base64url_decode(invalid[i], strlen(invalid[i]), decoded, sizeof(decoded), NULL) != BASE64_INVALID){
+      Serial.printf("\nInvalid input accepted: %s", invalid[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+void benchmark(const unsigned int inlen){
+  for(unsigned int i = 0; i < inlen; i++)
+    input[i] = random(256);
+
+  unsigned int outlen = 0;
+  unsigned long start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    base64url_encode(input, inlen, encoded, sizeof(encoded), &outlen);
+  unsigned long encodeTime = micros() - start;
+
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    base64url_decode(encoded, outlen, decoded, sizeof(decoded), NULL);
+  unsigned long decodeTime = micros() - start;
+
+  size_t olen = 0;
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    mbedtls_base64_encode(reference, sizeof(reference), &olen, input, inlen);
+  unsigned long mbedtlsTime = micros() - start;
+
+  Serial.printf("\n%4u bytes: encode %6lu ns, decode %6lu ns, mbedtls encode %6lu ns", inlen,
+                encodeTime * 1000 / ITERATIONS, decodeTime * 1000 / ITERATIONS, mbedtlsTime * 1000 / ITERATIONS);
+}
+
+void setup() {
+  Serial.begin(115200);
+  randomSeed(esp_random());
+
+  Serial.printf("\nRandomized round trips: %s", roundTrips() ? "passed" : "FAILED");
+
+  //JWT header, typical payload and a 2048-bit RS256 signature
+  benchmark(27);
+  benchmark(180);
+  benchmark(256);
+}
+
+void loop() {
+}
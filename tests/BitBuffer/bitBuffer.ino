@@ -0,0 +1,150 @@
+/*
+  bitBuffer.ino - Example sketch program to check the word-packed BitBuffer with randomized appends
+                  against the std::vector<bool> BitBuffer it replaced, and to time building the data
+                  codewords of a device info payload with both.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <vector>
+#include <BitBuffer.hpp>
+
+using qrcodegen::BitBuffer;
+
+#define ROUNDS 500
+#define MAX_APPENDS 120
+#define ITERATIONS 200
+//Data codewords of a version 9 symbol at low error correction, the size of our device info QR Code
+#define DATA_CODEWORDS 232
+#define DEVICE_INFO "{\"deviceID\":\"469908A3-8F6C-46AC-84FA-4CF1570E564B\",\"makerID\":\"5a3b6f1e-27c4-4d8e-9b0a-c2f1d3e4a5b6\"," \
+                    "\"name\":\"BoT-ESP32\",\"publicKey\":\"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/\"}"
+
+//Previous approach, one push_back per bit
+class VectorBitBuffer : public std::vector<bool> {
+  public:
+    void appendBits(uint32_t val, int len){
+      for(int i = len - 1; i >= 0; i--)
+        push_back(((val >> i) & 1) != 0);
+    }
+};
+
+bool sameBits(const BitBuffer& packed, const VectorBitBuffer& reference){
+  if(packed.size() != reference.size())
+    return false;
+  for(size_t i = 0; i < reference.size(); i++)
+    if(packed.getBit(i) != reference[i])
+      return false;
+
+  //Words as the QR encoder copies segment data, bits past the end read as 0s
+  for(size_t i = 0; i < (reference.size() + 31) / 32; i++){
+    uint32_t expected = 0;
+    for(size_t j = i * 32; j < i * 32 + 32; j++)
+      expected = (expected << 1) | ((j < reference.size() && reference[j]) ? 1 : 0);
+    if(packed.getWord(i) != expected)
+      return false;
+  }
+
+  std::vector<uint8_t> bytes = packed.getBytes();
+  if(bytes.size() != (reference.size() + 7) / 8)
+    return false;
+  for(size_t i = 0; i < bytes.size(); i++){
+    uint8_t expected = 0;
+    for(size_t j = i * 8; j < i * 8 + 8; j++)
+      expected = (expected << 1) | ((j < reference.size() && reference[j]) ? 1 : 0);
+    if(bytes[i] != expected)
+      return false;
+  }
+  return true;
+}
+
+bool randomizedAppends(){
+  for(int round = 0; round < ROUNDS; round++){
+    BitBuffer packed, part;
+    VectorBitBuffer reference, referencePart;
+    int appends = random(MAX_APPENDS);
+    for(int i = 0; i < appends; i++){
+      int len = random(32);
+      uint32_t val = (uint32_t)esp_random() & ((1UL << len) - 1);
+      //Every fourth value goes through a second buffer appended later, like segment data
+      if(i % 4 == 3){
+        part.appendBits(val, len);
+        referencePart.appendBits(val, len);
+      }
+      else {
+        packed.appendBits(val, len);
+        reference.appendBits(val, len);
+      }
+    }
+    packed.appendData(part);
+    reference.insert(reference.end(), referencePart.begin(), referencePart.end());
+    if(!sameBits(packed, reference)){
+      Serial.printf("\nMismatch after %d appends in round %d", appends, round);
+      return false;
+    }
+  }
+  return true;
+}
+
+//Byte segment header, data, terminator and pad bytes, then packed into codewords as encodeSegments does
+std::vector<uint8_t> codewordsWithVector(const char* text){
+  VectorBitBuffer segment;
+  for(const char* c = text; *c != '\0'; c++)
+    segment.appendBits((uint8_t)*c, 8);
+
+  VectorBitBuffer bb;
+  bb.appendBits(0x4, 4);
+  bb.appendBits(strlen(text), 8);
+  bb.insert(bb.end(), segment.begin(), segment.end());
+  bb.appendBits(0, 4);
+  bb.appendBits(0, (8 - bb.size() % 8) % 8);
+  for(uint8_t pad = 0xEC; bb.size() < DATA_CODEWORDS * 8; pad ^= 0xEC ^ 0x11)
+    bb.appendBits(pad, 8);
+
+  std::vector<uint8_t> codewords(bb.size() / 8);
+  for(size_t i = 0; i < bb.size(); i++)
+    codewords[i >> 3] |= (bb[i] ? 1 : 0) << (7 - (i & 7));
+  return codewords;
+}
+
+std::vector<uint8_t> codewordsWithWords(const char* text){
+  size_t length = strlen(text);
+  BitBuffer segment(length * 8);
+  for(size_t i = 0; i < length; i++)
+    segment.appendBits((uint8_t)text[i], 8);
+
+  BitBuffer bb(DATA_CODEWORDS * 8);
+  bb.appendBits(0x4, 4);
+  bb.appendBits(length, 8);
+  bb.appendData(segment);
+  bb.appendBits(0, 4);
+  bb.appendBits(0, (8 - bb.size() % 8) % 8);
+  for(uint8_t pad = 0xEC; bb.size() < DATA_CODEWORDS * 8; pad ^= 0xEC ^ 0x11)
+    bb.appendBits(pad, 8);
+  return bb.getBytes();
+}
+
+void benchmark(){
+  bool same = codewordsWithVector(DEVICE_INFO) == codewordsWithWords(DEVICE_INFO);
+
+  unsigned long start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    codewordsWithVector(DEVICE_INFO);
+  unsigned long vectorTime = micros() - start;
+
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    codewordsWithWords(DEVICE_INFO);
+  unsigned long wordsTime = micros() - start;
+
+  Serial.printf("\nDevice info codewords %s: std::vector<bool> %6lu us, word-packed %6lu us",
+                same ? "same" : "DIFFERENT", vectorTime / ITERATIONS, wordsTime / ITERATIONS);
+}
+
+void setup() {
+  Serial.begin(115200);
+  randomSeed(esp_random());
+
+  Serial.printf("\nRandomized appends: %s", randomizedAppends() ? "passed" : "FAILED");
+  benchmark();
+}
+
+void loop() {
+}
@@ -46,9 +46,9 @@ void loop() {
   //Proceed further if board connects to WiFi Network
   if(server->isWiFiConnected()){
     //GET Pairing Status
-    debugI("\nPair Status: %s", bot->get("/pair")->c_str());
+    debugI("\nPair Status: %s", bot->get("/pair").c_str());
     //GET Actions defined in Maker Portal
-    debugI("\nActions: %s", bot->get("/actions")->c_str());
+    debugI("\nActions: %s", bot->get("/actions").c_str());
 
     //Prepare JSON Data to trigger an Action through POST call
     DynamicJsonBuffer jsonBuffer;
@@ -63,7 +63,18 @@ void loop() {
     jsonBuffer.clear();
     debugI("\nMinified JSON Data to trigger Action: %s", payload);
 
-    debugI("\nResponse from triggering action: %s", bot->post("/actions",payload)->c_str());
+    debugI("\nResponse from triggering action: %s", bot->post("/actions",payload).c_str());
+
+    //Dump phase timings of the last call and latency histograms per endpoint
+    const struct RequestTrace* trace = bot->getLastRequestTrace();
+    for(byte phase = 0; phase < REQUEST_PHASES; phase++)
+      debugI("\nLast call phase %s: %u ms", RequestTracer::getPhaseName(phase), trace->phases[phase]);
+    for(byte ep = 0; ep < METRICS_END_POINTS; ep++){
+      const LatencyHistogram* histogram = bot->getLatencyHistogram(RequestTracer::getEndPointName(ep));
+      debugI("\nEndpoint %s: %u calls, %u ms total", RequestTracer::getEndPointName(ep), histogram->getCount(), histogram->getSum());
+      for(byte b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++)
+        debugI("\n  <= %u ms: %u", LatencyHistogram::getBucketBound(b), histogram->getBucketCount(b));
+    }
   }
   else {
   LOG("\nsdkSample: ESP-32 board not connected to WiFi Network, try again");
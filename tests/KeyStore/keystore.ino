@@ -78,6 +78,9 @@ void buildOfflineActionsList(){
     item.offline = 1;
     item.value = 0.0;
     item.timestamp = millis();
+    item.priority = store->getActionPriority(actionIds[i]);
+    item.attempts = 0;
+    item.nextAttemptTime = 0;
 
     if(store->isDeviceMultipair()){
       item.multipair = 1;
@@ -0,0 +1,80 @@
+/*
+  payloadWriter.ino - Example sketch program to compare action payloads written by PayloadWriter
+                      against the ArduinoJson object tree they replace, for output and time.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <ArduinoJson.h>
+#include <PayloadWriter.h>
+
+#define ITERATIONS 1000
+#define DEVICE_ID "469908A3-8F6C-46AC-84FA-4CF1570E564B"
+#define QUEUE_ID "0B8F6A3C-1D2E-4F50-8A9B-C0D1E2F30415"
+
+//Previous approach, object tree in a DynamicJsonBuffer printed into the buffer
+size_t writeWithJsonBuffer(char* payload, const size_t size, const char* actionID, const char* altID, const double value){
+  DynamicJsonBuffer jsonBuffer;
+  JsonObject& doc = jsonBuffer.createObject();
+  JsonObject& botData = doc.createNestedObject("bot");
+  botData["deviceID"] = DEVICE_ID;
+  botData["actionID"] = actionID;
+  botData["queueID"] = QUEUE_ID;
+  if(altID != NULL)
+    botData["alternativeID"] = altID;
+  if(value > 0.0)
+    botData["value"] = value;
+  return doc.printTo(payload, size);
+}
+
+void compare(const char* actionID, const char* altID, const double value){
+  char expected[ACTION_PAYLOAD_BUFFER_SIZE];
+  char payload[ACTION_PAYLOAD_BUFFER_SIZE];
+  writeWithJsonBuffer(expected, sizeof(expected), actionID, altID, value);
+  PayloadWriter writer(payload, sizeof(payload));
+  bool written = writeActionPayload(writer, DEVICE_ID, actionID, QUEUE_ID, altID != NULL, altID, value);
+  Serial.printf("\n%s %3d bytes: %s", (written && strcmp(expected, payload) == 0) ? "Same     " : "DIFFERENT",
+                                                                           writer.length(), payload);
+
+  unsigned long start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    writeWithJsonBuffer(expected, sizeof(expected), actionID, altID, value);
+  unsigned long jsonTime = micros() - start;
+
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++){
+    PayloadWriter timed(payload, sizeof(payload));
+    writeActionPayload(timed, DEVICE_ID, actionID, QUEUE_ID, altID != NULL, altID, value);
+  }
+  unsigned long writerTime = micros() - start;
+  Serial.printf("\n  DynamicJsonBuffer: %6lu ns, PayloadWriter: %6lu ns", jsonTime * 1000 / ITERATIONS, writerTime * 1000 / ITERATIONS);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  compare("A42C67F4-C5E3-4F7A-9A8B-5C1D2E3F4A5B", NULL, 0.0);
+  compare("A42C67F4-C5E3-4F7A-9A8B-5C1D2E3F4A5B", NULL, 12.25);
+  compare("A42C67F4-C5E3-4F7A-9A8B-5C1D2E3F4A5B", "alternate \"quoted\" id", 100.0);
+
+  //Alternate ID that did not fit in the previous 200 bytes buffer
+  String longAltID;
+  for(int i = 0; i < 20; i++)
+    longAltID += "alternate-";
+  compare("A42C67F4-C5E3-4F7A-9A8B-5C1D2E3F4A5B", longAltID.c_str(), 1.5);
+
+  //Exact length is known also when the buffer is too small
+  char small[64];
+  PayloadWriter writer(small, sizeof(small));
+  bool written = writeActionPayload(writer, DEVICE_ID, "A42C67F4-C5E3-4F7A-9A8B-5C1D2E3F4A5B", QUEUE_ID, false, NULL, 1.0);
+  Serial.printf("\nSmall buffer: written %d, needed %d bytes", written, writer.length() + 1);
+
+  //Positive value below the last decimal is not sent as 0
+  PayloadWriter tiny(small, sizeof(small));
+  tiny.number(4e-7);
+  Serial.printf("\nValue 4e-7: %s", tiny.finish() ? "ACCEPTED" : "rejected");
+  PayloadWriter rounded(small, sizeof(small));
+  rounded.number(6e-7);
+  Serial.printf("\nValue 6e-7: %s %s", rounded.finish() ? "accepted" : "REJECTED", small);
+}
+
+void loop() {
+}
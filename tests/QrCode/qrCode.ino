@@ -0,0 +1,110 @@
+/*
+  qrCode.ino - Example sketch program to check QrCode and heap-free QrCodeStatic against known symbols,
+               and QrCodeStatic error codes in place of the QrCode exceptions.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <QrCode.hpp>
+#include <QrCodeStatic.hpp>
+
+using qrcodegen::QrCode;
+using qrcodegen::QrCodeStatic;
+using qrcodegen::QrStatus;
+
+#define DEVICE_INFO "{\"deviceID\":\"469908A3-8F6C-46AC-84FA-4CF1570E564B\",\"makerID\":\"5a3b6f1e-27c4-4d8e-9b0a-c2f1d3e4a5b6\"," \
+                    "\"name\":\"BoT-ESP32\",\"publicKey\":\"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/\"}"
+
+//Symbols from the original std::vector<bool> encoder, modules hashed row by row with FNV-1a
+struct KnownSymbol {
+  const char* text;
+  QrCode::Ecc ecl;
+  int version;
+  int mask;
+  QrCode::Ecc boostedEcl;
+  uint32_t fingerprint;
+};
+
+const KnownSymbol known[] = {
+  {"HELLO WORLD", QrCode::Ecc::QRQUARTILE, 1, 6, QrCode::Ecc::QRQUARTILE, 0xF584476D},
+  {"01234567890123456789", QrCode::Ecc::QRMEDIUM, 1, 6, QrCode::Ecc::QRQUARTILE, 0x4B9BC641},
+  {"https://www.bankingofthings.io", QrCode::Ecc::QRHIGH, 4, 2, QrCode::Ecc::QRHIGH, 0xB08BB17C},
+  {DEVICE_INFO, QrCode::Ecc::QRLOW, 9, 2, QrCode::Ecc::QRLOW, 0x94FCF80F},
+  {"", QrCode::Ecc::QRLOW, 1, 6, QrCode::Ecc::QRHIGH, 0x9501F267}
+};
+
+//Kept in static storage, encoding into them never touches the heap
+QrCodeStatic<23> deviceQR;
+QrCodeStatic<5> smallQR;
+
+template <class Q>
+uint32_t fingerprint(const Q& qr){
+  uint32_t hash = 2166136261UL;
+  for(int y = 0; y < qr.getSize(); y++)
+    for(int x = 0; x < qr.getSize(); x++){
+      hash ^= qr.getModule(x, y) ? 1 : 0;
+      hash *= 16777619UL;
+    }
+  return hash;
+}
+
+template <class Q>
+bool matches(const Q& qr, const KnownSymbol& symbol){
+  return qr.getVersion() == symbol.version && qr.getMask() == symbol.mask &&
+         qr.getErrorCorrectionLevel() == symbol.boostedEcl && fingerprint(qr) == symbol.fingerprint;
+}
+
+void checkKnownSymbols(){
+  for(size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++){
+    QrCode qr = QrCode::encodeText(known[i].text, known[i].ecl);
+    uint32_t freeHeap = ESP.getFreeHeap();
+    QrStatus status = deviceQR.encodeText(known[i].text, known[i].ecl);
+    uint32_t heapUsed = freeHeap - ESP.getFreeHeap();
+    Serial.printf("\nVersion %2d: QrCode %s, QrCodeStatic %s, heap used by QrCodeStatic: %u bytes", known[i].version,
+                  matches(qr, known[i]) ? "same" : "DIFFERENT",
+                  (status == QrStatus::OK && matches(deviceQR, known[i])) ? "same" : "DIFFERENT", heapUsed);
+  }
+
+  //Explicit mask gives the same symbol from both encoders
+  bool same = true;
+  for(int mask = 0; mask < 8; mask++){
+    QrCode qr = QrCode::encodeSegments(qrcodegen::QrSegment::makeSegments("HELLO"), QrCode::Ecc::QRLOW,
+                                       QrCode::MIN_VERSION, QrCode::MAX_VERSION, mask);
+    same = same && deviceQR.encodeText("HELLO", QrCode::Ecc::QRLOW, mask) == QrStatus::OK &&
+           deviceQR.getMask() == mask && fingerprint(deviceQR) == fingerprint(qr);
+  }
+  Serial.printf("\nMasks 0 to 7: %s", same ? "same" : "DIFFERENT");
+}
+
+void checkErrors(){
+  //Device info needs version 9, QrCode throws where QrCodeStatic returns a code and stays empty
+  QrStatus status = smallQR.encodeText(DEVICE_INFO, QrCode::Ecc::QRLOW);
+  Serial.printf("\nQrCodeStatic<5> with device info: %s, size %d",
+                status == QrStatus::DATA_TOO_LONG ? "DATA_TOO_LONG" : "UNEXPECTED", smallQR.getSize());
+
+  String tooLong;
+  for(int i = 0; i < 1300; i++)
+    tooLong += 'x';
+  status = deviceQR.encodeText(tooLong.c_str(), QrCode::Ecc::QRHIGH);
+  Serial.printf("\nQrCodeStatic<23> with 1300 bytes: %s, size %d",
+                status == QrStatus::DATA_TOO_LONG ? "DATA_TOO_LONG" : "UNEXPECTED", deviceQR.getSize());
+  try {
+    QrCode::encodeText(tooLong.c_str(), QrCode::Ecc::QRHIGH);
+    Serial.printf("\nQrCode with 1300 bytes: UNEXPECTED, no exception");
+  }
+  catch(const qrcodegen::data_too_long& e){
+    Serial.printf("\nQrCode with 1300 bytes: data_too_long");
+  }
+
+  status = deviceQR.encodeText("HELLO", QrCode::Ecc::QRLOW, 8);
+  Serial.printf("\nQrCodeStatic<23> with mask 8: %s, size %d",
+                status == QrStatus::INVALID_ARGUMENT ? "INVALID_ARGUMENT" : "UNEXPECTED", deviceQR.getSize());
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.printf("\nQrCodeStatic<23>: %u bytes, QrCodeStatic<5>: %u bytes", sizeof(deviceQR), sizeof(smallQR));
+  checkKnownSymbols();
+  checkErrors();
+}
+
+void loop() {
+}
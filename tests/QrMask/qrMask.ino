@@ -0,0 +1,173 @@
+/*
+  qrMask.ino - Example sketch program to check the mask chosen from packed row bitsets against the
+               std::deque based penalty scoring it replaced, and to time the mask choice of both.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <deque>
+#include <vector>
+#include <climits>
+#include <QrCode.hpp>
+
+using qrcodegen::QrCode;
+using qrcodegen::QrSegment;
+
+#define ROUNDS 40
+#define ITERATIONS 20
+#define PENALTY_N1 3
+#define PENALTY_N2 3
+#define PENALTY_N3 40
+#define PENALTY_N4 10
+#define DEVICE_INFO "{\"deviceID\":\"469908A3-8F6C-46AC-84FA-4CF1570E564B\",\"makerID\":\"5a3b6f1e-27c4-4d8e-9b0a-c2f1d3e4a5b6\"," \
+                    "\"name\":\"BoT-ESP32\",\"publicKey\":\"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/\"}"
+
+typedef std::vector<std::vector<bool> > ModuleGrid;
+
+//Previous approach, module by module over std::vector<bool> rows with a std::deque run history
+void addRunToHistory(int run, std::deque<int>& history){
+  history.pop_back();
+  history.push_front(run);
+}
+
+bool hasFinderLikePattern(const std::deque<int>& runHistory){
+  int n = runHistory.at(1);
+  return n > 0 && runHistory.at(2) == n && runHistory.at(4) == n && runHistory.at(5) == n
+      && runHistory.at(3) == n * 3 && std::max(runHistory.at(0), runHistory.at(6)) >= n * 4;
+}
+
+long getLinePenalty(const ModuleGrid& modules, const int size, const bool columns, const int line){
+  long result = 0;
+  std::deque<int> runHistory(7, 0);
+  bool color = false;
+  int run = 0;
+  for(int i = 0; i < size; i++){
+    bool module = columns ? modules[i][line] : modules[line][i];
+    if(module == color){
+      run++;
+      if(run == 5)
+        result += PENALTY_N1;
+      else if(run > 5)
+        result++;
+    }
+    else {
+      addRunToHistory(run, runHistory);
+      if(!color && hasFinderLikePattern(runHistory))
+        result += PENALTY_N3;
+      color = module;
+      run = 1;
+    }
+  }
+  addRunToHistory(run, runHistory);
+  if(color)
+    addRunToHistory(0, runHistory);
+  if(hasFinderLikePattern(runHistory))
+    result += PENALTY_N3;
+  return result;
+}
+
+long getPenaltyScore(const ModuleGrid& modules){
+  const int size = modules.size();
+  long result = 0;
+  for(int line = 0; line < size; line++)
+    result += getLinePenalty(modules, size, false, line) + getLinePenalty(modules, size, true, line);
+
+  for(int y = 0; y < size - 1; y++)
+    for(int x = 0; x < size - 1; x++){
+      bool color = modules[y][x];
+      if(color == modules[y][x + 1] && color == modules[y + 1][x] && color == modules[y + 1][x + 1])
+        result += PENALTY_N2;
+    }
+
+  int black = 0;
+  for(int y = 0; y < size; y++)
+    for(int x = 0; x < size; x++)
+      if(modules[y][x])
+        black++;
+  int total = size * size;
+  int k = (int)((abs(black * 20L - total * 10L) + total - 1) / total) - 1;
+  return result + k * PENALTY_N4;
+}
+
+//Same data drawn with each of the 8 masks, as the previous encoder scored them
+void getMaskedGrids(const char* text, const QrCode& chosen, ModuleGrid grids[8]){
+  std::vector<QrSegment> segs = QrSegment::makeSegments(text);
+  for(int mask = 0; mask < 8; mask++){
+    QrCode qr = QrCode::encodeSegments(segs, chosen.getErrorCorrectionLevel(), chosen.getVersion(),
+                                       chosen.getVersion(), mask, false);
+    grids[mask].assign(qr.getSize(), std::vector<bool>(qr.getSize()));
+    for(int y = 0; y < qr.getSize(); y++)
+      for(int x = 0; x < qr.getSize(); x++)
+        grids[mask][y][x] = qr.getModule(x, y);
+  }
+}
+
+int chooseMask(const ModuleGrid grids[8]){
+  int mask = 0;
+  long minPenalty = LONG_MAX;
+  for(int i = 0; i < 8; i++){
+    long penalty = getPenaltyScore(grids[i]);
+    if(penalty < minPenalty){
+      mask = i;
+      minPenalty = penalty;
+    }
+  }
+  return mask;
+}
+
+bool randomizedMasks(){
+  static const char alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:abcdefghijklmnopqrstuvwxyz{}\",";
+  ModuleGrid grids[8];
+  for(int round = 0; round < ROUNDS; round++){
+    String text;
+    int length = 1 + random(400);
+    for(int i = 0; i < length; i++)
+      text += alphabet[random(sizeof(alphabet) - 1)];
+    QrCode::Ecc ecl = (QrCode::Ecc)random(4);
+    QrCode qr = QrCode::encodeText(text.c_str(), ecl);
+    getMaskedGrids(text.c_str(), qr, grids);
+    if(chooseMask(grids) != qr.getMask()){
+      Serial.printf("\nMask %d chosen for %d characters at version %d, expected %d", qr.getMask(), length,
+                                                                      qr.getVersion(), chooseMask(grids));
+      return false;
+    }
+  }
+  return true;
+}
+
+void benchmark(const char* text){
+  QrCode qr = QrCode::encodeText(text, QrCode::Ecc::QRLOW);
+  ModuleGrid grids[8];
+  getMaskedGrids(text, qr, grids);
+  std::vector<QrSegment> segs = QrSegment::makeSegments(text);
+
+  unsigned long start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    chooseMask(grids);
+  unsigned long dequeTime = micros() - start;
+
+  //Mask choice of the packed encoder is the difference between automatic and fixed mask encoding
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    QrCode::encodeSegments(segs, QrCode::Ecc::QRLOW);
+  unsigned long automaticTime = micros() - start;
+
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    QrCode::encodeSegments(segs, QrCode::Ecc::QRLOW, QrCode::MIN_VERSION, QrCode::MAX_VERSION, qr.getMask());
+  unsigned long fixedTime = micros() - start;
+
+  Serial.printf("\nVersion %2d mask %d %s: std::deque scoring %6lu us, packed scoring %6lu us, encodeSegments %6lu us",
+                qr.getVersion(), qr.getMask(), chooseMask(grids) == qr.getMask() ? "same" : "DIFFERENT",
+                dequeTime / ITERATIONS, (automaticTime - fixedTime) / ITERATIONS, automaticTime / ITERATIONS);
+}
+
+void setup() {
+  Serial.begin(115200);
+  randomSeed(esp_random());
+
+  Serial.printf("\nRandomized mask choice: %s", randomizedMasks() ? "passed" : "FAILED");
+  benchmark("HELLO WORLD");
+  benchmark(DEVICE_INFO);
+}
+
+void loop() {
+}
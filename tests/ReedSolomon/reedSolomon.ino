@@ -0,0 +1,109 @@
+/*
+  reedSolomon.ino - Example sketch program to check the table based Reed-Solomon ECC of the QR encoder
+                    against the bitwise multiply generator it replaced, and to time both per block.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <vector>
+#include <QrCode.hpp>
+#include <QrMatrix.hpp>
+
+using qrcodegen::QrCode;
+using qrcodegen::QrMatrix;
+using qrcodegen::QrStatus;
+
+#define ROUNDS 2000
+#define MAX_BLOCK_DATA 123
+#define ITERATIONS 200
+
+//Previous approach, divisor computed for each generator and Russian peasant multiplication per term
+class BitwiseReedSolomon {
+  public:
+    BitwiseReedSolomon(int degree) : coefficients(degree){
+      coefficients[degree - 1] = 1;
+      uint8_t root = 1;
+      for(int i = 0; i < degree; i++){
+        for(size_t j = 0; j < coefficients.size(); j++){
+          coefficients[j] = multiply(coefficients[j], root);
+          if(j + 1 < coefficients.size())
+            coefficients[j] ^= coefficients[j + 1];
+        }
+        root = multiply(root, 0x02);
+      }
+    }
+
+    std::vector<uint8_t> getRemainder(const std::vector<uint8_t>& data) const {
+      std::vector<uint8_t> result(coefficients.size());
+      for(uint8_t b : data){
+        uint8_t factor = b ^ result[0];
+        result.erase(result.begin());
+        result.push_back(0);
+        for(size_t j = 0; j < result.size(); j++)
+          result[j] ^= multiply(coefficients[j], factor);
+      }
+      return result;
+    }
+
+  private:
+    std::vector<uint8_t> coefficients;
+
+    static uint8_t multiply(uint8_t x, uint8_t y){
+      int z = 0;
+      for(int i = 7; i >= 0; i--){
+        z = (z << 1) ^ ((z >> 7) * 0x11D);
+        z ^= ((y >> i) & 1) * x;
+      }
+      return (uint8_t)z;
+    }
+};
+
+bool randomizedBlocks(){
+  uint8_t ecc[QrCode::MAX_ECC_CODEWORDS_PER_BLOCK];
+  for(int round = 0; round < ROUNDS; round++){
+    int degree = 1 + random(QrCode::MAX_ECC_CODEWORDS_PER_BLOCK);
+    std::vector<uint8_t> data(random(MAX_BLOCK_DATA + 1));
+    for(size_t i = 0; i < data.size(); i++)
+      data[i] = random(256);
+
+    std::vector<uint8_t> expected = BitwiseReedSolomon(degree).getRemainder(data);
+    if(QrMatrix::getEccCodewords(data.data(), data.size(), degree, ecc) != QrStatus::OK ||
+       memcmp(ecc, expected.data(), degree) != 0){
+      Serial.printf("\nMismatch for %d data codewords at degree %d", (int)data.size(), degree);
+      return false;
+    }
+  }
+  return QrMatrix::getEccCodewords(ecc, 0, 0, ecc) == QrStatus::INVALID_ARGUMENT &&
+         QrMatrix::getEccCodewords(ecc, 0, QrCode::MAX_ECC_CODEWORDS_PER_BLOCK + 1, ecc) == QrStatus::INVALID_ARGUMENT;
+}
+
+//Block of the given shape, e.g. version 9 at low level has 2 blocks of 116 data and 30 ECC codewords
+void benchmark(const int dataLength, const int degree){
+  std::vector<uint8_t> data(dataLength);
+  for(int i = 0; i < dataLength; i++)
+    data[i] = random(256);
+  uint8_t ecc[QrCode::MAX_ECC_CODEWORDS_PER_BLOCK];
+
+  unsigned long start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    BitwiseReedSolomon(degree).getRemainder(data);
+  unsigned long bitwiseTime = micros() - start;
+
+  start = micros();
+  for(int i = 0; i < ITERATIONS; i++)
+    QrMatrix::getEccCodewords(data.data(), dataLength, degree, ecc);
+  unsigned long tableTime = micros() - start;
+
+  Serial.printf("\n%3d data, %2d ECC codewords: bitwise %6lu us, tables %6lu us", dataLength, degree,
+                bitwiseTime / ITERATIONS, tableTime / ITERATIONS);
+}
+
+void setup() {
+  Serial.begin(115200);
+  randomSeed(esp_random());
+
+  Serial.printf("\nRandomized blocks: %s", randomizedBlocks() ? "passed" : "FAILED");
+  benchmark(19, 7);
+  benchmark(116, 30);
+}
+
+void loop() {
+}
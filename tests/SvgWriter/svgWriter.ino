@@ -0,0 +1,100 @@
+/*
+  svgWriter.ino - Example sketch program to compare saving QR Code as SVG byte by byte,
+                  one path per module, against buffered SvgWriter merging horizontal runs.
+  Released into the repository BoT-ESP32-SDK.
+*/
+#include <SPIFFS.h>
+#include <QrCode.hpp>
+#include <SvgWriter.h>
+
+using qrcodegen::QrCode;
+#define BORDER 4
+#define ITERATIONS 5
+#define PER_MODULE_FILE "/qrmodule.svg"
+#define RUN_LENGTH_FILE "/qrrun.svg"
+
+//Previous approach, single byte writes and a String per dark module
+int saveByModule(const QrCode& qr, File& file){
+  const int size = qr.getSize();
+  String svgHeader = String("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+         svgHeader += String("<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n");
+         svgHeader += String("<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" viewBox=\"0 0 ");
+         svgHeader += String((size + BORDER * 2));
+         svgHeader += String(" ");
+         svgHeader += String((size + BORDER * 2));
+         svgHeader += String("\" stroke=\"none\">\n");
+         svgHeader += String("\t<rect width=\"100%\" height=\"100%\" fill=\"#FFFFFF\"/>\n");
+         svgHeader += String("\t<path d=\"");
+  int bytesWritten = 0;
+  const char* bytes = svgHeader.c_str();
+  for(int i=0; bytes[i] != '\0'; i++)
+    bytesWritten += file.write(bytes[i]);
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      if (qr.getModule(x, y)) {
+        if (x != 0 || y != 0)
+          bytesWritten += file.write(' ');
+        String* svgData = new String("M");
+        svgData->concat(x + BORDER);
+        svgData->concat(",");
+        svgData->concat(y + BORDER);
+        svgData->concat("h1v1h-1z");
+        bytes = svgData->c_str();
+        for(int i=0; bytes[i] != '\0'; i++)
+          bytesWritten += file.write(bytes[i]);
+        delete svgData;
+      }
+    }
+  }
+
+  bytes = "\" fill=\"#000000\"/>\n</svg>\n";
+  for(int i=0; bytes[i] != '\0'; i++)
+    bytesWritten += file.write(bytes[i]);
+  return bytesWritten;
+}
+
+void benchmark(const char* text){
+  QrCode qr = QrCode::encodeText(text, QrCode::Ecc::QRLOW);
+  Serial.printf("\nQR Code version %d, size %d", qr.getVersion(), qr.getSize());
+
+  unsigned long moduleTime = 0, runTime = 0;
+  int moduleBytes = 0, runBytes = 0;
+  for(int i=0; i < ITERATIONS; i++){
+    unsigned long start = micros();
+    File file = SPIFFS.open(PER_MODULE_FILE, FILE_WRITE);
+    moduleBytes = saveByModule(qr, file);
+    file.close();
+    moduleTime += micros() - start;
+
+    start = micros();
+    file = SPIFFS.open(RUN_LENGTH_FILE, FILE_WRITE);
+    runBytes = writeQRCodeSVG(qr, BORDER, file);
+    file.close();
+    runTime += micros() - start;
+  }
+
+  Serial.printf("\n  Per module : %6d bytes, %8lu us", moduleBytes, moduleTime / ITERATIONS);
+  Serial.printf("\n  Run length : %6d bytes, %8lu us", runBytes, runTime / ITERATIONS);
+}
+
+void setup() {
+  Serial.begin(115200);
+  if(!SPIFFS.begin(true)){
+    Serial.printf("\nAn Error has occurred while mounting SPIFFS");
+    return;
+  }
+
+  //Device info sized payload and a larger one close to version 10
+  benchmark("{\"deviceID\":\"eb25d0ba-2dcd-4db2-8f96-a4fbe54dbffc\",\"makerID\":\"469908A3-8F6C-46AC-84FA-4CF1570E564B\"}");
+  String large;
+  for(int i=0; i < 270; i++)
+    large += (char)('A' + (i % 26));
+  benchmark(large.c_str());
+
+  SPIFFS.remove(PER_MODULE_FILE);
+  SPIFFS.remove(RUN_LENGTH_FILE);
+}
+
+void loop() {
+}